@@ -0,0 +1,232 @@
+// async_slotshift：异步查询接口的压测。
+// 若干提交线程按固定间隔提交小批量车位线段下标，统计提交到结果就绪的延迟、每批合并的提交数与吞吐；
+// --window-us 可以给多个值，逐个窗口跑一遍，对比延迟与合批效果。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "parking_lot.h"
+#include "shift_async.h"
+#include "tool_stats.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    int slots = 2000; // 停车场规模 (车位数)
+    uint64_t seed = 1;
+    std::vector<int> windowsUs{0, 50, 200, 1000};
+    int maxBatch = 16384;
+    unsigned threads = 1;
+    int submitters = 8;
+    int requestSegments = 16;
+    int intervalUs = 100; // 每个提交线程两次提交之间的间隔，0 表示收到结果后立即再提交
+    double seconds = 2.0;
+    double updateHz = 0.0; // 世界快照的更新频率，0 表示世界静止
+    bool callbacks = false;
+    bool verify = false;
+};
+
+void usage(const char* argv0) {
+    std::printf("usage: %s [--slots N] [--seed N] [--window-us A,B,...] [--max-batch N] [--threads N]\n"
+                "          [--submitters N] [--request N] [--interval-us N] [--seconds S] [--update-hz F]\n"
+                "          [--callbacks] [--verify]\n",
+                argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", a.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--slots") {
+            opt.slots = std::max(1, std::atoi(next()));
+        } else if (a == "--seed") {
+            opt.seed = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--window-us") {
+            opt.windowsUs.clear();
+            std::stringstream list(next());
+            std::string item;
+            while (std::getline(list, item, ',')) opt.windowsUs.push_back(std::max(0, std::atoi(item.c_str())));
+        } else if (a == "--max-batch") {
+            opt.maxBatch = std::max(1, std::atoi(next()));
+        } else if (a == "--threads") {
+            opt.threads = (unsigned)std::atoi(next());
+        } else if (a == "--submitters") {
+            opt.submitters = std::max(1, std::atoi(next()));
+        } else if (a == "--request") {
+            opt.requestSegments = std::max(1, std::atoi(next()));
+        } else if (a == "--interval-us") {
+            opt.intervalUs = std::max(0, std::atoi(next()));
+        } else if (a == "--seconds") {
+            opt.seconds = std::max(0.1, std::atof(next()));
+        } else if (a == "--update-hz") {
+            opt.updateHz = std::max(0.0, std::atof(next()));
+        } else if (a == "--callbacks") {
+            opt.callbacks = true;
+        } else if (a == "--verify") {
+            opt.verify = true;
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.windowsUs.empty() || (opt.verify && opt.updateHz > 0.0)) {
+        usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+AsyncWorld makeWorld(const ParkingLot& lot, const std::shared_ptr<const std::vector<Segment>>& segments) {
+    AsyncWorld w;
+    w.obstacles = std::make_shared<ObstacleSet>(lot.obstacles);
+    w.segments = segments;
+    w.margin = lot.config.margin;
+    w.detectionRange = lot.config.detectionRange;
+    return w;
+}
+
+struct SubmitterResult {
+    std::vector<double> latencyUs;
+    uint64_t failures = 0;
+    uint64_t mismatches = 0;
+};
+
+// 一个提交线程：提交后用 future 等待 (或用回调 + 条件变量)，模拟调用方拿到结果后继续工作
+void submitter(const Options& opt, AsyncShiftService& service, int queue, size_t segmentCount,
+               const std::vector<double>& reference, int id, Clock::time_point deadline, SubmitterResult& out) {
+    std::mt19937 rng((uint32_t)(opt.seed * 7919 + (uint64_t)id));
+    std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)segmentCount - 1);
+    Clock::time_point nextSubmit = Clock::now();
+    std::mutex m;
+    std::condition_variable cv;
+    while (Clock::now() < deadline) {
+        std::vector<uint32_t> indices((size_t)opt.requestSegments);
+        for (uint32_t& idx : indices) idx = pick(rng);
+        const std::vector<uint32_t> asked = indices;
+
+        const Clock::time_point t0 = Clock::now();
+        AsyncShiftResult r;
+        if (opt.callbacks) {
+            bool ready = false;
+            service.submitSlots(queue, std::move(indices), [&](AsyncShiftResult&& done) {
+                std::lock_guard<std::mutex> lock(m);
+                r = std::move(done);
+                ready = true;
+                cv.notify_one();
+            });
+            std::unique_lock<std::mutex> lock(m);
+            cv.wait(lock, [&ready]() { return ready; });
+        } else {
+            r = service.submitSlots(queue, std::move(indices)).get();
+        }
+        out.latencyUs.push_back(std::chrono::duration<double, std::micro>(Clock::now() - t0).count());
+        if (!r.ok) {
+            ++out.failures;
+        } else if (!reference.empty()) {
+            for (size_t i = 0; i < asked.size(); ++i) out.mismatches += r.shifts[i] != reference[asked[i]];
+        }
+
+        if (opt.intervalUs > 0) {
+            nextSubmit += std::chrono::microseconds(opt.intervalUs);
+            std::this_thread::sleep_until(nextSubmit);
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+
+    ParkingLot lot = generateParkingLot(lotConfig(opt.slots, opt.seed));
+    const std::shared_ptr<const std::vector<Segment>> segments = std::make_shared<std::vector<Segment>>(lot.segments);
+    std::vector<double> reference;
+    if (opt.verify) {
+        reference.resize(lot.segments.size());
+        calculateSegmentShiftBatch(lot.segments.data(), lot.segments.size(), lot.obstacles, lot.config.margin,
+                                   lot.config.detectionRange, reference.data());
+    }
+
+    AsyncShiftService service;
+    service.setWorld(makeWorld(lot, segments));
+    std::printf("%d submitters x %d indices every %d us, %s, %.1f s per window, world updates %.1f Hz\n",
+                opt.submitters, opt.requestSegments, opt.intervalUs, opt.callbacks ? "callbacks" : "futures",
+                opt.seconds, opt.updateHz);
+    std::printf("%10s %10s %12s %10s %10s %10s %10s %10s\n", "window_us", "req/s", "req/batch", "p50_us",
+                "p99_us", "p99.9_us", "max_us", "kernel_s");
+
+    int rc = 0;
+    for (int windowUs : opt.windowsUs) {
+        AsyncQueueConfig qc;
+        qc.windowUs = windowUs;
+        qc.maxBatchSegments = (size_t)opt.maxBatch;
+        qc.threads = opt.threads;
+        const int queue = service.createQueue(qc);
+
+        std::atomic<bool> running{true};
+        std::thread updater;
+        if (opt.updateHz > 0.0) {
+            // 模拟感知更新：推进行人后整体替换快照，提交线程不受影响
+            updater = std::thread([&]() {
+                const double dt = 1.0 / opt.updateHz;
+                while (running.load()) {
+                    std::this_thread::sleep_for(std::chrono::duration<double>(dt));
+                    advancePedestrians(lot, dt);
+                    service.setWorld(makeWorld(lot, segments));
+                }
+            });
+        }
+
+        std::vector<SubmitterResult> results((size_t)opt.submitters);
+        std::vector<std::thread> workers;
+        const Clock::time_point start = Clock::now();
+        const Clock::time_point deadline =
+            start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.seconds));
+        for (int s = 0; s < opt.submitters; ++s) {
+            workers.emplace_back([&, s]() {
+                submitter(opt, service, queue, lot.segments.size(), reference, s, deadline, results[(size_t)s]);
+            });
+        }
+        for (std::thread& t : workers) t.join();
+        const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+        running.store(false);
+        if (updater.joinable()) updater.join();
+
+        std::vector<double> latency;
+        uint64_t failures = 0, mismatches = 0;
+        for (const SubmitterResult& r : results) {
+            latency.insert(latency.end(), r.latencyUs.begin(), r.latencyUs.end());
+            failures += r.failures;
+            mismatches += r.mismatches;
+        }
+        const AsyncQueueStats st = service.stats(queue);
+        std::printf("%10d %10.0f %12.2f %10.1f %10.1f %10.1f %10.1f %10.3f\n", windowUs, latency.size() / wall,
+                    st.batches ? (double)st.submissions / st.batches : 0.0, percentile(latency, 0.5),
+                    percentile(latency, 0.99), percentile(latency, 0.999), percentile(latency, 1.0),
+                    st.kernelSeconds);
+        if (failures || mismatches) {
+            std::printf("  window %d us: %llu failed submissions, %llu mismatches\n", windowUs,
+                        (unsigned long long)failures, (unsigned long long)mismatches);
+            rc = 1;
+        }
+    }
+    if (opt.verify && rc == 0) std::printf("verify: all results match the reference kernel\n");
+    return rc;
+}
@@ -0,0 +1,634 @@
+// bench_slotshift：对 calculateSegmentShift 及其各优化变体做规模扫描基准测试。
+// 不依赖 raylib，场景由固定种子生成，每个测点先预热再重复测量，报告中位数与分位数。
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+#ifdef __linux__
+#include <sched.h>
+#endif
+
+#include "obstacle_diff.h"
+#include "occupancy_grid.h"
+#include "parking_lot.h"
+#include "recording.h"
+#include "scenario.h"
+#include "shift_publisher.h"
+#include "shift_variants.h"
+#include "slot_shift.h"
+#include "slot_tracker.h"
+#include "tool_stats.h"
+#include "trace.h"
+
+namespace {
+
+// --- 场景 ---
+struct SweepPoint {
+    int polygons;
+    int verticesPerPoly;
+    int segments;
+    double detectionRange;
+    double bandFraction; // 落在所属线段探测带内的多边形比例
+    int lotSlots;        // >0 时改用 generateParkingLot 生成整片停车场，忽略上面的参数
+};
+
+// 生成的场景自己持有数据；录制帧的 obstacles / segments 直接指向映射区，不做拷贝
+struct BenchScene {
+    std::vector<std::vector<Vec2>> allWorld;
+    ObstacleSet obstacleStorage;
+    std::vector<Segment> segmentStorage;
+    ObstacleView obstacles;
+    const Segment* segments = nullptr;
+    size_t segmentCount = 0;
+    double margin;
+    double detectionRange;
+
+    // 让视图指向自己持有的数据
+    void bindStorage() {
+        obstacles = obstacleStorage;
+        segments = segmentStorage.data();
+        segmentCount = segmentStorage.size();
+    }
+};
+
+const double kSegLength = 300.0;
+const double kSegGap = 200.0;
+const double kMargin = 30.0;
+const double kPolyRadius = 8.0;
+const uint64_t kSeed = 0x5107517f7u;
+
+// 线段沿 y 轴竖直排成一列，推离方向均为 +x。
+// 每个多边形随机归属一条线段：以 bandFraction 的概率放进该线段的探测带内，
+// 否则放在探测带右侧 (超出 detectionRange)，这部分正好可以被包围盒剔除。
+BenchScene makeSyntheticScene(const SweepPoint& p) {
+    ScenarioRng rng(kSeed);
+    BenchScene s;
+    s.margin = kMargin;
+    s.detectionRange = p.detectionRange;
+
+    for (int k = 0; k < p.segments; ++k) {
+        double y0 = k * (kSegLength + kSegGap);
+        s.segmentStorage.push_back({{0, y0}, {0, y0 + kSegLength}, {1, 0}});
+    }
+
+    const double pad = kPolyRadius * 1.4 + 1.0;
+    s.allWorld.reserve(p.polygons);
+    for (int i = 0; i < p.polygons; ++i) {
+        ScenarioRng poly = rng.substream(i);
+        double y0 = poly.uniformInt(0, p.segments - 1) * (kSegLength + kSegGap);
+        double cy = y0 + pad + poly.uniform() * (kSegLength - 2 * pad);
+        double cx;
+        if (poly.uniform() < p.bandFraction) {
+            cx = -kMargin + pad + poly.uniform() * std::max(0.0, p.detectionRange + kMargin - 2 * pad);
+        } else {
+            cx = p.detectionRange + pad + poly.uniform() * 500.0;
+        }
+        s.allWorld.push_back(createStarPolygon(poly, {cx, cy}, p.verticesPerPoly, kPolyRadius));
+    }
+    s.obstacleStorage = buildObstacleSet(s.allWorld);
+    s.bindStorage();
+    return s;
+}
+
+// 整片停车场：每排 50 个车位，车位的两条侧边都参与计算
+BenchScene makeLotScene(const SweepPoint& p) {
+    LotConfig cfg = lotConfig(p.lotSlots, kSeed);
+    cfg.pedestrians = 20; // 与历次基准结果保持同一场景
+    ParkingLot lot = generateParkingLot(cfg);
+
+    BenchScene s;
+    s.margin = cfg.margin;
+    s.detectionRange = cfg.detectionRange;
+    s.segmentStorage = std::move(lot.segments);
+    s.allWorld = std::move(lot.allWorld);
+    s.obstacleStorage = std::move(lot.obstacles);
+    s.bindStorage();
+    return s;
+}
+
+BenchScene makeScene(const SweepPoint& p) {
+    return p.lotSlots > 0 ? makeLotScene(p) : makeSyntheticScene(p);
+}
+
+// --- 变体 ---
+volatile uint64_t g_statsSink = 0;
+
+struct Variant {
+    const char* name;
+    std::function<void(const BenchScene&, double*)> run;
+};
+
+std::vector<Variant> makeVariants(unsigned threads) {
+    std::vector<Variant> v;
+    for (const ShiftVariant& sv : shiftVariants()) {
+        const ShiftVariant* variant = &sv;
+        v.push_back({sv.name, [variant, threads](const BenchScene& s, double* out) {
+            ShiftProblem p;
+            p.segments = s.segments;
+            p.segmentCount = s.segmentCount;
+            p.obstacles = s.obstacles;
+            p.polygons = &s.allWorld;
+            p.margin = s.margin;
+            p.detectionRange = s.detectionRange;
+            p.threads = threads;
+            variant->run(p, out);
+        }});
+    }
+    // 统计开销：与上面不带统计的同名变体对比。SLOTSHIFT_STATS=OFF 编译时两者应无差别
+    v.push_back({"soa_stats", [](const BenchScene& s, double* out) {
+        ShiftStats stats;
+        for (size_t i = 0; i < s.segmentCount; ++i)
+            out[i] = calculateSegmentShiftSoA(s.segments[i], s.obstacles, s.margin, s.detectionRange, stats);
+        g_statsSink = g_statsSink + stats.bandHits;
+    }});
+    v.push_back({"batch_stats", [](const BenchScene& s, double* out) {
+        ShiftStats stats;
+        calculateSegmentShiftBatch(s.segments, s.segmentCount, s.obstacles, s.margin, s.detectionRange, out,
+                                   stats);
+        g_statsSink = g_statsSink + stats.bandHits;
+    }});
+    v.push_back({"batch_mt_stats", [threads](const BenchScene& s, double* out) {
+        ShiftStats stats;
+        calculateSegmentShiftBatchParallel(s.segments, s.segmentCount, s.obstacles, s.margin,
+                                           s.detectionRange, out, threads, stats);
+        g_statsSink = g_statsSink + stats.bandHits;
+    }});
+    return v;
+}
+
+// --- 计时 ---
+struct Options {
+    int reps = 15;
+    double minRepSeconds = 0.02;
+    double warmupSeconds = 0.05;
+    bool quick = false;
+    bool csv = false;
+    int pinCpu = -1;
+    unsigned threads = 0;
+    std::string sweep;   // 为空表示全部扫描维度
+    std::string variant; // 为空表示全部变体
+    std::string recording; // 非空时改为在录制文件的帧上测量，见 runRecording
+    int recordingFrames = 4;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+double secondsSince(Clock::time_point t0) {
+    return std::chrono::duration<double>(Clock::now() - t0).count();
+}
+
+volatile double g_sink = 0.0;
+
+struct Measurement {
+    double nsPerVertexP10, nsPerVertexMedian, nsPerVertexP90;
+    double verticesPerSecond;
+    double segmentsPerSecond;
+    long itersPerRep;
+};
+
+Measurement measure(const Variant& v, const BenchScene& s, const Options& opt) {
+    std::vector<double> out(s.segmentCount);
+    auto runOnce = [&] {
+        v.run(s, out.data());
+        double sum = 0.0;
+        for (double x : out) sum += x;
+        g_sink = g_sink + sum;
+    };
+
+    // 预热，同时确定单次重复需要多少次调用才能超过 minRepSeconds
+    Clock::time_point t0 = Clock::now();
+    long calls = 0;
+    do {
+        runOnce();
+        ++calls;
+    } while (secondsSince(t0) < opt.warmupSeconds);
+    double perCall = secondsSince(t0) / calls;
+    long iters = std::max(1L, (long)std::ceil(opt.minRepSeconds / perCall));
+
+    const double work = (double)s.segmentCount * (double)s.obstacles.vertexCount();
+    std::vector<double> nsPerVertex;
+    std::vector<double> seconds;
+    for (int r = 0; r < opt.reps; ++r) {
+        Clock::time_point t = Clock::now();
+        for (long i = 0; i < iters; ++i) runOnce();
+        double dt = secondsSince(t);
+        seconds.push_back(dt);
+        nsPerVertex.push_back(dt * 1e9 / (iters * work));
+    }
+
+    Measurement m;
+    m.nsPerVertexP10 = percentile(nsPerVertex, 0.10);
+    m.nsPerVertexMedian = percentile(nsPerVertex, 0.50);
+    m.nsPerVertexP90 = percentile(nsPerVertex, 0.90);
+    double medSeconds = percentile(seconds, 0.50) / iters;
+    m.verticesPerSecond = work / medSeconds;
+    m.segmentsPerSecond = s.segmentCount / medSeconds;
+    m.itersPerRep = iters;
+    return m;
+}
+
+// 所有变体在当前场景上必须与参考实现逐位一致
+bool verify(const std::vector<Variant>& variants, const BenchScene& s) {
+    std::vector<double> expected(s.segmentCount);
+    variants[0].run(s, expected.data());
+    std::vector<double> got(s.segmentCount);
+    bool ok = true;
+    for (size_t k = 1; k < variants.size(); ++k) {
+        variants[k].run(s, got.data());
+        for (size_t i = 0; i < got.size(); ++i) {
+            if (got[i] != expected[i]) {
+                std::fprintf(stderr, "MISMATCH %s seg %zu: %.17g vs reference %.17g\n", variants[k].name, i, got[i],
+                             expected[i]);
+                ok = false;
+                break;
+            }
+        }
+    }
+    return ok;
+}
+
+// --- 扫描 ---
+struct Sweep {
+    const char* name;
+    std::vector<SweepPoint> points;
+};
+
+std::vector<Sweep> makeSweeps(bool quick) {
+    const SweepPoint base = {1000, 16, 64, 600.0, 0.1, 0};
+    std::vector<Sweep> sweeps;
+
+    Sweep polys = {"polygons", {}};
+    for (int n : quick ? std::vector<int>{100, 1000, 10000} : std::vector<int>{100, 1000, 10000, 100000}) {
+        SweepPoint p = base;
+        p.polygons = n;
+        polys.points.push_back(p);
+    }
+    sweeps.push_back(polys);
+
+    Sweep verts = {"vertices", {}};
+    for (int n : quick ? std::vector<int>{4, 16, 64} : std::vector<int>{4, 16, 64, 256}) {
+        SweepPoint p = base;
+        p.verticesPerPoly = n;
+        verts.points.push_back(p);
+    }
+    sweeps.push_back(verts);
+
+    Sweep segs = {"segments", {}};
+    for (int n : quick ? std::vector<int>{1, 16, 256} : std::vector<int>{1, 16, 256, 4096}) {
+        SweepPoint p = base;
+        p.segments = n;
+        segs.points.push_back(p);
+    }
+    sweeps.push_back(segs);
+
+    Sweep range = {"range", {}};
+    for (double r : {50.0, 200.0, 600.0, 2000.0}) {
+        SweepPoint p = base;
+        p.detectionRange = r;
+        range.points.push_back(p);
+    }
+    sweeps.push_back(range);
+
+    Sweep band = {"band", {}};
+    for (double f : {0.0, 0.1, 0.5, 1.0}) {
+        SweepPoint p = base;
+        p.bandFraction = f;
+        band.points.push_back(p);
+    }
+    sweeps.push_back(band);
+
+    Sweep lot = {"lot", {}};
+    for (int n : quick ? std::vector<int>{200, 1000} : std::vector<int>{200, 1000, 4000}) {
+        SweepPoint p = base;
+        p.lotSlots = n;
+        p.bandFraction = NAN; // 停车场场景没有人为设定的探测带比例
+        lot.points.push_back(p);
+    }
+    sweeps.push_back(lot);
+    return sweeps;
+}
+
+// 带统计变体相对不带统计变体的 p50 比值
+void printStatsOverhead(const std::vector<std::pair<std::string, double>>& medians) {
+    std::string line;
+    for (const auto& withStats : medians) {
+        const std::string& name = withStats.first;
+        const std::string suffix = "_stats";
+        if (name.size() <= suffix.size() || name.compare(name.size() - suffix.size(), suffix.size(), suffix) != 0)
+            continue;
+        std::string base = name.substr(0, name.size() - suffix.size());
+        if (base == "soa") base = "soa_cull";
+        for (const auto& plain : medians) {
+            if (plain.first == base && plain.second > 0) {
+                char buf[96];
+                std::snprintf(buf, sizeof(buf), "  %s/%s=%.3f", name.c_str(), base.c_str(), withStats.second / plain.second);
+                line += buf;
+            }
+        }
+    }
+    if (!line.empty()) std::printf("%-10s%s (SLOTSHIFT_ENABLE_STATS=%d)\n", "overhead", line.c_str(), SLOTSHIFT_ENABLE_STATS);
+}
+
+// 单个追踪作用域的平均开销：运行时关闭 (只有一次原子读) 与开启 (取两次时间戳并写缓冲区)
+void printTraceOverhead() {
+#if SLOTSHIFT_ENABLE_TRACE
+    const int kScopes = 200000;
+    double ns[2];
+    for (int enabled = 0; enabled < 2; ++enabled) {
+        traceReset();
+        traceEnable(enabled != 0);
+        Clock::time_point t0 = Clock::now();
+        for (int i = 0; i < kScopes; ++i) {
+            SLOTSHIFT_TRACE_SCOPE("bench_trace_overhead");
+        }
+        ns[enabled] = secondsSince(t0) * 1e9 / kScopes;
+    }
+    traceEnable(false);
+    traceReset();
+    std::printf("trace scope: %.1f ns enabled, %.1f ns runtime-disabled\n", ns[1], ns[0]);
+#else
+    std::printf("trace scope: compiled out\n");
+#endif
+}
+
+// 发布一整组结果与读取最新快照的开销 (单线程，不含竞争)
+void printPublishOverhead() {
+    const size_t kSegments = 4000;
+    const int kRounds = 2000;
+    ShiftPublisher publisher(kSegments);
+    std::vector<double> target(kSegments, 1.0), current(kSegments, 0.5);
+    ShiftSnapshot snap;
+    Clock::time_point t0 = Clock::now();
+    for (int i = 0; i < kRounds; ++i) publisher.publish((uint64_t)i, 0, target.data(), current.data());
+    double publishNs = secondsSince(t0) * 1e9 / kRounds;
+    t0 = Clock::now();
+    for (int i = 0; i < kRounds; ++i) publisher.readLatest(snap);
+    double readNs = secondsSince(t0) * 1e9 / kRounds;
+    g_sink = g_sink + snap.current[0];
+    std::printf("shift publish: %.2f us per %zu-segment snapshot, read latest %.2f us\n", publishNs * 1e-3, kSegments,
+                readNs * 1e-3);
+}
+
+// 增量追踪每帧的开销：行人数固定、停车场规模增大时，追踪器应基本不变，整体批量则线性增长
+void printTrackerScaling(bool quick) {
+    const int kFrames = 20;
+    const double dt = 1.0 / 60.0;
+    std::printf("\n== tracker: %d moving pedestrians per frame ==\n", 20);
+    std::printf("%8s %9s | %12s %12s %12s | %10s %10s %10s\n", "slots", "segments", "batch us", "tracker us",
+                "diff us", "recomputed", "scanned", "reused");
+    for (int slots : quick ? std::vector<int>{1000, 4000} : std::vector<int>{1000, 4000, 16000}) {
+        LotConfig cfg = lotConfig(slots, kSeed);
+        cfg.pedestrians = 20; // 行人数固定，只让停车场规模变化
+        ParkingLot lot = generateParkingLot(cfg);
+
+        SlotTrackerConfig tc;
+        tc.margin = cfg.margin;
+        tc.detectionRange = cfg.detectionRange;
+        SlotTracker tracker;
+        tracker.reset(lot.segments, tc);
+        for (size_t p = 0; p < lot.allWorld.size(); ++p) tracker.addObstacle(p, lot.allWorld[p]);
+        tracker.update();
+        // 另一条路径：感知每帧重发完整列表，由 ObstacleFrameDiff 按 id 找出变化的多边形
+        SlotTracker diffTracker;
+        diffTracker.reset(lot.segments, tc);
+        ObstacleFrameDiff diff;
+        std::vector<uint64_t> ids(lot.obstacles.polygonCount());
+        for (size_t p = 0; p < ids.size(); ++p) ids[p] = p;
+        diff.apply(lot.obstacles, ids.data(), diffTracker);
+        diffTracker.update();
+
+        std::vector<double> out(lot.segments.size());
+        double batchSeconds = 0.0, trackerSeconds = 0.0, diffSeconds = 0.0;
+        uint64_t recomputed = 0, scanned = 0, reused = 0;
+        for (int f = 0; f < kFrames; ++f) {
+            advancePedestrians(lot, dt);
+            Clock::time_point t0 = Clock::now();
+            calculateSegmentShiftBatch(lot.segments.data(), lot.segments.size(), lot.obstacles, cfg.margin,
+                                       cfg.detectionRange, out.data());
+            batchSeconds += secondsSince(t0);
+            t0 = Clock::now();
+            for (size_t k = 0; k < lot.pedestrians.size(); ++k) {
+                const size_t p = lot.staticPolygonCount + k;
+                tracker.moveObstacle(p, lot.allWorld[p]);
+            }
+            tracker.update();
+            trackerSeconds += secondsSince(t0);
+            recomputed += tracker.lastStats().segmentsRecomputed;
+            scanned += tracker.lastStats().obstaclesScanned;
+            reused += tracker.lastStats().contributionsReused;
+            t0 = Clock::now();
+            diff.apply(lot.obstacles, ids.data(), diffTracker);
+            diffTracker.update();
+            diffSeconds += secondsSince(t0);
+        }
+        if (tracker.targets() != out) std::fprintf(stderr, "MISMATCH tracker vs batch at %d slots\n", slots);
+        if (diffTracker.targets() != out) std::fprintf(stderr, "MISMATCH diff vs batch at %d slots\n", slots);
+        std::printf("%8d %9zu | %12.1f %12.1f %12.1f | %10.1f %10.1f %10.1f\n", slots, lot.segments.size(),
+                    batchSeconds * 1e6 / kFrames, trackerSeconds * 1e6 / kFrames, diffSeconds * 1e6 / kFrames,
+                    (double)recomputed / kFrames, (double)scanned / kFrames, (double)reused / kFrames);
+    }
+}
+
+// 占用栅格输入：停车场栅格化 (1 格 = 2 单位，按 parking_lot.h 的 1 单位 = 0.1 m 即 0.2 m) 后，对比“逐格转多边形再跑批量内核”与直接在位图上扫描
+void printGridScaling(bool quick) {
+    const double cell = 2.0;
+    std::printf("\n== grid: rasterized lot, cell %.1f ==\n", cell);
+    std::printf("%8s %9s %9s | %12s %12s | %8s %8s %8s\n", "slots", "segments", "occupied", "polygons us",
+                "grid us", "row", "column", "raster");
+    // 逐格转多边形的路径随占用格数线性变慢，规模比其他扫描小一档
+    for (int slots : quick ? std::vector<int>{250, 1000} : std::vector<int>{1000, 4000}) {
+        const LotConfig cfg = lotConfig(slots, kSeed);
+        const ParkingLot lot = generateParkingLot(cfg);
+        OccupancyGrid grid;
+        grid.reset((int32_t)std::ceil((lot.extent.maxX - lot.extent.minX) / cell) + 1,
+                   (int32_t)std::ceil((lot.extent.maxY - lot.extent.minY) / cell) + 1, cell,
+                   {lot.extent.minX, lot.extent.minY});
+        rasterizePolygons(lot.allWorld, grid);
+
+        const size_t n = lot.segments.size();
+        std::vector<double> viaPolygons(n), direct(n);
+        Clock::time_point t0 = Clock::now();
+        const ObstacleSet set = buildObstacleSet(occupancyPolygons(grid));
+        calculateSegmentShiftBatch(lot.segments.data(), n, set, cfg.margin, cfg.detectionRange, viaPolygons.data());
+        const double polygonSeconds = secondsSince(t0);
+        GridShiftStats stats;
+        t0 = Clock::now();
+        calculateSegmentShiftGridBatch(lot.segments.data(), n, grid, cfg.margin, cfg.detectionRange, direct.data(),
+                                       stats);
+        const double gridSeconds = secondsSince(t0);
+        if (viaPolygons != direct) std::fprintf(stderr, "MISMATCH grid vs polygons at %d slots\n", slots);
+        std::printf("%8d %9zu %9zu | %12.1f %12.1f | %8llu %8llu %8llu\n", slots, n, grid.occupiedCount(),
+                    polygonSeconds * 1e6, gridSeconds * 1e6, (unsigned long long)stats.segmentsRowScan,
+                    (unsigned long long)stats.segmentsColumnScan, (unsigned long long)stats.segmentsRasterized);
+    }
+}
+
+void usage(const char* argv0) {
+    std::printf("usage: %s [--quick] [--csv] [--reps N] [--min-rep-ms MS] [--warmup-ms MS]\n"
+                "          [--sweep polygons|vertices|segments|range|band|lot|tracker|grid] [--variant NAME]\n"
+                "          [--threads N] [--pin CPU] [--recording FILE [--recording-frames N]]\n",
+                argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&](const char* flag) -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", flag);
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--quick") {
+            opt.quick = true;
+            opt.reps = 7;
+            opt.minRepSeconds = 0.005;
+            opt.warmupSeconds = 0.01;
+        } else if (a == "--csv") {
+            opt.csv = true;
+        } else if (a == "--reps") {
+            opt.reps = std::max(1, std::atoi(next("--reps")));
+        } else if (a == "--min-rep-ms") {
+            opt.minRepSeconds = std::atof(next("--min-rep-ms")) / 1000.0;
+        } else if (a == "--warmup-ms") {
+            opt.warmupSeconds = std::atof(next("--warmup-ms")) / 1000.0;
+        } else if (a == "--sweep") {
+            opt.sweep = next("--sweep");
+        } else if (a == "--variant") {
+            opt.variant = next("--variant");
+        } else if (a == "--threads") {
+            opt.threads = (unsigned)std::atoi(next("--threads"));
+        } else if (a == "--recording") {
+            opt.recording = next("--recording");
+        } else if (a == "--recording-frames") {
+            opt.recordingFrames = std::max(1, std::atoi(next("--recording-frames")));
+        } else if (a == "--pin") {
+            opt.pinCpu = std::atoi(next("--pin"));
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+void pinToCpu(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    if (sched_setaffinity(0, sizeof(set), &set) != 0) std::perror("sched_setaffinity");
+#else
+    (void)cpu;
+    std::fprintf(stderr, "--pin is only supported on Linux\n");
+#endif
+}
+
+void printHeader(const char* sweepName, const Options& opt) {
+    if (opt.csv) return;
+    std::printf("\n== sweep: %s ==\n", sweepName);
+    std::printf("%-14s %7s %6s %5s %6s %5s | %9s %9s %9s | %10s %10s\n", "variant", "polys", "v/poly", "segs",
+                "range", "band", "ns/v p10", "ns/v p50", "ns/v p90", "vert/s", "seg/s");
+}
+
+// 在一个场景上校验并测量全部 (或 --variant 指定的) 变体
+bool runPoint(const char* sweepName, const BenchScene& scene, double bandFraction, const std::vector<Variant>& variants,
+              const Options& opt) {
+    std::vector<std::pair<std::string, double>> medians;
+    const int polys = (int)scene.obstacles.polygonCount();
+    const int vertsPerPoly = polys ? (int)(scene.obstacles.vertexCount() / polys) : 0;
+    const int segs = (int)scene.segmentCount;
+    bool ok = verify(variants, scene);
+    for (const Variant& v : variants) {
+        if (!opt.variant.empty() && opt.variant != v.name) continue;
+        Measurement m = measure(v, scene, opt);
+        medians.push_back(std::make_pair(std::string(v.name), m.nsPerVertexMedian));
+        if (opt.csv) {
+            std::printf("%s,%s,%d,%d,%d,%g,%g,%ld,%.4f,%.4f,%.4f,%.6g,%.6g\n", sweepName, v.name, polys, vertsPerPoly,
+                        segs, scene.detectionRange, bandFraction, m.itersPerRep, m.nsPerVertexP10,
+                        m.nsPerVertexMedian, m.nsPerVertexP90, m.verticesPerSecond, m.segmentsPerSecond);
+        } else {
+            std::printf("%-14s %7d %6d %5d %6.0f %5.2f | %9.4f %9.4f %9.4f | %10.3e %10.3e\n", v.name, polys,
+                        vertsPerPoly, segs, scene.detectionRange, bandFraction, m.nsPerVertexP10,
+                        m.nsPerVertexMedian, m.nsPerVertexP90, m.verticesPerSecond, m.segmentsPerSecond);
+        }
+        std::fflush(stdout);
+    }
+    if (!opt.csv) printStatsOverhead(medians);
+    return ok;
+}
+
+bool runSweeps(const std::vector<Variant>& variants, const Options& opt) {
+    bool ok = true;
+    for (const Sweep& sweep : makeSweeps(opt.quick)) {
+        if (!opt.sweep.empty() && opt.sweep != sweep.name) continue;
+        printHeader(sweep.name, opt);
+        for (const SweepPoint& p : sweep.points) ok = runPoint(sweep.name, makeScene(p), p.bandFraction, variants, opt) && ok;
+    }
+    return ok;
+}
+
+// 在录制文件中均匀抽取若干帧，内核直接读映射区；只有参考实现需要的 AoS 副本是拷贝出来的
+bool runRecording(const std::vector<Variant>& variants, const Options& opt) {
+    MappedRecording rec;
+    if (!rec.open(opt.recording)) {
+        std::fprintf(stderr, "%s\n", rec.error().c_str());
+        return false;
+    }
+    if (rec.frameCount() == 0) {
+        std::fprintf(stderr, "%s has no frames\n", opt.recording.c_str());
+        return false;
+    }
+    printHeader("recording", opt);
+    const size_t picks = std::min<size_t>(opt.recordingFrames, rec.frameCount());
+    bool ok = true;
+    for (size_t k = 0; k < picks; ++k) {
+        size_t f = picks == 1 ? 0 : k * (rec.frameCount() - 1) / (picks - 1);
+        RecordedFrame frame;
+        if (!rec.frame(f, frame)) {
+            std::fprintf(stderr, "%s\n", rec.error().c_str());
+            return false;
+        }
+        BenchScene scene;
+        scene.obstacles = frame.obstacles;
+        scene.segments = frame.segments;
+        scene.segmentCount = frame.segmentCount;
+        scene.margin = frame.margin;
+        scene.detectionRange = frame.detectionRange;
+        scene.allWorld = obstaclePolygons(frame.obstacles);
+        if (!opt.csv) std::printf("-- frame %zu --\n", f);
+        ok = runPoint("recording", scene, NAN, variants, opt) && ok;
+    }
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+    if (opt.pinCpu >= 0) pinToCpu(opt.pinCpu);
+
+    std::vector<Variant> variants = makeVariants(opt.threads);
+
+    if (opt.csv) {
+        std::printf("sweep,variant,polygons,verts_per_poly,segments,range,band,iters,"
+                    "ns_per_vertex_p10,ns_per_vertex_p50,ns_per_vertex_p90,vertices_per_s,segments_per_s\n");
+    } else {
+        std::printf("reps=%d min_rep=%.0fms warmup=%.0fms\n", opt.reps, opt.minRepSeconds * 1e3,
+                    opt.warmupSeconds * 1e3);
+        printTraceOverhead();
+        printPublishOverhead();
+    }
+
+    if (!opt.csv && opt.recording.empty() && (opt.sweep.empty() || opt.sweep == "tracker")) printTrackerScaling(opt.quick);
+    if (!opt.csv && opt.recording.empty() && (opt.sweep.empty() || opt.sweep == "grid")) printGridScaling(opt.quick);
+    bool ok = opt.recording.empty() ? runSweeps(variants, opt) : runRecording(variants, opt);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,51 @@
+#include "camera_control.h"
+
+#include <algorithm>
+
+#include "static_layer.h"
+
+void updateCamera(Camera2D& camera, const Camera2D& home) {
+    if (IsKeyPressed(KEY_ZERO)) camera = home;
+    const float wheel = GetMouseWheelMove();
+    if (wheel != 0.0f) {
+        // 以光标下的世界点为锚点缩放
+        const Vector2 cursor = GetMousePosition();
+        camera.target = GetScreenToWorld2D(cursor, camera);
+        camera.offset = cursor;
+        camera.zoom = std::min(20.0f, std::max(0.02f, camera.zoom * (1.0f + 0.1f * wheel)));
+    }
+    if (IsMouseButtonDown(MOUSE_BUTTON_RIGHT)) {
+        const Vector2 delta = GetMouseDelta();
+        camera.target.x -= delta.x / camera.zoom;
+        camera.target.y -= delta.y / camera.zoom;
+    }
+}
+
+Camera2D fitCamera(const Bounds& extent, int width, int height, float margin) {
+    const double w = std::max(extent.maxX - extent.minX, 1e-6);
+    const double h = std::max(extent.maxY - extent.minY, 1e-6);
+    Camera2D camera;
+    camera.offset = {width * 0.5f, height * 0.5f};
+    camera.target = {(float)((extent.minX + extent.maxX) * 0.5), (float)((extent.minY + extent.maxY) * 0.5)};
+    camera.rotation = 0.0f;
+    camera.zoom = (float)std::min(width / w, height / h) * (1.0f - 2.0f * margin);
+    return camera;
+}
+
+LineBatchView cameraView(const Camera2D& camera, int width, int height, double detailPx) {
+    const Vector2 viewMin = GetScreenToWorld2D({0.0f, 0.0f}, camera);
+    const Vector2 viewMax = GetScreenToWorld2D({(float)width, (float)height}, camera);
+    LineBatchView view;
+    view.viewport = {viewMin.x, viewMin.y, viewMax.x, viewMax.y};
+    view.minFeature = detailPx / camera.zoom;
+    return view;
+}
+
+uint64_t cameraKey(const Camera2D& camera) {
+    uint64_t key = StaticLayer::mixKey(0, (double)camera.target.x);
+    key = StaticLayer::mixKey(key, (double)camera.target.y);
+    key = StaticLayer::mixKey(key, (double)camera.offset.x);
+    key = StaticLayer::mixKey(key, (double)camera.offset.y);
+    key = StaticLayer::mixKey(key, (double)camera.zoom);
+    return key;
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+#include "line_batch.h"
+#include "raylib.h"
+#include "slot_shift.h"
+
+// --- 可视化程序的视图控制 ---
+// 滚轮以光标为中心缩放，右键拖动平移，0 键复位到 home。
+void updateCamera(Camera2D& camera, const Camera2D& home);
+
+// 让 extent 居中并铺满 width x height 的窗口 (四周留 margin 比例的空白)
+Camera2D fitCamera(const Bounds& extent, int width, int height, float margin = 0.05f);
+
+// 当前视图在世界坐标下的范围，以及屏幕上 detailPx 像素对应的世界长度 (用于线框简化)
+LineBatchView cameraView(const Camera2D& camera, int width, int height, double detailPx);
+
+// 视图变换的指纹：混进线框 generation 与静态图层 key，视图一变两者都会重建
+uint64_t cameraKey(const Camera2D& camera);
@@ -0,0 +1,370 @@
+#include "distance_field.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+static_assert(sizeof(FieldFileHeader) == 64, "field file header layout");
+
+namespace {
+
+// 单个方向每张表的表项数上限 (near / prefix / suffix / blockMin 各自不超过 256 MB)
+const int64_t kMaxPlaneEntries = int64_t(1) << 27;
+// 坐标超过这个量级时相减可能溢出，交给栅格内核
+const double kMaxCoordinate = 1e300;
+
+const uint32_t kDirections[4] = {kFieldPosX, kFieldNegX, kFieldPosY, kFieldNegY};
+
+inline bool alongY(uint32_t direction) { return (direction & (kFieldPosY | kFieldNegY)) != 0; }
+
+// (L, K) -> 角点 (cx, cy)
+inline void cornerIndex(uint32_t direction, const OccupancyGrid& g, int64_t l, int64_t k, int64_t& cx, int64_t& cy) {
+    switch (direction) {
+    case kFieldPosX: cx = l, cy = k; break;
+    case kFieldNegX: cx = g.width - l, cy = k; break;
+    case kFieldPosY: cx = k, cy = l; break;
+    default: cx = k, cy = g.height - l; break;
+    }
+}
+
+// pred 在 [lo, hi] 上为真的部分是一段前缀，返回最后一个为真的下标 (全为假时返回 lo - 1)。
+// 从 guess 出发，边界就在附近时几次判定即可，走不到再二分
+template <class P>
+int64_t lastTrue(int64_t lo, int64_t hi, double guess, P pred) {
+    int64_t a, b; // pred(a) 为真或 a = lo - 1；pred(b) 为假或 b = hi + 1
+    const int64_t g = !(guess > (double)lo) ? lo : guess >= (double)hi ? hi : (int64_t)guess;
+    if (pred(g)) {
+        a = g;
+        b = hi + 1;
+        for (int step = 0; step < 4 && a + 1 < b; ++step) {
+            if (!pred(a + 1)) return a;
+            ++a;
+        }
+    } else {
+        a = lo - 1;
+        b = g;
+        for (int step = 0; step < 4 && a + 1 < b; ++step) {
+            if (pred(b - 1)) return b - 1;
+            --b;
+        }
+    }
+    while (b - a > 1) {
+        const int64_t mid = a + (b - a) / 2;
+        if (pred(mid)) {
+            a = mid;
+        } else {
+            b = mid;
+        }
+    }
+    return a;
+}
+
+// 配置与栅格尺寸是否可以建表，返回空串表示可以
+std::string configProblem(const DistanceFieldConfig& config, int32_t width, int32_t height) {
+    const uint32_t b = config.blockSize;
+    if (b < 2 || b > 1024 || (b & (b - 1)) != 0) return "block size must be a power of two in [2, 1024]";
+    if (config.directions & ~(uint32_t)kFieldAll) return "unknown field direction";
+    if (((int64_t)width + 1) * ((int64_t)height + 1) > kMaxPlaneEntries) return "grid is too large";
+    // 稀疏表约为 L x (K / blockSize) x log2(K / blockSize)，块很小时可能超过 near 本身
+    for (int64_t k : {(int64_t)width + 1, (int64_t)height + 1}) {
+        const int64_t lateral = ((int64_t)width + 1) * ((int64_t)height + 1) / k;
+        const int64_t blocks = (k + b - 1) / b;
+        if ((64 - __builtin_clzll((uint64_t)blocks)) * blocks * lateral > kMaxPlaneEntries) {
+            return "grid is too large for this block size";
+        }
+    }
+    return std::string();
+}
+
+bool writeBlock(FILE* f, const void* data, size_t bytes) {
+    return bytes == 0 || std::fwrite(data, 1, bytes, f) == bytes;
+}
+
+bool readBlock(FILE* f, void* data, size_t bytes) {
+    return bytes == 0 || std::fread(data, 1, bytes, f) == bytes;
+}
+
+template <class T>
+bool writeVector(FILE* f, const std::vector<T>& v) {
+    return writeBlock(f, v.data(), v.size() * sizeof(T));
+}
+
+template <class T>
+bool readVector(FILE* f, std::vector<T>& v) {
+    return readBlock(f, v.data(), v.size() * sizeof(T));
+}
+
+} // namespace
+
+// --- 单个方向的表 ---
+Vec2 DirectionalDistanceField::Plane::corner(const OccupancyGrid& g, int64_t l, int64_t k) const {
+    int64_t cx, cy;
+    cornerIndex(direction, g, l, k, cx, cy);
+    return g.corner(cx, cy);
+}
+
+uint16_t DirectionalDistanceField::Plane::rangeMin(int64_t l, int64_t k0, int64_t k1, uint32_t blockSize) const {
+    const size_t row = (size_t)(l * longitudinal);
+    const int64_t b0 = k0 / blockSize, b1 = k1 / blockSize;
+    if (b0 == b1) {
+        uint16_t m = kFieldNone;
+        for (int64_t k = k0; k <= k1; ++k) m = std::min(m, near[row + (size_t)k]);
+        return m;
+    }
+    uint16_t m = std::min(suffix[row + (size_t)k0], prefix[row + (size_t)k1]);
+    if (b1 - b0 > 1) {
+        // 中间的整块 [b0 + 1, b1 - 1] 由稀疏表里两段可重叠的 2^j 块覆盖
+        const int j = 63 - __builtin_clzll((uint64_t)(b1 - b0 - 1));
+        const uint16_t* level = blockMin.data() + (size_t)((j * lateral + l) * blocks);
+        m = std::min(m, std::min(level[b0 + 1], level[b1 - ((int64_t)1 << j)]));
+    }
+    return m;
+}
+
+// --- 建表 ---
+bool DirectionalDistanceField::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+void DirectionalDistanceField::allocate(Plane& plane, uint32_t direction) const {
+    plane.direction = direction;
+    plane.lateral = alongY(direction) ? (int64_t)grid_.height + 1 : (int64_t)grid_.width + 1;
+    plane.longitudinal = alongY(direction) ? (int64_t)grid_.width + 1 : (int64_t)grid_.height + 1;
+    plane.blocks = (plane.longitudinal + config_.blockSize - 1) / config_.blockSize;
+    plane.levels = 64 - __builtin_clzll((uint64_t)plane.blocks);
+    const size_t entries = (size_t)(plane.lateral * plane.longitudinal);
+    plane.near.assign(entries, kFieldNone);
+    plane.prefix.assign(entries, kFieldNone);
+    plane.suffix.assign(entries, kFieldNone);
+    plane.blockMin.assign((size_t)(plane.levels * plane.lateral * plane.blocks), kFieldNone);
+}
+
+void DirectionalDistanceField::fillPlane(Plane& plane, const std::vector<uint64_t>& cornerMasks) const {
+    const int64_t nK = plane.longitudinal, B = config_.blockSize;
+    for (int64_t l = 0; l < plane.lateral; ++l) {
+        uint16_t* row = plane.near.data() + l * nK;
+        const uint16_t* prev = l > 0 ? row - nK : nullptr;
+        for (int64_t k = 0; k < nK; ++k) {
+            int64_t cx, cy;
+            cornerIndex(plane.direction, grid_, l, k, cx, cy);
+            const bool vertex = (cornerMasks[(size_t)cy * grid_.wordsPerRow + ((size_t)cx >> 6)] >> (cx & 63)) & 1u;
+            if (vertex) {
+                row[k] = 0;
+            } else {
+                row[k] = (!prev || prev[k] >= kFieldNone - 1) ? kFieldNone : (uint16_t)(prev[k] + 1);
+            }
+        }
+        // 块内前缀 / 后缀最小值；整块的最小值即块首的后缀最小值
+        uint16_t* prefix = plane.prefix.data() + l * nK;
+        uint16_t* suffix = plane.suffix.data() + l * nK;
+        for (int64_t k = 0; k < nK; ++k) prefix[k] = k % B == 0 ? row[k] : std::min(prefix[k - 1], row[k]);
+        for (int64_t k = nK - 1; k >= 0; --k) {
+            suffix[k] = (k % B == B - 1 || k == nK - 1) ? row[k] : std::min(suffix[k + 1], row[k]);
+        }
+        uint16_t* blocksRow = plane.blockMin.data() + l * plane.blocks;
+        for (int64_t b = 0; b < plane.blocks; ++b) blocksRow[b] = suffix[b * B];
+        for (int j = 1; j < plane.levels; ++j) {
+            const uint16_t* lower = plane.blockMin.data() + ((j - 1) * plane.lateral + l) * plane.blocks;
+            uint16_t* level = plane.blockMin.data() + (j * plane.lateral + l) * plane.blocks;
+            const int64_t half = (int64_t)1 << (j - 1);
+            for (int64_t b = 0; b + 2 * half <= plane.blocks; ++b) level[b] = std::min(lower[b], lower[b + half]);
+        }
+    }
+}
+
+bool DirectionalDistanceField::build(const OccupancyGrid& grid, const DistanceFieldConfig& config) {
+    const std::string problem = configProblem(config, grid.width, grid.height);
+    if (!problem.empty()) return fail(problem);
+    grid_ = grid;
+    config_ = config;
+    planes_.clear();
+
+    std::vector<uint64_t> cornerMasks(grid_.wordsPerRow * ((size_t)grid_.height + 1));
+    for (int64_t cy = 0; cy <= grid_.height; ++cy) cornerMask(grid_, cy, cornerMasks.data() + cy * grid_.wordsPerRow);
+    for (uint32_t direction : kDirections) {
+        if (!(config_.directions & direction)) continue;
+        planes_.emplace_back();
+        allocate(planes_.back(), direction);
+        fillPlane(planes_.back(), cornerMasks);
+    }
+    error_.clear();
+    return true;
+}
+
+size_t DirectionalDistanceField::memoryBytes() const {
+    size_t bytes = grid_.bits.size() * sizeof(uint64_t);
+    for (const Plane& p : planes_) {
+        bytes += (p.near.size() + p.prefix.size() + p.suffix.size() + p.blockMin.size()) * sizeof(uint16_t);
+    }
+    return bytes;
+}
+
+// --- 持久化 ---
+bool DirectionalDistanceField::save(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return fail("cannot open " + path + ": " + std::strerror(errno));
+    FieldFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, kFieldMagic, sizeof(header.magic));
+    header.version = kFieldVersion;
+    header.endianTag = kFieldEndianTag;
+    header.width = grid_.width;
+    header.height = grid_.height;
+    header.cellSize = grid_.cellSize;
+    header.originX = grid_.origin.x;
+    header.originY = grid_.origin.y;
+    header.directions = config_.directions;
+    header.blockSize = config_.blockSize;
+    bool ok = writeBlock(f, &header, sizeof(header)) && writeVector(f, grid_.bits);
+    for (const Plane& p : planes_) {
+        ok = ok && writeVector(f, p.near) && writeVector(f, p.prefix) && writeVector(f, p.suffix) &&
+             writeVector(f, p.blockMin);
+    }
+    ok = std::fclose(f) == 0 && ok;
+    return ok ? true : fail("failed to write " + path);
+}
+
+bool DirectionalDistanceField::load(const std::string& path) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return fail("cannot open " + path + ": " + std::strerror(errno));
+    // 读进临时对象，整个文件校验通过后才替换当前内容
+    DirectionalDistanceField loaded;
+    FieldFileHeader header;
+    std::string problem;
+    if (!readBlock(f, &header, sizeof(header))) {
+        problem = "truncated file header";
+    } else if (std::memcmp(header.magic, kFieldMagic, sizeof(header.magic)) != 0) {
+        problem = "not a distance field file";
+    } else if (header.endianTag != kFieldEndianTag) {
+        problem = "distance field was written with a different byte order";
+    } else if (header.version != kFieldVersion) {
+        problem = "unsupported distance field version " + std::to_string(header.version);
+    } else if (!loaded.grid_.reset(header.width, header.height, header.cellSize, {header.originX, header.originY})) {
+        problem = "invalid grid geometry";
+    } else {
+        loaded.config_.directions = header.directions;
+        loaded.config_.blockSize = header.blockSize;
+        problem = configProblem(loaded.config_, header.width, header.height);
+        bool ok = problem.empty() && readVector(f, loaded.grid_.bits);
+        for (uint32_t direction : kDirections) {
+            if (!ok || !(loaded.config_.directions & direction)) continue;
+            loaded.planes_.emplace_back();
+            Plane& p = loaded.planes_.back();
+            loaded.allocate(p, direction);
+            ok = readVector(f, p.near) && readVector(f, p.prefix) && readVector(f, p.suffix) &&
+                 readVector(f, p.blockMin);
+        }
+        if (problem.empty() && !ok) {
+            problem = "truncated distance field";
+        } else if (problem.empty() && std::fgetc(f) != EOF) {
+            problem = "trailing bytes after distance field";
+        }
+    }
+    std::fclose(f);
+    if (!problem.empty()) return fail(path + ": " + problem);
+    // 栅格宽度之外的位不应存在，清掉以免角点掩码多出顶点
+    OccupancyGrid& g = loaded.grid_;
+    for (int32_t y = 0; y < g.height; ++y) {
+        for (size_t w = 0; w < g.wordsPerRow; ++w) {
+            const int64_t valid = std::min<int64_t>(64, std::max<int64_t>(0, (int64_t)g.width - (int64_t)w * 64));
+            if (valid < 64) g.bits[(size_t)y * g.wordsPerRow + w] &= valid ? (1ull << valid) - 1 : 0;
+        }
+    }
+    grid_ = std::move(loaded.grid_);
+    config_ = loaded.config_;
+    planes_ = std::move(loaded.planes_);
+    error_.clear();
+    return true;
+}
+
+// --- 查询 ---
+const DirectionalDistanceField::Plane* DirectionalDistanceField::planeFor(const Segment& seg, Vec2 dir) const {
+    const Vec2 h = seg.heading;
+    uint32_t direction;
+    if (dir.y == 0 && std::fabs(dir.x) == 1 && h.x == 0 && h.y != 0) {
+        direction = h.y > 0 ? kFieldPosY : kFieldNegY;
+    } else if (dir.x == 0 && std::fabs(dir.y) == 1 && h.y == 0 && h.x != 0) {
+        direction = h.x > 0 ? kFieldPosX : kFieldNegX;
+    } else {
+        return nullptr;
+    }
+    // 另一分量乘 0 得到 ±0 的前提是坐标差有限
+    const Vec2 far = grid_.corner(grid_.width, grid_.height);
+    if (!(std::fabs(seg.start.x) < kMaxCoordinate && std::fabs(seg.start.y) < kMaxCoordinate &&
+          std::fabs(h.x) < kMaxCoordinate && std::fabs(h.y) < kMaxCoordinate &&
+          std::fabs(far.x) < kMaxCoordinate && std::fabs(far.y) < kMaxCoordinate)) {
+        return nullptr;
+    }
+    for (const Plane& p : planes_) {
+        if (p.direction == direction) return &p;
+    }
+    return nullptr;
+}
+
+bool DirectionalDistanceField::covers(const Segment& seg) const { return planeFor(seg, seg.getDir()) != nullptr; }
+
+double DirectionalDistanceField::queryPlane(const Plane& plane, const Segment& seg, Vec2 dir, double margin,
+                                            double detectionRange) const {
+    const OccupancyGrid& g = grid_;
+    const double segLen = seg.length();
+    // 与参考实现相同的两个投影。方向与 heading 各有一个分量为 0，projLen 只取决于 K、dist 只取决于 L
+    auto projLen = [&](int64_t l, int64_t k) { return (plane.corner(g, l, k) - seg.start).dot(dir); };
+    auto dist = [&](int64_t l, int64_t k) { return (plane.corner(g, l, k) - seg.start).dot(seg.heading); };
+
+    // 1. 纵向窗口 [k0, k1]：projLen 随 K 单调
+    const bool y = alongY(plane.direction);
+    const double kOrigin = y ? g.origin.x : g.origin.y;
+    const double kStart = y ? seg.start.x : seg.start.y;
+    const double kDir = y ? dir.x : dir.y;
+    const double guessStart = (kStart - kOrigin) / g.cellSize;
+    const double guessEnd = (kStart + kDir * segLen - kOrigin) / g.cellSize;
+    const int64_t lastK = plane.longitudinal - 1;
+    int64_t k0, k1;
+    if (kDir > 0) {
+        k0 = lastTrue(0, lastK, guessStart, [&](int64_t k) { return projLen(0, k) < 0; }) + 1;
+        k1 = lastTrue(0, lastK, guessEnd, [&](int64_t k) { return projLen(0, k) <= segLen; });
+    } else {
+        k0 = lastTrue(0, lastK, guessEnd, [&](int64_t k) { return projLen(0, k) > segLen; }) + 1;
+        k1 = lastTrue(0, lastK, guessStart, [&](int64_t k) { return projLen(0, k) >= 0; });
+    }
+    if (k0 > k1) return 0.0;
+
+    // 2. 探测带 [lLow, lMax]：dist 随 L 单调不减
+    const double hl = y ? seg.heading.y : seg.heading.x;
+    const double lStart = y ? seg.start.y : seg.start.x;
+    const double lOrigin = y ? g.origin.y : g.origin.x;
+    const int64_t lastL = plane.lateral - 1;
+    const bool flipped = plane.direction == kFieldNegX || plane.direction == kFieldNegY;
+    auto lIndex = [&](double c) {
+        const double i = (c - lOrigin) / g.cellSize;
+        return flipped ? (double)lastL - i : i;
+    };
+    const int64_t lMax =
+        lastTrue(0, lastL, lIndex(lStart + detectionRange / hl), [&](int64_t l) { return dist(l, k0) < detectionRange; });
+    const int64_t lLow =
+        lastTrue(0, lastL, lIndex(lStart - margin / hl), [&](int64_t l) { return dist(l, k0) <= -margin; }) + 1;
+    if (lMax < lLow) return 0.0;
+    // 距离以 uint16_t 截断，探测带比它还宽时表里的 kFieldNone 不能当作“没有顶点”
+    if (lMax - lLow >= kFieldNone) return calculateSegmentShiftGrid(seg, g, margin, detectionRange);
+
+    // 3. 最远的顶点行
+    const uint16_t d = plane.rangeMin(lMax, k0, k1, config_.blockSize);
+    if (d == kFieldNone || d > lMax - lLow) return 0.0;
+    const double push = dist(lMax - d, k0) + margin;
+    return push > 0.0 ? push : 0.0;
+}
+
+double DirectionalDistanceField::query(const Segment& seg, double margin, double detectionRange) const {
+    const Vec2 dir = seg.getDir();
+    const Plane* plane = std::isfinite(margin) && std::isfinite(detectionRange) ? planeFor(seg, dir) : nullptr;
+    if (!plane) return calculateSegmentShiftGrid(seg, grid_, margin, detectionRange);
+    return queryPlane(*plane, seg, dir, margin, detectionRange);
+}
+
+void DirectionalDistanceField::queryBatch(const Segment* segs, size_t n, double margin, double detectionRange,
+                                          double* out) const {
+    for (size_t i = 0; i < n; ++i) out[i] = query(segs[i], margin, detectionRange);
+}
@@ -0,0 +1,106 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "occupancy_grid.h"
+#include "slot_shift.h"
+
+// --- 方向距离场 ---
+// 静态地图上，沿坐标轴摆放的车位线只有四种推移方向 (+x / -x / +y / -y)。对每个方向，把角点按
+// (横向下标 L, 纵向下标 K) 排列，L 沿推移方向递增；near[L][K] 为第 K 条纵向线上从 L 往回数到最近顶点的距离
+// (以角点计，0 表示 (L, K) 本身是顶点，kFieldNone 表示 65534 格内没有)。
+// 线段的纵向窗口是 K 的一段区间 [k0, k1]，探测带是 L 的一段区间 [Llow, Lmax]，推移量来自
+// Lmax - min(near[Lmax][k0..k1]) 这一行上的顶点：一次区间最小值查询加一次距离计算。
+// 区间最小值按 van Herk / Gil-Werman 的分块前缀 / 后缀最小值存储，整块的最小值再建一张稀疏表 (blockMin)：
+// 跨块的查询读块两端的后缀 / 前缀各一次、稀疏表两次，与窗口长度无关；落在同一块内的查询直接扫描 near
+// (不超过 blockSize 项)。稀疏表比只存整块最小值多约 log2(K / blockSize) / blockSize 倍的表项。
+//
+// 窗口与探测带的四个边界 (k0、k1、Llow、Lmax) 按参考实现的表达式逐个角点判定，结果与参考实现逐位一致。
+// 每个边界从坐标算出的估计位置出发，通常一两次判定即可确定；估计偏出 4 个角点以上时才退化为二分 (O(log n))。
+// 因此一次查询是常数次的表读取与投影计算，而不是单纯的几次内存读取。
+//
+// 距离场与 margin / detectionRange 无关，可以离线建好与地图一起保存 (save / load)。
+// 只有方向精确沿轴 (getDir() 的另一分量为 0) 且 heading 与线段垂直的线段走距离场，
+// 其余线段以及非有限输入交给 calculateSegmentShiftGrid。
+enum FieldDirection : uint32_t {
+    kFieldPosX = 1,
+    kFieldNegX = 2,
+    kFieldPosY = 4,
+    kFieldNegY = 8,
+    kFieldAll = 15,
+};
+
+const uint16_t kFieldNone = 0xffff;
+
+struct DistanceFieldConfig {
+    uint32_t directions = kFieldAll; // FieldDirection 的组合，只为需要的车位朝向建表
+    uint32_t blockSize = 16;         // 区间最小值的分块大小，2 的幂，[2, 1024]
+};
+
+// --- 文件格式 ---
+// 小端，依次为：文件头 (64 字节)、栅格位图 (uint64_t x wordsPerRow x height)、
+// 每个方向按位从低到高各一组 near / prefix / suffix (uint16_t x L x K) 与 blockMin (uint16_t x 层数 x L x 块数)。
+// 各块长度只由文件头决定，读端按文件大小校验。
+const char kFieldMagic[8] = {'S', 'L', 'O', 'T', 'D', 'D', 'F', '\0'};
+const uint32_t kFieldVersion = 2;
+const uint32_t kFieldEndianTag = 0x01020304;
+
+struct FieldFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    int32_t width;
+    int32_t height;
+    double cellSize;
+    double originX;
+    double originY;
+    uint32_t directions;
+    uint32_t blockSize;
+    uint8_t reserved[8];
+};
+
+class DirectionalDistanceField {
+public:
+    // 复制栅格并为 config.directions 建表；参数不合法或表太大时返回 false
+    bool build(const OccupancyGrid& grid, const DistanceFieldConfig& config);
+
+    bool save(const std::string& path);
+    bool load(const std::string& path);
+
+    // seg 能否走距离场 (否则 query 交给栅格内核)
+    bool covers(const Segment& seg) const;
+    double query(const Segment& seg, double margin, double detectionRange) const;
+    void queryBatch(const Segment* segs, size_t n, double margin, double detectionRange, double* out) const;
+
+    const OccupancyGrid& grid() const { return grid_; }
+    const DistanceFieldConfig& config() const { return config_; }
+    size_t memoryBytes() const;
+    const std::string& error() const { return error_; }
+
+private:
+    struct Plane {
+        uint32_t direction = 0;
+        int64_t lateral = 0;      // L 的取值个数
+        int64_t longitudinal = 0; // K 的取值个数
+        int64_t blocks = 0;       // 每行的块数
+        int levels = 0;           // 稀疏表层数，第 j 层存从每块起 2^j 块的最小值
+        std::vector<uint16_t> near, prefix, suffix, blockMin;
+
+        Vec2 corner(const OccupancyGrid& g, int64_t l, int64_t k) const;
+        uint16_t rangeMin(int64_t l, int64_t k0, int64_t k1, uint32_t blockSize) const;
+    };
+
+    bool fail(const std::string& message);
+    void allocate(Plane& plane, uint32_t direction) const;
+    void fillPlane(Plane& plane, const std::vector<uint64_t>& cornerMasks) const;
+    const Plane* planeFor(const Segment& seg, Vec2 dir) const;
+    double queryPlane(const Plane& plane, const Segment& seg, Vec2 dir, double margin, double detectionRange) const;
+
+    OccupancyGrid grid_;
+    DistanceFieldConfig config_;
+    std::vector<Plane> planes_;
+    std::string error_;
+};
@@ -0,0 +1,162 @@
+// field_slotshift：为静态停车场地图离线建方向距离场并保存，或载入保存的距离场做查询压测。
+// 只栅格化静态障碍物 (车辆、柱子、路沿)，行人等动态部分照常用其他内核计算后取最大值。
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "distance_field.h"
+#include "occupancy_grid.h"
+#include "parking_lot.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string buildPath;
+    std::string queryPath;
+    int slots = 2000;
+    uint64_t seed = 1;
+    double cell = 1.0;
+    uint32_t blockSize = 16;
+    int repeat = 20;
+};
+
+double secondsSince(Clock::time_point t0) { return std::chrono::duration<double>(Clock::now() - t0).count(); }
+
+void usage(const char* argv0) {
+    std::printf("usage: %s --build FILE [--slots N] [--seed N] [--cell C] [--block N]\n"
+                "       %s --query FILE [--slots N] [--seed N] [--repeat N]\n",
+                argv0, argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", a.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--build") {
+            opt.buildPath = next();
+        } else if (a == "--query") {
+            opt.queryPath = next();
+        } else if (a == "--slots") {
+            opt.slots = std::max(1, std::atoi(next()));
+        } else if (a == "--seed") {
+            opt.seed = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--cell") {
+            opt.cell = std::atof(next());
+        } else if (a == "--block") {
+            opt.blockSize = (uint32_t)std::atoi(next());
+        } else if (a == "--repeat") {
+            opt.repeat = std::max(1, std::atoi(next()));
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.buildPath.empty() == opt.queryPath.empty()) {
+        usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+int build(const Options& opt) {
+    const ParkingLot lot = generateParkingLot(lotConfig(opt.slots, opt.seed));
+    const std::vector<std::vector<Vec2>> statics(lot.allWorld.begin(),
+                                                 lot.allWorld.begin() + (std::ptrdiff_t)lot.staticPolygonCount);
+    OccupancyGrid grid;
+    if (!grid.reset((int32_t)std::ceil((lot.extent.maxX - lot.extent.minX) / opt.cell) + 1,
+                    (int32_t)std::ceil((lot.extent.maxY - lot.extent.minY) / opt.cell) + 1, opt.cell,
+                    {lot.extent.minX, lot.extent.minY})) {
+        std::fprintf(stderr, "invalid cell size %g\n", opt.cell);
+        return 1;
+    }
+    rasterizePolygons(statics, grid);
+
+    DistanceFieldConfig config;
+    config.blockSize = opt.blockSize;
+    DirectionalDistanceField field;
+    Clock::time_point t0 = Clock::now();
+    if (!field.build(grid, config)) {
+        std::fprintf(stderr, "build failed: %s\n", field.error().c_str());
+        return 1;
+    }
+    const double buildSeconds = secondsSince(t0);
+    t0 = Clock::now();
+    if (!field.save(opt.buildPath)) {
+        std::fprintf(stderr, "%s\n", field.error().c_str());
+        return 1;
+    }
+    std::printf("%d x %d cells (%.2f), %zu occupied, 4 directions, block %u\n", grid.width, grid.height, grid.cellSize,
+                grid.occupiedCount(), config.blockSize);
+    std::printf("built in %.1f ms, %.1f MB written to %s in %.1f ms\n", buildSeconds * 1e3,
+                field.memoryBytes() / 1048576.0, opt.buildPath.c_str(), secondsSince(t0) * 1e3);
+    return 0;
+}
+
+// 重复 repeat 次批量查询，返回每条线段的平均纳秒数
+template <class F>
+double nsPerSegment(size_t n, int repeat, F run) {
+    if (n == 0) return 0.0;
+    const Clock::time_point t0 = Clock::now();
+    for (int r = 0; r < repeat; ++r) run();
+    return secondsSince(t0) * 1e9 / ((double)n * repeat);
+}
+
+int query(const Options& opt) {
+    DirectionalDistanceField field;
+    Clock::time_point t0 = Clock::now();
+    if (!field.load(opt.queryPath)) {
+        std::fprintf(stderr, "%s\n", field.error().c_str());
+        return 1;
+    }
+    const double loadSeconds = secondsSince(t0);
+    const ParkingLot lot = generateParkingLot(lotConfig(opt.slots, opt.seed));
+    const double margin = lot.config.margin, range = lot.config.detectionRange;
+
+    // 按能否走距离场分成两组分别计时，回退组的耗时就是栅格内核本身
+    std::vector<Segment> covered, fallback;
+    for (const Segment& s : lot.segments) (field.covers(s) ? covered : fallback).push_back(s);
+    const size_t n = lot.segments.size(), nc = covered.size(), nf = fallback.size();
+
+    std::vector<double> viaField(std::max(nc, nf)), viaGrid(std::max(nc, nf));
+    const double fieldNs = nsPerSegment(nc, opt.repeat, [&] {
+        field.queryBatch(covered.data(), nc, margin, range, viaField.data());
+    });
+    const double coveredGridNs = nsPerSegment(nc, opt.repeat, [&] {
+        calculateSegmentShiftGridBatch(covered.data(), nc, field.grid(), margin, range, viaGrid.data());
+    });
+    size_t mismatches = 0;
+    for (size_t i = 0; i < nc; ++i) mismatches += viaField[i] != viaGrid[i];
+    const double fallbackNs = nsPerSegment(nf, opt.repeat, [&] {
+        field.queryBatch(fallback.data(), nf, margin, range, viaField.data());
+    });
+    calculateSegmentShiftGridBatch(fallback.data(), nf, field.grid(), margin, range, viaGrid.data());
+    for (size_t i = 0; i < nf; ++i) mismatches += viaField[i] != viaGrid[i];
+
+    std::printf("loaded %.1f MB in %.1f ms\n", field.memoryBytes() / 1048576.0, loadSeconds * 1e3);
+    std::printf("coverage: %zu of %zu segments\n", nc, n);
+    std::printf("covered  %6zu segments: field %.1f ns/segment, grid kernel %.1f ns/segment\n", nc, fieldNs,
+                coveredGridNs);
+    std::printf("fallback %6zu segments: grid kernel %.1f ns/segment\n", nf, fallbackNs);
+    std::printf("%zu mismatches\n", mismatches);
+    return mismatches ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+    return opt.buildPath.empty() ? query(opt) : build(opt);
+}
@@ -0,0 +1,233 @@
+#include "frame_capture.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+
+#include <sys/stat.h>
+
+#include "raylib.h"
+#include "rlgl.h"
+// 只取 raylib 自带 GLAD 的声明：函数指针由 rlgl 在 InitWindow 时加载，这里不另外链接或加载 GL 扩展
+#include "external/glad.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msSince(Clock::time_point t) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - t).count();
+}
+
+} // namespace
+
+bool FrameCapture::open(const CaptureOptions& options, int width, int height) {
+    close();
+    error_.clear();
+    if (!options.enabled()) {
+        error_ = "capture directory not set";
+        return false;
+    }
+    if (mkdir(options.directory.c_str(), 0755) != 0 && errno != EEXIST) {
+        error_ = "cannot create capture directory " + options.directory + ": " + std::strerror(errno);
+        return false;
+    }
+    options_ = options;
+    options_.readbackDepth = std::max(1, options_.readbackDepth);
+    options_.maxQueued = std::max<size_t>(1, options_.maxQueued);
+    width_ = width;
+    height_ = height;
+    frameBytes_ = (size_t)width * height * 4;
+
+    // PBO 回读需要 OpenGL 3.2 (glFenceSync)；OpenGL ES 2.0 等后端上 rlgl 不会加载这些入口
+    if (!glGenBuffers || !glBufferData || !glMapBufferRange || !glUnmapBuffer || !glFenceSync || !glClientWaitSync ||
+        !glDeleteSync) {
+        error_ = "frame capture needs OpenGL 3.2 pixel buffer objects and fence sync";
+        return false;
+    }
+    pbo_.assign(options_.readbackDepth, 0);
+    fences_.assign(options_.readbackDepth, nullptr);
+    pending_.assign(options_.readbackDepth, -1);
+    glGenBuffers((GLsizei)pbo_.size(), pbo_.data());
+    for (unsigned int pbo : pbo_) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+        glBufferData(GL_PIXEL_PACK_BUFFER, (GLsizeiptr)frameBytes_, nullptr, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    captured_ = 0;
+    written_ = 0;
+    lastReadbackMs_ = 0.0;
+    queueWaitMs_ = 0.0;
+    stopping_ = false;
+    unsigned workers = options_.workers ? options_.workers : std::thread::hardware_concurrency();
+    workers = std::max(1u, workers);
+    for (unsigned i = 0; i < workers; ++i) workers_.emplace_back(&FrameCapture::workerLoop, this);
+    open_ = true;
+    return true;
+}
+
+void FrameCapture::capture() {
+    if (!open_) return;
+    const int slot = (int)(captured_ % pbo_.size());
+    // 环转满一圈：这个槽里是 readbackDepth 帧之前排入的回读，先取走
+    if (pending_[slot] >= 0) collect(slot);
+
+    // 先提交 raylib 积攒的绘制，再把后缓冲异步读进 PBO；pack 对齐为 4，RGBA 行不需要填充
+    rlDrawRenderBatchActive();
+    glPixelStorei(GL_PACK_ALIGNMENT, 4);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[slot]);
+    glReadPixels(0, 0, width_, height_, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    fences_[slot] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    pending_[slot] = (int64_t)captured_++;
+}
+
+void FrameCapture::collect(int slot) {
+    const Clock::time_point start = Clock::now();
+    GLsync fence = (GLsync)fences_[slot];
+    if (fence) {
+        // 正常情况下 GPU 早已完成，这里不会真正等待
+        glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000ull);
+        glDeleteSync(fence);
+        fences_[slot] = nullptr;
+    }
+
+    std::vector<unsigned char> pixels;
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (jobs_.size() + inFlight_ >= options_.maxQueued) {
+            const Clock::time_point waitStart = Clock::now();
+            jobDone_.wait(lock, [&] { return jobs_.size() + inFlight_ < options_.maxQueued; });
+            queueWaitMs_ += msSince(waitStart);
+        }
+        if (!freeBuffers_.empty()) {
+            pixels.swap(freeBuffers_.back());
+            freeBuffers_.pop_back();
+        }
+    }
+    pixels.resize(frameBytes_);
+
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo_[slot]);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, (GLsizeiptr)frameBytes_, GL_MAP_READ_BIT);
+    if (mapped) {
+        std::memcpy(pixels.data(), mapped, frameBytes_);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    const uint64_t index = (uint64_t)pending_[slot];
+    pending_[slot] = -1;
+    lastReadbackMs_ = msSince(start);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!mapped) {
+        if (error_.empty()) error_ = "glMapBufferRange failed for frame " + std::to_string(index);
+        freeBuffers_.push_back(std::move(pixels));
+        return;
+    }
+    Job job;
+    job.index = index;
+    job.pixels.swap(pixels);
+    jobs_.push_back(std::move(job));
+    jobReady_.notify_one();
+}
+
+void FrameCapture::workerLoop() {
+    for (;;) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            jobReady_.wait(lock, [&] { return stopping_ || !jobs_.empty(); });
+            if (jobs_.empty()) return;
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+            ++inFlight_;
+        }
+        std::string err;
+        const bool ok = encode(job, err);
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            --inFlight_;
+            if (ok) ++written_;
+            else if (error_.empty()) error_ = err;
+            freeBuffers_.push_back(std::move(job.pixels));
+        }
+        jobDone_.notify_all();
+    }
+}
+
+bool FrameCapture::encode(Job& job, std::string& err) const {
+    // glReadPixels 的第一行是画面底部，翻转成自上而下
+    const size_t stride = (size_t)width_ * 4;
+    std::vector<unsigned char> row(stride);
+    for (int y = 0; y < height_ / 2; ++y) {
+        unsigned char* a = job.pixels.data() + (size_t)y * stride;
+        unsigned char* b = job.pixels.data() + (size_t)(height_ - 1 - y) * stride;
+        std::memcpy(row.data(), a, stride);
+        std::memcpy(a, b, stride);
+        std::memcpy(b, row.data(), stride);
+    }
+
+    char name[32];
+    std::snprintf(name, sizeof(name), "frame_%06llu.%s", (unsigned long long)job.index,
+                  options_.format == CaptureFormat::Png ? "png" : "pam");
+    const std::string path = options_.directory + "/" + name;
+
+    if (options_.format == CaptureFormat::Png) {
+        Image image;
+        image.data = job.pixels.data();
+        image.width = width_;
+        image.height = height_;
+        image.mipmaps = 1;
+        image.format = PIXELFORMAT_UNCOMPRESSED_R8G8B8A8;
+        if (!ExportImage(image, path.c_str())) {
+            err = "failed to write " + path;
+            return false;
+        }
+        return true;
+    }
+
+    // PAM：带最小文本头的无压缩 RGBA，写入只是一次顺序 fwrite
+    std::FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) {
+        err = "cannot open " + path + ": " + std::strerror(errno);
+        return false;
+    }
+    std::fprintf(f, "P7\nWIDTH %d\nHEIGHT %d\nDEPTH 4\nMAXVAL 255\nTUPLTYPE RGB_ALPHA\nENDHDR\n", width_, height_);
+    const bool ok = std::fwrite(job.pixels.data(), 1, job.pixels.size(), f) == job.pixels.size();
+    if (std::fclose(f) != 0 || !ok) {
+        err = "failed to write " + path;
+        return false;
+    }
+    return true;
+}
+
+uint64_t FrameCapture::framesWritten() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return written_;
+}
+
+bool FrameCapture::close() {
+    if (!open_) return error_.empty();
+    // 按帧序取回还在 GPU 上的回读
+    for (size_t k = 0; k < pbo_.size(); ++k) {
+        const int slot = (int)((captured_ + k) % pbo_.size());
+        if (pending_[slot] >= 0) collect(slot);
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    jobReady_.notify_all();
+    for (std::thread& t : workers_) t.join();
+    workers_.clear();
+    glDeleteBuffers((GLsizei)pbo_.size(), pbo_.data());
+    pbo_.clear();
+    fences_.clear();
+    pending_.clear();
+    freeBuffers_.clear();
+    open_ = false;
+    return error_.empty();
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// --- 可视化程序的逐帧截图 (视觉回归用) ---
+// TakeScreenshot 每帧都在渲染线程上同步回读 GPU 并编码 PNG，会把帧率拖到个位数。
+// 这里把回读与编码都移出关键路径：
+//   - 回读：每帧 glReadPixels 进 readbackDepth 个像素缓冲对象 (PBO) 中的下一个，立即返回；
+//     readbackDepth - 1 帧之后 GPU 早已拷完，再映射出来，基本不等待。
+//   - 编码：映射出的像素交给 workers 个编码线程翻转并写成 PNG 或 PAM (无压缩)，像素缓冲循环复用。
+// 编码排队超过 maxQueued 帧时 capture() 等待编码线程，不丢帧 (回归比对要求帧序列完整)。
+// 需要在 InitWindow 之后 open()，在 CloseWindow 之前 close()。GL 入口取自 raylib 的 rlgl (GLAD) 加载结果，
+// 因此截图离不开真实的 OpenGL 3.2 上下文与显示：--headless 只是隐藏窗口，没有显示器的机器上要在 Xvfb 等虚拟显示里运行。
+enum class CaptureFormat { Png, Pam };
+
+struct CaptureOptions {
+    std::string directory;  // 为空表示不截图；文件名为 frame_000000.png 等
+    CaptureFormat format = CaptureFormat::Png;
+    unsigned workers = 0;   // 0 表示硬件并发数
+    int readbackDepth = 3;
+    size_t maxQueued = 16;
+    bool headless = false;  // 隐藏窗口且不限帧率
+    uint64_t frames = 0;    // 截满这么多帧后退出，0 表示直到关闭窗口
+
+    bool enabled() const { return !directory.empty(); }
+};
+
+class FrameCapture {
+public:
+    FrameCapture() = default;
+    ~FrameCapture() { close(); }
+    FrameCapture(const FrameCapture&) = delete;
+    FrameCapture& operator=(const FrameCapture&) = delete;
+
+    // GL 上下文不支持 PBO / fence 时返回 false，见 error()
+    bool open(const CaptureOptions& options, int width, int height);
+    // 在绘制完成、EndDrawing 之前调用：排入当前后缓冲的异步回读，并把已完成的较早一帧交给编码线程
+    void capture();
+    // 取回还在 GPU 上的帧并等待全部编码完成；有帧写失败时返回 false
+    bool close();
+
+    bool isOpen() const { return open_; }
+    // 已截满 options.frames 帧
+    bool finished() const { return open_ && options_.frames && captured_ >= options_.frames; }
+    uint64_t framesCaptured() const { return captured_; }
+    uint64_t framesWritten() const;
+    double lastReadbackMs() const { return lastReadbackMs_; } // 映射 + 拷出一帧的耗时
+    double queueWaitMs() const { return queueWaitMs_; }       // 因编码排满而等待的累计时间
+    const std::string& error() const { return error_; }
+
+private:
+    struct Job {
+        uint64_t index;
+        std::vector<unsigned char> pixels;
+    };
+
+    void collect(int slot);
+    void workerLoop();
+    bool encode(Job& job, std::string& err) const;
+
+    CaptureOptions options_;
+    int width_ = 0;
+    int height_ = 0;
+    size_t frameBytes_ = 0;
+    bool open_ = false;
+
+    // 回读环：pbo_[i] 里装着第 pending_[i] 帧 (-1 表示空)
+    std::vector<unsigned int> pbo_;
+    std::vector<void*> fences_;
+    std::vector<int64_t> pending_;
+    uint64_t captured_ = 0;
+    double lastReadbackMs_ = 0.0;
+    double queueWaitMs_ = 0.0;
+
+    // 编码线程
+    std::vector<std::thread> workers_;
+    mutable std::mutex mutex_;
+    std::condition_variable jobReady_;
+    std::condition_variable jobDone_;
+    std::deque<Job> jobs_;
+    std::vector<std::vector<unsigned char>> freeBuffers_;
+    size_t inFlight_ = 0;
+    bool stopping_ = false;
+    uint64_t written_ = 0;
+    std::string error_;
+};
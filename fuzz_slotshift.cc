@@ -0,0 +1,615 @@
+// fuzz_slotshift：内核变体的差分模糊测试。
+// 从字节流构造场景 (随机场景与刻意构造的边界情况)，断言注册表里的每个变体、批量切片合并、
+// 多边形顺序、增量追踪、逐帧差分与异步接口的结果都与参考实现 calculateSegmentShift 在其登记的误差内一致；
+// 另从同一输入构造占用栅格场景，栅格内核与方向距离场须与对等价多边形运行参考实现逐位一致。
+// 默认是独立驱动：用固定种子生成字节流逐个运行，失败时把输入写进文件，可用 --replay 复现。
+// 以 -DSLOTSHIFT_LIBFUZZER=1 编译时只提供 LLVMFuzzerTestOneInput，由 libFuzzer 驱动 (见 CMakeLists.txt)。
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "distance_field.h"
+#include "obstacle_diff.h"
+#include "occupancy_grid.h"
+#include "scenario.h"
+#include "shift_async.h"
+#include "shift_variants.h"
+#include "slot_shift.h"
+#include "slot_tracker.h"
+
+namespace {
+
+// --- 字节流 ---
+// 输入读完之后一律读到 0，因此任何字节串都对应一个合法场景，libFuzzer 可以随意变异
+class FuzzBytes {
+public:
+    FuzzBytes(const uint8_t* data, size_t size) : data_(data), size_(size) {}
+
+    uint8_t byte() { return pos_ < size_ ? data_[pos_++] : 0; }
+    uint32_t u32() {
+        uint32_t v = 0;
+        for (int i = 0; i < 4; ++i) v = v << 8 | byte();
+        return v;
+    }
+    // [0, 1)
+    double unit() { return u32() * (1.0 / 4294967296.0); }
+    double uniform(double lo, double hi) { return lo + (hi - lo) * unit(); }
+    // 8 个字节原样解释为 double，可能是 NaN、无穷或非规格化数
+    double raw() {
+        uint64_t bits = 0;
+        for (int i = 0; i < 8; ++i) bits = bits << 8 | byte();
+        double v;
+        std::memcpy(&v, &bits, sizeof(v));
+        return v;
+    }
+    // [0, n)
+    int below(int n) { return n > 0 ? (int)(byte() % (unsigned)n) : 0; }
+
+private:
+    const uint8_t* data_;
+    size_t size_;
+    size_t pos_ = 0;
+};
+
+// --- 场景 ---
+struct FuzzScene {
+    std::vector<std::vector<Vec2>> polygons;
+    std::vector<Segment> segments;
+    double margin = 3.0;
+    double detectionRange = 10.0;
+};
+
+// 坐标尺度：常规、巨大 (接近 double 上限时减法会溢出成无穷)、极小
+double pickScale(FuzzBytes& in) {
+    switch (in.below(8)) {
+    case 5: return 1e12;
+    case 6: return 1e300;
+    case 7: return 1e-9;
+    default: return 100.0;
+    }
+}
+
+double pickBandWidth(FuzzBytes& in) {
+    switch (in.below(8)) {
+    case 0: return 0.0;
+    case 1: return 3.0;
+    case 2: return 10.0;
+    case 3: return -in.uniform(0.0, 5.0); // 负宽度：探测带为空
+    case 4: return 1e300;
+    case 5: return in.raw();
+    default: return in.uniform(0.0, 50.0);
+    }
+}
+
+Segment makeSegment(FuzzBytes& in, double scale) {
+    Segment s;
+    s.start = {in.uniform(-scale, scale), in.uniform(-scale, scale)};
+    const double len = in.uniform(0.0, scale);
+    switch (in.below(8)) {
+    case 0: // 沿坐标轴：推离方向也沿坐标轴，边界上的顶点可以精确构造
+    case 1: {
+        const int axis = in.below(4);
+        const Vec2 dirs[4] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+        s.start = {std::floor(s.start.x), std::floor(s.start.y)};
+        s.end = s.start + dirs[axis] * std::floor(len + 1);
+        s.heading = dirs[(axis + 1 + 2 * in.below(2)) % 4];
+        return s;
+    }
+    case 2: // 零长度：getDir() 返回 {0, 0}，所有顶点的纵向投影都是 0
+        s.end = s.start;
+        break;
+    case 3: // 长度在 getDir() 的 1e-6 阈值附近
+        s.end = s.start + Vec2{in.uniform(0.0, 2e-6), in.uniform(0.0, 2e-6)};
+        break;
+    default:
+        s.end = s.start + Vec2{in.uniform(-len, len), in.uniform(-len, len)};
+        break;
+    }
+    switch (in.below(6)) {
+    case 0: // 退化的推离方向
+        s.heading = {0, 0};
+        break;
+    case 1: { // 与线段平行
+        s.heading = s.getDir();
+        break;
+    }
+    case 2: // 非单位长度
+        s.heading = Vec2{in.uniform(-1, 1), in.uniform(-1, 1)} * in.uniform(0.0, 1e3);
+        break;
+    case 3:
+        s.heading = {in.raw(), in.raw()};
+        break;
+    default: { // 常规：线段方向的法向
+        const Vec2 d = s.getDir();
+        s.heading = in.below(2) ? Vec2{-d.y, d.x} : Vec2{d.y, -d.x};
+        break;
+    }
+    }
+    return s;
+}
+
+// 顶点：大部分落在某条线段附近，一部分精确落在纵向窗口端点或横向带边界上
+Vec2 makeVertex(FuzzBytes& in, const FuzzScene& scene, double scale, const std::vector<Vec2>& poly) {
+    const Segment& s = scene.segments[(size_t)in.below((int)scene.segments.size())];
+    const double boundaries[] = {-scene.margin, scene.detectionRange, 0.0,
+                                 std::nextafter(-scene.margin, 0.0), std::nextafter(scene.detectionRange, 0.0)};
+    switch (in.below(10)) {
+    case 0: // 起点一侧的边界
+        return s.start + s.heading * boundaries[in.below(5)];
+    case 1: // 终点一侧的边界
+        return s.end + s.heading * boundaries[in.below(5)];
+    case 2:
+        return in.below(2) ? s.start : s.end;
+    case 3:
+        if (!poly.empty()) return poly[(size_t)in.below((int)poly.size())]; // 重复顶点
+        return s.start;
+    case 4:
+        return {in.raw(), in.raw()};
+    case 5:
+        return {in.uniform(-scale, scale), in.uniform(-scale, scale)};
+    default: { // 线段附近：纵向略超出窗口，横向覆盖整个探测带及两侧
+        const Vec2 d = s.getDir();
+        const double t = in.uniform(-0.1, 1.1) * s.length();
+        const double w = in.uniform(-1.5, 1.5) * (std::fabs(scene.margin) + std::fabs(scene.detectionRange) + 1.0);
+        return s.start + d * t + s.heading * w;
+    }
+    }
+}
+
+FuzzScene makeScene(FuzzBytes& in) {
+    FuzzScene scene;
+    const double scale = pickScale(in);
+    scene.margin = pickBandWidth(in);
+    scene.detectionRange = pickBandWidth(in);
+    const int segments = 1 + in.below(8);
+    for (int i = 0; i < segments; ++i) scene.segments.push_back(makeSegment(in, scale));
+    const int polygons = in.below(17);
+    for (int p = 0; p < polygons; ++p) {
+        std::vector<Vec2> poly;
+        const int vertices = in.below(13); // 允许空多边形
+        for (int v = 0; v < vertices; ++v) poly.push_back(makeVertex(in, scene, scale, poly));
+        scene.polygons.push_back(poly);
+    }
+    return scene;
+}
+
+// --- 判定 ---
+bool sameShift(double a, double b, double tolerance) {
+    if (std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b);
+    return tolerance == 0.0 ? a == b : std::fabs(a - b) <= tolerance;
+}
+
+std::string describe(const FuzzScene& scene, size_t segment) {
+    std::ostringstream os;
+    os.precision(17);
+    const Segment& s = scene.segments[segment];
+    os << "margin " << scene.margin << " range " << scene.detectionRange << "\n  segment " << segment << ": start ("
+       << s.start.x << ", " << s.start.y << ") end (" << s.end.x << ", " << s.end.y << ") heading (" << s.heading.x
+       << ", " << s.heading.y << ")\n  " << scene.polygons.size() << " polygons";
+    return os.str();
+}
+
+AsyncShiftService& asyncService(int& queue) {
+    static AsyncShiftService service;
+    static const int q = [] {
+        AsyncQueueConfig config;
+        config.windowUs = 0;
+        return service.createQueue(config);
+    }();
+    queue = q;
+    return service;
+}
+
+// 返回空串表示全部一致，否则为第一处不一致的说明
+std::string checkScene(const FuzzScene& scene, unsigned threads) {
+    const size_t n = scene.segments.size();
+    const ObstacleSet set = buildObstacleSet(scene.polygons);
+    std::vector<double> expected(n), got(n);
+    for (size_t i = 0; i < n; ++i) {
+        expected[i] = calculateSegmentShift(scene.segments[i], scene.polygons, scene.margin, scene.detectionRange);
+    }
+
+    // 性质：推移量不是 NaN，落在 [0, margin + detectionRange] 内
+    for (size_t i = 0; i < n; ++i) {
+        const double r = expected[i];
+        if (std::isnan(r) || r < 0 || (r > 0 && !(r <= scene.margin + scene.detectionRange))) {
+            return "reference out of range: " + std::to_string(r) + "\n  " + describe(scene, i);
+        }
+    }
+
+    ShiftProblem problem;
+    problem.segments = scene.segments.data();
+    problem.segmentCount = n;
+    problem.obstacles = set;
+    problem.polygons = &scene.polygons;
+    problem.margin = scene.margin;
+    problem.detectionRange = scene.detectionRange;
+    problem.threads = threads;
+    for (const ShiftVariant& v : shiftVariants()) {
+        std::fill(got.begin(), got.end(), -1.0);
+        v.run(problem, got.data());
+        for (size_t i = 0; i < n; ++i) {
+            if (!sameShift(got[i], expected[i], v.tolerance)) {
+                std::ostringstream os;
+                os.precision(17);
+                os << v.name << " = " << got[i] << ", reference = " << expected[i] << "\n  " << describe(scene, i);
+                return os.str();
+            }
+        }
+    }
+
+    // 性质：障碍物任意切成两组分别计算，取最大值与整体一致 (可视化程序的静态 / 行人拆分依赖这一点)
+    const ObstacleView view = set;
+    const size_t polygons = view.polygonCount();
+    for (size_t cut = 0; cut <= polygons; cut += std::max<size_t>(1, polygons / 3)) {
+        std::vector<double> a(n), b(n);
+        calculateSegmentShiftBatch(scene.segments.data(), n, view.slice(0, cut), scene.margin, scene.detectionRange,
+                                   a.data());
+        calculateSegmentShiftBatch(scene.segments.data(), n, view.slice(cut, polygons - cut), scene.margin,
+                                   scene.detectionRange, b.data());
+        for (size_t i = 0; i < n; ++i) {
+            if (!sameShift(std::max(a[i], b[i]), expected[i], 0.0)) {
+                return "slice at polygon " + std::to_string(cut) + " disagrees\n  " + describe(scene, i);
+            }
+        }
+    }
+
+    // 性质：与多边形顺序无关
+    std::vector<std::vector<Vec2>> reversed(scene.polygons.rbegin(), scene.polygons.rend());
+    for (size_t i = 0; i < n; ++i) {
+        const double r = calculateSegmentShift(scene.segments[i], reversed, scene.margin, scene.detectionRange);
+        if (!sameShift(r, expected[i], 0.0)) return "polygon order changes the result\n  " + describe(scene, i);
+    }
+
+    // 增量追踪：先放入错位的多边形与一个多余的障碍物，再移动 / 删除到最终场景，目标推移量与整体计算一致
+    SlotTrackerConfig tc;
+    tc.margin = scene.margin;
+    tc.detectionRange = scene.detectionRange;
+    SlotTracker tracker;
+    if (!tracker.reset(scene.segments, tc)) return "tracker reset failed: " + tracker.error();
+    const size_t polyCount = scene.polygons.size();
+    for (size_t p = 0; p < polyCount; ++p) {
+        tracker.addObstacle(p, p % 2 ? scene.polygons[(p + 1) % polyCount] : scene.polygons[p]);
+    }
+    const uint64_t extra = polyCount;
+    if (polyCount) tracker.addObstacle(extra, scene.polygons[0]);
+    tracker.update();
+    for (size_t p = 1; p < polyCount; p += 2) tracker.moveObstacle(p, scene.polygons[p]);
+    if (polyCount) tracker.removeObstacle(extra);
+    tracker.update();
+    for (size_t i = 0; i < n; ++i) {
+        if (!sameShift(tracker.targets()[i], expected[i], 0.0)) {
+            std::ostringstream os;
+            os.precision(17);
+            os << "tracker = " << tracker.targets()[i] << ", reference = " << expected[i] << "\n  " << describe(scene, i);
+            return os.str();
+        }
+    }
+
+    // 逐帧差分：上一帧是错位、缺失或多余的多边形，整帧重发最终场景后，两种匹配方式的目标推移量都与整体计算一致
+    std::vector<std::vector<Vec2>> previous;
+    std::vector<uint64_t> previousIds;
+    for (size_t p = 0; p < polyCount; ++p) {
+        if (p % 3 == 2) continue;
+        previous.push_back(p % 3 ? scene.polygons[(p + 1) % polyCount] : scene.polygons[p]);
+        previousIds.push_back(p);
+    }
+    if (polyCount) {
+        previous.push_back(scene.polygons[0]);
+        previousIds.push_back(extra);
+    }
+    const ObstacleSet previousSet = buildObstacleSet(previous);
+    std::vector<uint64_t> ids(polyCount);
+    for (size_t p = 0; p < polyCount; ++p) ids[p] = p;
+    for (int byId = 0; byId < 2; ++byId) {
+        SlotTracker diffTracker;
+        ObstacleFrameDiff diff;
+        diffTracker.reset(scene.segments, tc);
+        if (!diff.apply(previousSet, byId ? previousIds.data() : nullptr, diffTracker) ||
+            !diff.apply(set, byId ? ids.data() : nullptr, diffTracker)) {
+            return "obstacle diff failed: " + diff.error();
+        }
+        diffTracker.update();
+        const ObstacleDiffStats& ds = diff.lastStats();
+        if (ds.unchanged + ds.moved + ds.added != polyCount || diffTracker.obstacleCount() != polyCount) {
+            return std::string("obstacle diff (") + (byId ? "ids" : "hashes") + ") lost track of polygons";
+        }
+        for (size_t i = 0; i < n; ++i) {
+            if (!sameShift(diffTracker.targets()[i], expected[i], 0.0)) {
+                return std::string("obstacle diff (") + (byId ? "ids" : "hashes") + ") disagrees\n  " +
+                       describe(scene, i);
+            }
+        }
+    }
+
+    // 异步接口：经过快照、拼批与拆分后结果不变
+    int queue = 0;
+    AsyncShiftService& service = asyncService(queue);
+    AsyncWorld world;
+    world.obstacles = std::make_shared<ObstacleSet>(set);
+    world.margin = scene.margin;
+    world.detectionRange = scene.detectionRange;
+    service.setWorld(world);
+    const AsyncShiftResult async = service.submit(queue, scene.segments).get();
+    if (!async.ok) return "async submission failed: " + async.error;
+    for (size_t i = 0; i < n; ++i) {
+        if (!sameShift(async.shifts[i], expected[i], 0.0)) return "async result disagrees\n  " + describe(scene, i);
+    }
+    return std::string();
+}
+
+// --- 占用栅格 ---
+// 栅格内核的参考是对 occupancyPolygons (每个占用格子一个正方形) 运行参考实现
+struct GridScene {
+    OccupancyGrid grid;
+    std::vector<Segment> segments;
+    double margin = 3.0;
+    double detectionRange = 10.0;
+    DistanceFieldConfig field;
+};
+
+// 起点落在角点上或附近，方向覆盖精确沿轴、几乎沿轴 (带 1e-16 量级的偏差，如直接由 cos(90°) 算出的方向) 与任意旋转
+Segment makeGridSegment(FuzzBytes& in, const OccupancyGrid& g) {
+    const double cell = g.cellSize;
+    const int64_t cx = (int64_t)in.below(g.width + 5) - 2, cy = (int64_t)in.below(g.height + 5) - 2;
+    Segment s;
+    s.start = g.corner(cx, cy);
+    if (in.below(3) == 0) s.start = s.start + Vec2{in.uniform(-cell, cell), in.uniform(-cell, cell)};
+    const double len = in.below(2) ? (1 + in.below(24)) * cell : in.uniform(0.0, 30.0 * cell);
+    const double kHalfPi = 1.57079632679489661923;
+    double angle = in.below(4) * kHalfPi;
+    switch (in.below(6)) {
+    case 0:
+    case 1: { // 精确沿轴
+        const Vec2 dirs[4] = {{1, 0}, {0, 1}, {-1, 0}, {0, -1}};
+        const int axis = in.below(4);
+        s.end = s.start + dirs[axis] * len;
+        const double magnitude = in.below(2) ? 1.0 : in.uniform(0.01, 100.0);
+        s.heading = dirs[(axis + 1 + 2 * in.below(2)) % 4] * magnitude;
+        return s;
+    }
+    case 2: // 几乎沿轴
+        angle += (in.below(2) ? 1 : -1) * std::pow(10.0, -in.uniform(5.0, 17.0));
+        break;
+    case 3: // 任意旋转
+        angle = in.uniform(0.0, 4 * kHalfPi);
+        break;
+    case 4: { // 线段任意方向，heading 几乎沿轴
+        const double a = in.uniform(0.0, 4 * kHalfPi);
+        s.end = s.start + Vec2{std::cos(a), std::sin(a)} * len;
+        const double b = in.below(4) * kHalfPi + in.uniform(-1e-9, 1e-9);
+        s.heading = {std::cos(b), std::sin(b)};
+        return s;
+    }
+    default: { // 通用的刁钻线段，平移到栅格附近
+        s = makeSegment(in, (g.width + g.height + 1) * cell);
+        const Vec2 center = g.corner(g.width / 2, g.height / 2);
+        s.start = s.start + center;
+        s.end = s.end + center;
+        return s;
+    }
+    }
+    const Vec2 d = {std::cos(angle), std::sin(angle)};
+    s.end = s.start + d * len;
+    s.heading = in.below(2) ? Vec2{-d.y, d.x} : Vec2{d.y, -d.x};
+    return s;
+}
+
+GridScene makeGridScene(FuzzBytes& in) {
+    GridScene scene;
+    const int width = in.below(97), height = in.below(97);
+    double cell = 1.0;
+    switch (in.below(6)) {
+    case 0: cell = 0.5; break;
+    case 1: cell = 0.1; break;
+    case 2: cell = 2.5; break;
+    case 3: cell = in.uniform(1e-3, 10.0); break;
+    default: break;
+    }
+    Vec2 origin = {0, 0};
+    switch (in.below(4)) {
+    case 0: origin = {std::floor(in.uniform(-100, 100)), std::floor(in.uniform(-100, 100))}; break;
+    case 1: origin = {in.uniform(-1e6, 1e6), in.uniform(-1e6, 1e6)}; break;
+    case 2: origin = {in.uniform(-10, 10), in.uniform(-10, 10)}; break;
+    default: break;
+    }
+    scene.grid.reset(width, height, cell, origin);
+    // 格子数可能远多于输入字节，占用情况由输入里的种子决定
+    ScenarioRng rng(in.u32());
+    const double densities[] = {0.0, 0.02, 0.1, 0.5, 1.0};
+    const double density = densities[in.below(5)];
+    for (int y = 0; y < height; ++y) {
+        for (int x = 0; x < width; ++x) {
+            if (rng.uniform() < density) scene.grid.set(x, y, true);
+        }
+    }
+    for (int k = in.below(4); k > 0 && width > 0 && height > 0; --k) {
+        const int x0 = in.below(width), y0 = in.below(height);
+        const int x1 = x0 + in.below(width - x0), y1 = y0 + in.below(height - y0);
+        for (int y = y0; y <= y1; ++y) scene.grid.fillRow(y, x0, x1);
+    }
+    scene.margin = pickBandWidth(in);
+    scene.detectionRange = pickBandWidth(in);
+    const int segments = 1 + in.below(8);
+    for (int i = 0; i < segments; ++i) scene.segments.push_back(makeGridSegment(in, scene.grid));
+    scene.field.blockSize = 2u << in.below(7);
+    scene.field.directions = in.below(4) ? kFieldAll : (uint32_t)in.below(16);
+    return scene;
+}
+
+std::string checkGridScene(const GridScene& scene) {
+    const size_t n = scene.segments.size();
+    const std::vector<std::vector<Vec2>> polygons = occupancyPolygons(scene.grid);
+    std::vector<double> batch(n);
+    GridShiftStats stats;
+    calculateSegmentShiftGridBatch(scene.segments.data(), n, scene.grid, scene.margin, scene.detectionRange,
+                                   batch.data(), stats);
+    DirectionalDistanceField field;
+    if (!field.build(scene.grid, scene.field)) return "distance field build failed: " + field.error();
+    for (size_t i = 0; i < n; ++i) {
+        const Segment& s = scene.segments[i];
+        const double expected = calculateSegmentShift(s, polygons, scene.margin, scene.detectionRange);
+        const double got = calculateSegmentShiftGrid(s, scene.grid, scene.margin, scene.detectionRange);
+        const double fromField = field.query(s, scene.margin, scene.detectionRange);
+        if (sameShift(got, expected, 0.0) && sameShift(batch[i], expected, 0.0) && sameShift(fromField, expected, 0.0)) {
+            continue;
+        }
+        std::ostringstream os;
+        os.precision(17);
+        os << "grid = " << got << " (batch " << batch[i] << ", field " << fromField << (field.covers(s) ? "" : " fallback")
+           << " block " << scene.field.blockSize << "), reference = " << expected << "\n  grid "
+           << scene.grid.width << "x" << scene.grid.height << " cell " << scene.grid.cellSize << " origin ("
+           << scene.grid.origin.x << ", " << scene.grid.origin.y << "), " << polygons.size() << " occupied, margin "
+           << scene.margin << " range " << scene.detectionRange << "\n  segment " << i << ": start (" << s.start.x
+           << ", " << s.start.y << ") end (" << s.end.x << ", " << s.end.y << ") heading (" << s.heading.x << ", "
+           << s.heading.y << ")";
+        return os.str();
+    }
+    return std::string();
+}
+
+std::string runInput(const uint8_t* data, size_t size, unsigned threads) {
+    FuzzBytes in(data, size);
+    const std::string failure = checkScene(makeScene(in), threads);
+    if (!failure.empty()) return failure;
+    // 栅格场景从输入末尾倒着读，与多边形场景的字节错开
+    std::vector<uint8_t> reversed(data, data + size);
+    std::reverse(reversed.begin(), reversed.end());
+    FuzzBytes gridIn(reversed.data(), reversed.size());
+    return checkGridScene(makeGridScene(gridIn));
+}
+
+} // namespace
+
+#if defined(SLOTSHIFT_LIBFUZZER)
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    const std::string failure = runInput(data, size, 2);
+    if (!failure.empty()) {
+        std::fprintf(stderr, "fuzz_slotshift: %s\n", failure.c_str());
+        std::abort();
+    }
+    return 0;
+}
+
+#else
+
+namespace {
+
+struct Options {
+    uint64_t seed = 1;
+    uint64_t iterations = 100000;
+    double seconds = 0.0; // >0 时按时长运行，忽略 iterations
+    size_t inputBytes = 1024;
+    unsigned threads = 2;
+    std::string replay;
+};
+
+void usage(const char* argv0) {
+    std::printf("usage: %s [--seed N] [--iterations N] [--seconds S] [--input-bytes N] [--threads N]\n"
+                "       %s --replay FILE\n",
+                argv0, argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", a.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--seed") {
+            opt.seed = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--iterations") {
+            opt.iterations = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--seconds") {
+            opt.seconds = std::atof(next());
+        } else if (a == "--input-bytes") {
+            opt.inputBytes = (size_t)std::max(1, std::atoi(next()));
+        } else if (a == "--threads") {
+            opt.threads = (unsigned)std::atoi(next());
+        } else if (a == "--replay") {
+            opt.replay = next();
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    return true;
+}
+
+bool readFile(const std::string& path, std::vector<uint8_t>& out) {
+    FILE* f = std::fopen(path.c_str(), "rb");
+    if (!f) return false;
+    uint8_t buf[4096];
+    size_t got;
+    while ((got = std::fread(buf, 1, sizeof(buf), f)) > 0) out.insert(out.end(), buf, buf + got);
+    std::fclose(f);
+    return true;
+}
+
+bool writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+    FILE* f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    const bool ok = std::fwrite(data.data(), 1, data.size(), f) == data.size();
+    return std::fclose(f) == 0 && ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+
+    if (!opt.replay.empty()) {
+        std::vector<uint8_t> data;
+        if (!readFile(opt.replay, data)) {
+            std::fprintf(stderr, "cannot read %s\n", opt.replay.c_str());
+            return 1;
+        }
+        const std::string failure = runInput(data.data(), data.size(), opt.threads);
+        std::printf("%s: %s\n", opt.replay.c_str(), failure.empty() ? "ok" : failure.c_str());
+        return failure.empty() ? 0 : 1;
+    }
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    std::vector<uint8_t> data(opt.inputBytes);
+    uint64_t iter = 0;
+    for (;; ++iter) {
+        if (opt.seconds > 0.0) {
+            if (std::chrono::duration<double>(Clock::now() - start).count() >= opt.seconds) break;
+        } else if (iter >= opt.iterations) {
+            break;
+        }
+        // 每次迭代一个子流，失败的输入可以单独复现
+        ScenarioRng rng = ScenarioRng(opt.seed).substream(iter);
+        const size_t size = 1 + (size_t)(rng.next() % opt.inputBytes);
+        for (size_t i = 0; i < size; ++i) data[i] = (uint8_t)rng.next();
+
+        const std::string failure = runInput(data.data(), size, opt.threads);
+        if (!failure.empty()) {
+            const std::string path = "fuzz-failure-" + std::to_string(opt.seed) + "-" + std::to_string(iter) + ".bin";
+            writeFile(path, std::vector<uint8_t>(data.begin(), data.begin() + (std::ptrdiff_t)size));
+            std::printf("iteration %llu: %s\nsaved input to %s (reproduce with --replay)\n", (unsigned long long)iter,
+                        failure.c_str(), path.c_str());
+            return 1;
+        }
+    }
+    std::printf("%llu scenes, %zu variants + slice / order / tracker / diff / async / grid / field properties, all consistent (%.1f s)\n",
+                (unsigned long long)iter, shiftVariants().size(),
+                std::chrono::duration<double>(Clock::now() - start).count());
+    return 0;
+}
+
+#endif
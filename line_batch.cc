@@ -0,0 +1,226 @@
+#include "line_batch.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "raymath.h"
+#include "rlgl.h"
+
+void LineBatch::beginRebuild(size_t edges, bool colored) {
+    culled_ = 0;
+    simplified_ = 0;
+    colored_ = colored;
+    vertices_.clear();
+    vertices_.reserve(edges * kFloatsPerEdge);
+    colors_.clear();
+    if (colored) colors_.reserve(edges * 6 * 4);
+}
+
+// 边 a->b 沿法线两侧各扩 halfWidth，得到 a+n, a-n, b-n, b+n 四个角
+void LineBatch::addEdge(double ax, double ay, double bx, double by, float halfWidth) {
+    double dx = bx - ax, dy = by - ay;
+    double len = std::sqrt(dx * dx + dy * dy);
+    double nx = 0.0, ny = 0.0;
+    if (len > 1e-9) {
+        nx = -dy / len * halfWidth;
+        ny = dx / len * halfWidth;
+    }
+    const float quad[4][2] = {
+        {(float)(ax + nx), (float)(ay + ny)},
+        {(float)(ax - nx), (float)(ay - ny)},
+        {(float)(bx - nx), (float)(by - ny)},
+        {(float)(bx + nx), (float)(by + ny)},
+    };
+    const int order[6] = {0, 1, 2, 0, 2, 3};
+    for (int k : order) {
+        vertices_.push_back(quad[k][0]);
+        vertices_.push_back(quad[k][1]);
+        vertices_.push_back(0.0f);
+    }
+}
+
+namespace {
+
+bool boundsOverlap(const Bounds& a, const Bounds& b) {
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+} // namespace
+
+// point(i) 返回第 i 个顶点 (Vec2)
+template <typename PointFn>
+void LineBatch::addPolygon(size_t n, PointFn point, const Bounds& bounds, float halfWidth, const LineBatchView* view) {
+    if (n == 0) return;
+    if (view && !boundsOverlap(bounds, view->viewport)) {
+        ++culled_;
+        return;
+    }
+    const double minFeature = view ? view->minFeature : 0.0;
+    if (minFeature <= 0.0) {
+        for (size_t i = 0; i < n; ++i) {
+            const Vec2 a = point(i), b = point(i + 1 == n ? 0 : i + 1);
+            addEdge(a.x, a.y, b.x, b.y, halfWidth);
+        }
+        return;
+    }
+    // 缩小到看不清细节时：顶点离上一个保留点不足 minFeature 的丢掉
+    kept_.clear();
+    kept_.push_back(0);
+    Vec2 last = point(0);
+    for (size_t i = 1; i < n; ++i) {
+        const Vec2 v = point(i);
+        const double dx = v.x - last.x, dy = v.y - last.y;
+        if (dx * dx + dy * dy >= minFeature * minFeature) {
+            kept_.push_back(i);
+            last = v;
+        }
+    }
+    const bool tiny = std::max(bounds.maxX - bounds.minX, bounds.maxY - bounds.minY) < minFeature;
+    if (tiny || kept_.size() < 3) {
+        // 整体只剩几个像素：画包围盒
+        addEdge(bounds.minX, bounds.minY, bounds.maxX, bounds.minY, halfWidth);
+        addEdge(bounds.maxX, bounds.minY, bounds.maxX, bounds.maxY, halfWidth);
+        addEdge(bounds.maxX, bounds.maxY, bounds.minX, bounds.maxY, halfWidth);
+        addEdge(bounds.minX, bounds.maxY, bounds.minX, bounds.minY, halfWidth);
+        ++simplified_;
+        return;
+    }
+    if (kept_.size() < n) ++simplified_;
+    for (size_t k = 0; k < kept_.size(); ++k) {
+        const Vec2 a = point(kept_[k]), b = point(kept_[k + 1 == kept_.size() ? 0 : k + 1]);
+        addEdge(a.x, a.y, b.x, b.y, halfWidth);
+    }
+}
+
+bool LineBatch::setPolygons(const std::vector<std::vector<Vec2>>& polys, size_t begin, size_t end, float thickness,
+                            uint64_t generation, const LineBatchView* view) {
+    if (hasGeneration_ && generation == generation_) return false;
+    size_t edges = 0;
+    for (size_t p = begin; p < end; ++p) edges += polys[p].size();
+    beginRebuild(edges, false);
+    for (size_t p = begin; p < end; ++p) {
+        const std::vector<Vec2>& poly = polys[p];
+        Bounds bounds = {0.0, 0.0, 0.0, 0.0};
+        if (view && !poly.empty()) {
+            bounds = {poly[0].x, poly[0].y, poly[0].x, poly[0].y};
+            for (const Vec2& v : poly) {
+                bounds.minX = std::min(bounds.minX, v.x);
+                bounds.minY = std::min(bounds.minY, v.y);
+                bounds.maxX = std::max(bounds.maxX, v.x);
+                bounds.maxY = std::max(bounds.maxY, v.y);
+            }
+        }
+        addPolygon(poly.size(), [&](size_t i) { return poly[i]; }, bounds, thickness * 0.5f, view);
+    }
+    generation_ = generation;
+    hasGeneration_ = true;
+    upload();
+    return true;
+}
+
+bool LineBatch::setPolygons(const ObstacleView& obstacles, float thickness, uint64_t generation,
+                            const LineBatchView* view) {
+    if (hasGeneration_ && generation == generation_) return false;
+    beginRebuild(obstacles.vertexCount(), false);
+    for (size_t p = 0; p < obstacles.polygonCount(); ++p) {
+        const uint32_t first = obstacles.offsets[p], count = obstacles.offsets[p + 1] - first;
+        addPolygon(count, [&](size_t i) { return Vec2{obstacles.xs[first + i], obstacles.ys[first + i]}; },
+                   obstacles.bounds[p], thickness * 0.5f, view);
+    }
+    generation_ = generation;
+    hasGeneration_ = true;
+    upload();
+    return true;
+}
+
+bool LineBatch::setSegments(const Segment* segs, const double* shifts, const Color* colors, size_t n, float thickness,
+                            uint64_t generation, const LineBatchView* view) {
+    if (hasGeneration_ && generation == generation_) return false;
+    beginRebuild(n, true);
+    for (size_t i = 0; i < n; ++i) {
+        const Segment& seg = segs[i];
+        const Vec2 offset = shifts ? seg.heading * shifts[i] : Vec2{0.0, 0.0};
+        const Vec2 a = seg.start + offset, b = seg.end + offset;
+        if (view) {
+            const Bounds& vp = view->viewport;
+            if (std::max(a.x, b.x) < vp.minX || std::min(a.x, b.x) > vp.maxX || std::max(a.y, b.y) < vp.minY ||
+                std::min(a.y, b.y) > vp.maxY) {
+                ++culled_;
+                continue;
+            }
+        }
+        addEdge(a.x, a.y, b.x, b.y, thickness * 0.5f);
+        const Color c = colors[i];
+        for (int k = 0; k < 6; ++k) {
+            colors_.push_back(c.r);
+            colors_.push_back(c.g);
+            colors_.push_back(c.b);
+            colors_.push_back(c.a);
+        }
+    }
+    generation_ = generation;
+    hasGeneration_ = true;
+    upload();
+    return true;
+}
+
+void LineBatch::upload() {
+    const int vertexCount = (int)(vertices_.size() / 3);
+    if (meshLoaded_ && vertexCount == mesh_.vertexCount && colored_ == meshColored_) {
+        // 顶点数没变 (例如只是平移)，原地覆盖顶点缓冲 (0 号) 与颜色缓冲 (3 号)
+        if (vertexCount > 0) {
+            UpdateMeshBuffer(mesh_, 0, vertices_.data(), (int)(vertices_.size() * sizeof(float)), 0);
+            if (colored_) UpdateMeshBuffer(mesh_, 3, colors_.data(), (int)colors_.size(), 0);
+        }
+        ++uploads_;
+        return;
+    }
+    if (meshLoaded_) {
+        mesh_.vertices = nullptr; // 顶点与颜色数组归 vertices_ / colors_ 所有，不能交给 UnloadMesh 释放
+        mesh_.colors = nullptr;
+        UnloadMesh(mesh_);
+        meshLoaded_ = false;
+    }
+    mesh_ = Mesh();
+    if (vertexCount == 0) return;
+    mesh_.vertexCount = vertexCount;
+    mesh_.triangleCount = vertexCount / 3;
+    mesh_.vertices = vertices_.data();
+    mesh_.colors = colored_ ? colors_.data() : nullptr;
+    UploadMesh(&mesh_, true);
+    mesh_.vertices = nullptr;
+    mesh_.colors = nullptr;
+    meshLoaded_ = true;
+    meshColored_ = colored_;
+    if (!materialLoaded_) {
+        material_ = LoadMaterialDefault();
+        materialLoaded_ = true;
+    }
+    ++uploads_;
+}
+
+void LineBatch::draw(Color color) const {
+    if (!meshLoaded_) return;
+    material_.maps[MATERIAL_MAP_DIFFUSE].color = color;
+    // 先把 raylib 内部积攒的即时绘制提交掉，保证与前后的 DrawXxx 调用的先后顺序
+    rlDrawRenderBatchActive();
+    // 屏幕坐标 y 轴朝下，三角形绕向会反过来，直接关掉背面剔除
+    rlDisableBackfaceCulling();
+    DrawMesh(mesh_, material_, MatrixIdentity());
+    rlEnableBackfaceCulling();
+}
+
+void LineBatch::unload() {
+    if (meshLoaded_) {
+        mesh_.vertices = nullptr;
+        mesh_.colors = nullptr;
+        UnloadMesh(mesh_);
+        meshLoaded_ = false;
+    }
+    if (materialLoaded_) {
+        UnloadMaterial(material_);
+        materialLoaded_ = false;
+    }
+    mesh_ = Mesh();
+    hasGeneration_ = false;
+}
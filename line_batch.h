@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "raylib.h"
+#include "slot_shift.h"
+
+// --- 批量线框绘制 (可视化程序用) ---
+// 把一组多边形的所有边展开成带宽度的四边形 (每条边两个三角形)，放进一个 Mesh 一次绘制，
+// 代替逐边 DrawLineEx。只有 generation 变化时才重建顶点；顶点数不变时原地更新 GPU 缓冲，否则重新上传。
+// 需要在 InitWindow 之后使用，并在 CloseWindow 之前 unload()。
+
+// 可选的视图裁剪与简化：包围盒与 viewport 不相交的多边形整个跳过；
+// minFeature > 0 时，顶点间距小于它的细节被合并，整体小于它的多边形只画包围盒。两者都是世界坐标单位。
+struct LineBatchView {
+    Bounds viewport;
+    double minFeature = 0.0;
+};
+
+class LineBatch {
+public:
+    LineBatch() = default;
+    ~LineBatch() { unload(); }
+    LineBatch(const LineBatch&) = delete;
+    LineBatch& operator=(const LineBatch&) = delete;
+
+    // polys[begin, end) 的全部边；返回本次是否重建了几何。
+    // view 非空时按它裁剪与简化，视图变化后调用方需要换一个 generation
+    bool setPolygons(const std::vector<std::vector<Vec2>>& polys, size_t begin, size_t end, float thickness,
+                     uint64_t generation, const LineBatchView* view = nullptr);
+    bool setPolygons(const std::vector<std::vector<Vec2>>& polys, float thickness, uint64_t generation,
+                     const LineBatchView* view = nullptr) {
+        return setPolygons(polys, 0, polys.size(), thickness, generation, view);
+    }
+    bool setPolygons(const ObstacleView& obstacles, float thickness, uint64_t generation,
+                     const LineBatchView* view = nullptr);
+    // 逐条线段、逐条着色：第 i 条沿 heading 推移 shifts[i] (shifts 为 nullptr 时不推移) 后画成 colors[i]。
+    // 带颜色的批次绘制时 draw() 的颜色与顶点色相乘，一般传 WHITE
+    bool setSegments(const Segment* segs, const double* shifts, const Color* colors, size_t n, float thickness,
+                     uint64_t generation, const LineBatchView* view = nullptr);
+
+    // 在当前变换 (包括 BeginMode2D 的相机) 下绘制
+    void draw(Color color) const;
+    void unload();
+
+    size_t edgeCount() const { return vertices_.size() / kFloatsPerEdge; }
+    uint64_t uploads() const { return uploads_; } // 累计上传 / 更新 GPU 缓冲的次数
+    // 最近一次重建时被视图裁掉 / 被简化的多边形数
+    size_t polygonsCulled() const { return culled_; }
+    size_t polygonsSimplified() const { return simplified_; }
+
+private:
+    static const size_t kFloatsPerEdge = 6 * 3; // 两个三角形，每个顶点 xyz
+
+    void beginRebuild(size_t edges, bool colored);
+    void addEdge(double ax, double ay, double bx, double by, float halfWidth);
+    template <typename PointFn>
+    void addPolygon(size_t n, PointFn point, const Bounds& bounds, float halfWidth, const LineBatchView* view);
+    void upload();
+
+    std::vector<float> vertices_;
+    std::vector<unsigned char> colors_; // 每顶点 RGBA，仅 setSegments 使用
+    bool colored_ = false;
+    Mesh mesh_ = {};
+    Material material_ = {};
+    bool meshLoaded_ = false;
+    bool meshColored_ = false;
+    bool materialLoaded_ = false;
+    bool hasGeneration_ = false;
+    uint64_t generation_ = 0;
+    uint64_t uploads_ = 0;
+    size_t culled_ = 0;
+    size_t simplified_ = 0;
+    std::vector<size_t> kept_; // 简化时保留的顶点下标，复用避免每次分配
+};
@@ -0,0 +1,227 @@
+#include "lot_view.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "camera_control.h"
+#include "line_batch.h"
+#include "perf_hud.h"
+#include "raylib.h"
+#include "static_layer.h"
+#include "trace.h"
+
+namespace {
+
+// 推移量 -> 颜色：0 为浅灰，其余在 蓝 -> 黄 -> 红 之间按 shift / maxShift 插值。预先算成查找表
+class ShiftPalette {
+public:
+    explicit ShiftPalette(double maxShift) : scale_((kLevels - 1) / std::max(maxShift, 1e-9)) {
+        const Color stops[3] = {{40, 110, 230, 255}, {250, 210, 30, 255}, {220, 30, 40, 255}};
+        for (int i = 0; i < kLevels; ++i) {
+            const float t = (float)i / (kLevels - 1) * 2.0f;
+            const int s = std::min(1, (int)t);
+            const float f = t - s;
+            const Color a = stops[s], b = stops[s + 1];
+            lut_[i] = {(unsigned char)(a.r + (b.r - a.r) * f), (unsigned char)(a.g + (b.g - a.g) * f),
+                       (unsigned char)(a.b + (b.b - a.b) * f), 255};
+        }
+    }
+
+    Color operator()(double shift) const {
+        if (!(shift > 0.0)) return {170, 170, 170, 200};
+        const int level = std::min(kLevels - 1, std::max(1, (int)(shift * scale_)));
+        return lut_[level];
+    }
+    Color at(float t) const { return lut_[std::min(kLevels - 1, std::max(0, (int)(t * (kLevels - 1))))]; }
+
+private:
+    static const int kLevels = 256;
+    double scale_;
+    Color lut_[kLevels];
+};
+
+} // namespace
+
+int runLotView(const LotConfig& config, unsigned threads, bool fullBatch, const CaptureOptions& captureOptions) {
+    const int screenWidth = 1600;
+    const int screenHeight = 1000;
+    if (captureOptions.headless) SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    InitWindow(screenWidth, screenHeight, "Segment Pushing - Whole Lot");
+    SetTargetFPS(captureOptions.headless ? 0 : 60);
+    FrameCapture capture;
+    if (captureOptions.enabled() && !capture.open(captureOptions, GetRenderWidth(), GetRenderHeight())) {
+        std::cerr << capture.error() << std::endl;
+        CloseWindow();
+        return 1;
+    }
+
+    ParkingLot lot = generateParkingLot(config);
+    const size_t n = lot.segments.size();
+    const double margin = config.margin, detectionRange = config.detectionRange;
+    std::vector<double> shifts(n, 0.0), reference(n, 0.0);
+
+    // 推移量是全部顶点贡献的最大值，可以按障碍物分组各自取最大再合并，结果逐位不变。
+    // 车辆、柱子、路沿不动，它们的贡献只在启动时算一次；缓存模式下每帧只对行人跑批量内核，
+    // 全量模式 (B 键 / --lot-full) 每帧对全部障碍物跑批量内核，用来观察内核本身的耗时
+    const ObstacleView allObstacles(lot.obstacles);
+    const ObstacleView staticObstacles = allObstacles.slice(0, lot.staticPolygonCount);
+    const ObstacleView movingObstacles =
+        allObstacles.slice(lot.staticPolygonCount, allObstacles.polygonCount() - lot.staticPolygonCount);
+    std::vector<double> staticShifts(n, 0.0), movingShifts(n, 0.0);
+    calculateSegmentShiftBatchParallel(lot.segments.data(), n, staticObstacles, margin, detectionRange,
+                                       staticShifts.data(), threads);
+    std::vector<Color> colors(n);
+    std::vector<Color> idealColors(n, Color{200, 200, 200, 255});
+    const ShiftPalette palette(margin + detectionRange);
+
+    const Camera2D homeCamera = fitCamera(lot.extent, screenWidth, screenHeight);
+    Camera2D camera = homeCamera;
+    const double outlineDetailPx = 2.0;
+    const float lineWidthPx = 1.5f;
+
+    // 静态图层：车辆、柱子、路沿与未推移的车位线；每帧只画行人与推移后的车位线
+    StaticLayer staticLayer;
+    LineBatch staticLines, idealLines, pedestrianLines, pushedLines;
+
+    PerfHud hud;
+    PhaseTimer frameTimer;
+    bool paused = false;
+    bool verify = false; // V：每帧再用逐条参考实现核对批量结果，不一致的线段画成紫色
+    double kernelMs = 0.0; // 本帧批量内核的耗时 (缓存模式下只含行人部分)
+    uint64_t frame = 0;
+    size_t mismatches = 0;
+
+    while (!WindowShouldClose() && !capture.finished()) {
+        SLOTSHIFT_TRACE_SCOPE("frame");
+        hud.pushFrameTime(frameTimer.lapMs());
+        PhaseTimer phase;
+
+        if (IsKeyPressed(KEY_F1)) hud.toggle();
+        if (IsKeyPressed(KEY_SPACE)) paused = !paused;
+        if (IsKeyPressed(KEY_V)) verify = !verify;
+        if (IsKeyPressed(KEY_B)) fullBatch = !fullBatch;
+        updateCamera(camera, homeCamera);
+        if (!paused) advancePedestrians(lot, capture.isOpen() ? 1.0 / 60.0 : GetFrameTime());
+        hud.setPhase("input", phase.lapMs());
+
+        {
+            SLOTSHIFT_TRACE_SCOPE("shift");
+            ShiftStats stats;
+            PhaseTimer kernel;
+            if (fullBatch) {
+                calculateSegmentShiftBatchParallel(lot.segments.data(), n, allObstacles, margin, detectionRange,
+                                                   shifts.data(), threads, stats);
+                kernelMs = kernel.lapMs();
+            } else {
+                calculateSegmentShiftBatchParallel(lot.segments.data(), n, movingObstacles, margin, detectionRange,
+                                                   movingShifts.data(), threads, stats);
+                kernelMs = kernel.lapMs();
+                for (size_t i = 0; i < n; ++i) shifts[i] = std::max(staticShifts[i], movingShifts[i]);
+            }
+            hud.setPhase("shift", phase.lapMs());
+            hud.setCounter("segments", n);
+            hud.setCounter("polygons", lot.obstacles.polygonCount());
+            hud.setCounter("vertices", lot.obstacles.vertexCount());
+            hud.setCounter("kernel polygons", fullBatch ? allObstacles.polygonCount() : movingObstacles.polygonCount());
+            hud.setCounter("culled", stats.polygonsCulled);
+            hud.setCounter("band hits", stats.bandHits);
+        }
+
+        for (size_t i = 0; i < n; ++i) colors[i] = palette(shifts[i]);
+        if (verify) {
+            SLOTSHIFT_TRACE_SCOPE("verify");
+            mismatches = 0;
+            for (size_t i = 0; i < n; ++i) {
+                reference[i] = calculateSegmentShift(lot.segments[i], lot.allWorld, margin, detectionRange);
+                // 批量内核与参考实现逐位一致，任何差异都算错
+                if (reference[i] != shifts[i]) {
+                    colors[i] = PURPLE;
+                    ++mismatches;
+                }
+            }
+            hud.setPhase("verify", phase.lapMs());
+            hud.setCounter("mismatches", mismatches);
+        }
+
+        // 行人与推移后的车位线每帧都变，generation 取帧号与视图的组合
+        const LineBatchView lineView = cameraView(camera, screenWidth, screenHeight, outlineDetailPx);
+        const float lineWidth = lineWidthPx / camera.zoom;
+        const uint64_t viewKey = cameraKey(camera);
+        const uint64_t frameKey = StaticLayer::mixKey(viewKey, frame++);
+        staticLines.setPolygons(lot.allWorld, 0, lot.staticPolygonCount, lineWidth, viewKey, &lineView);
+        idealLines.setSegments(lot.segments.data(), nullptr, idealColors.data(), n, lineWidth, viewKey, &lineView);
+        pedestrianLines.setPolygons(lot.allWorld, lot.staticPolygonCount, lot.allWorld.size(), lineWidth, frameKey,
+                                    &lineView);
+        pushedLines.setSegments(lot.segments.data(), shifts.data(), colors.data(), n, 2.0f * lineWidth, frameKey,
+                                &lineView);
+        hud.setCounter("segments drawn", n - pushedLines.polygonsCulled());
+        hud.setCounter("line uploads", staticLines.uploads() + idealLines.uploads() + pedestrianLines.uploads() +
+                                           pushedLines.uploads());
+        hud.setPhase("build", phase.lapMs());
+
+        {
+            SLOTSHIFT_TRACE_SCOPE("draw");
+            staticLayer.update(screenWidth, screenHeight, viewKey, RAYWHITE, [&]() {
+                BeginMode2D(camera);
+                staticLines.draw(Fade(DARKGRAY, 0.6f));
+                idealLines.draw(WHITE);
+                EndMode2D();
+            });
+            hud.setCounter("layer redraws", staticLayer.redraws());
+
+            BeginDrawing();
+            ClearBackground(RAYWHITE);
+            staticLayer.draw();
+            BeginMode2D(camera);
+            pedestrianLines.draw(MAROON);
+            pushedLines.draw(WHITE);
+            EndMode2D();
+
+            // 色标
+            const int barX = 10, barY = screenHeight - 40, barW = 300;
+            for (int x = 0; x < barW; ++x) DrawLine(barX + x, barY, barX + x, barY + 12, palette.at((float)x / barW));
+            DrawText("0", barX, barY + 14, 16, DARKGRAY);
+            DrawText(TextFormat("%.1f", margin + detectionRange), barX + barW - 30, barY + 14, 16, DARKGRAY);
+
+            DrawText(TextFormat("Whole lot: %d slots, %d segments", (int)lot.slots.size(), (int)n), 10, 10, 20, DARKGRAY);
+            DrawText("- Wheel / Right drag / 0: Zoom / Pan / Reset", 10, 35, 18, GRAY);
+            DrawText("- SPACE: Pause pedestrians   V: Verify against reference   B: Full batch / Static cache   F1: HUD", 10, 55,
+                     18, GRAY);
+            DrawText(fullBatch ? TextFormat("Full batch: %.2f ms / frame", kernelMs)
+                               : TextFormat("Static cache + pedestrians: %.2f ms / frame", kernelMs),
+                     10, 80, 20, fullBatch ? MAROON : DARKGRAY);
+            if (verify) {
+                DrawText(TextFormat("Mismatches: %d", (int)mismatches), 10, 105, 20, mismatches ? PURPLE : DARKGREEN);
+            }
+            hud.draw(screenWidth - 430, 10);
+        }
+        hud.setPhase("draw", phase.lapMs());
+
+        if (capture.isOpen()) {
+            SLOTSHIFT_TRACE_SCOPE("capture");
+            capture.capture();
+            hud.setPhase("capture", phase.lapMs());
+            hud.setCounter("captured", capture.framesCaptured());
+            hud.setCounter("encoded", capture.framesWritten());
+        }
+
+        {
+            SLOTSHIFT_TRACE_SCOPE("end_drawing");
+            EndDrawing();
+        }
+    }
+
+    staticLayer.unload();
+    staticLines.unload();
+    idealLines.unload();
+    pedestrianLines.unload();
+    pushedLines.unload();
+    if (capture.isOpen()) {
+        if (capture.close()) std::cout << "captured " << capture.framesWritten() << " frames to " << captureOptions.directory << std::endl;
+        else std::cerr << capture.error() << std::endl;
+    }
+    CloseWindow();
+    return 0;
+}
@@ -0,0 +1,13 @@
+#pragma once
+
+#include "frame_capture.h"
+#include "parking_lot.h"
+
+// --- 可视化程序的整场模式 (--lot) ---
+// 生成整个停车场，每帧让行人走一步，用批量内核一次算出全部车位边线的推移量；
+// 推移后的边线按推移量着色 (热力图)，整批一次绘制，上万条线段也能维持帧率。
+// threads 传给 calculateSegmentShiftBatchParallel (0 表示硬件并发数)。
+// fullBatch 为初始模式 (运行中 B 键切换)：true 每帧对全部障碍物跑批量内核，HUD 显示的就是整场内核的耗时；
+// false 时静止障碍物的贡献只在启动时算一次，每帧只对行人跑内核。两种模式结果逐位一致。
+// 开启截图时行人按固定的 1/60 s 步进，同一种子每次截出的帧序列相同。返回进程退出码。
+int runLotView(const LotConfig& config, unsigned threads, bool fullBatch, const CaptureOptions& captureOptions);
@@ -2,81 +2,126 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
 #include "raylib.h"
+#include "camera_control.h"
+#include "frame_capture.h"
+#include "line_batch.h"
+#include "lot_view.h"
+#include "perf_hud.h"
+#include "recording.h"
+#include "scenario.h"
+#include "shift_publisher.h"
+#include "static_layer.h"
+#include "slot_shift.h"
+#include "spsc_ring.h"
+#include "trace.h"
 
-// --- 基础数学结构 ---
-struct Vec2 {
-    double x, y;
-    Vec2 operator+(const Vec2& b) const { return {x + b.x, y + b.y}; }
-    Vec2 operator-(const Vec2& b) const { return {x - b.x, y - b.y}; }
-    Vec2 operator*(double s) const { return {x * s, y * s}; }
-    double dot(const Vec2& b) const { return x * b.x + y * b.y; }
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+double msBetween(Clock::time_point a, Clock::time_point b) {
+    return std::chrono::duration<double, std::milli>(b - a).count();
+}
+
+// --- 流水线各级之间传递的数据 ---
+// 渲染线程采样输入 -> 组装线程生成障碍物 -> 计算线程求推移量并平滑 -> 渲染线程绘制。
+// 每一项都带着进入队列的时间，取出时就能算出在队列里等了多久。
+struct InputSnapshot {
+    uint64_t seq = 0;
+    Clock::time_point captured;
+    Clock::time_point enqueued;
+    Vec2 mouse{0, 0};
+    double segLength = 0.0;
 };
 
-struct Segment {
-    Vec2 start;
-    Vec2 end;
-    Vec2 heading; // 推离方向 (Normal)
+struct WorldFrame {
+    uint64_t seq = 0;
+    Clock::time_point captured;
+    Clock::time_point enqueued;
+    double inputWaitMs = 0.0;
+    double assembleMs = 0.0;
+    Segment ideal{};
+    std::vector<std::vector<Vec2>> allWorld; // 绘制用
+    ObstacleSet worldSet;                    // 计算用
+};
 
-    Vec2 getDir() const {
-        Vec2 d = end - start;
-        double len = std::sqrt(d.x * d.x + d.y * d.y);
-        return (len > 1e-6) ? Vec2{d.x / len, d.y / len} : Vec2{0, 0};
-    }
-    double length() const {
-        Vec2 d = end - start;
-        return std::sqrt(d.x * d.x + d.y * d.y);
-    }
+struct ShiftFrame {
+    WorldFrame world;
+    Clock::time_point enqueued;
+    double worldWaitMs = 0.0;
+    double shiftMs = 0.0;
+    double targetShift = 0.0;
+    ShiftStats stats;
 };
 
-// --- 生成复杂多边形辅助函数 ---
-std::vector<Vec2> CreateComplexPoly(Vec2 center, int sides, double avgRadius) {
-    std::vector<Vec2> poly;
-    for (int i = 0; i < sides; ++i) {
-        double angle = i * (2.0 * PI / sides);
-        // 随机改变半径，产生凹凸感
-        double r = avgRadius * (0.6 + (double)GetRandomValue(0, 80) / 100.0);
-        poly.push_back({ center.x + r * cos(angle), center.y + r * sin(angle) });
-    }
-    return poly;
+void writeTrace(const char* path) {
+    traceEnable(false);
+    if (traceWriteChromeJson(path)) std::cout << "trace written to " << path << std::endl;
+    else std::cerr << "failed to write trace " << path << std::endl;
 }
 
-// --- 核心判定逻辑：带探测范围限制 ---
-double calculateSegmentShift(const Segment& seg, const std::vector<std::vector<Vec2>>& allPolys, double margin, double detectionRange) {
-    double maxShift = 0.0;
-    Vec2 dir = seg.getDir();
-    double segLen = seg.length();
-    
-    for (const auto& poly : allPolys) {
-        for (const auto& v : poly) {
-            Vec2 vToStart = v - seg.start;
-            double projLen = vToStart.dot(dir);
-
-            // 1. 纵向范围判定（是否在线段长度内）
-            if (projLen >= 0 && projLen <= segLen) {
-                // 2. 横向投影距离（相对于理想位置）
-                double dist = vToStart.dot(seg.heading);
-                
-                // 3. 有效范围过滤：
-                // 只有当障碍物顶点在 [理想位置] 到 [理想位置 + detectionRange] 之间时才考虑
-                // 我们允许 dist 稍微小于 0 (比如 -10)，以确保平滑处理已经在背后的物体
-                if (dist < detectionRange && dist > -margin) {
-                    double currentPush = dist + margin;
-                    if (currentPush > maxShift) {
-                        maxShift = currentPush;
-                    }
-                }
-            }
-        }
+} // namespace
+
+int main(int argc, char** argv) {
+    // 场景种子：相同种子每次运行生成完全相同的障碍物
+    uint64_t sceneSeed = 20240601;
+    // --trace out.json：记录每帧各阶段与内核调用，退出时导出 Chrome trace-event JSON
+    const char* tracePath = nullptr;
+    // --record out.rec：逐帧录制内核输入与输出，可用 replay_slotshift 离线重放比对
+    const char* recordPath = nullptr;
+    // --lot：整场模式，--lot-bays / --lot-slots 调整规模 (例如 16 x 160 约一万条线段)，--threads 为批量内核线程数，
+    // --lot-full 以每帧全量计算启动 (默认缓存静止障碍物的贡献)
+    bool lotMode = false;
+    bool lotFullBatch = false;
+    LotConfig lotConfig;
+    unsigned lotThreads = 0;
+    // --capture DIR：逐帧截图 (异步回读 + 编码线程池)，--capture-format png|pam，--capture-workers N，
+    // --capture-frames N 截满后退出，--headless 隐藏窗口且不限帧率
+    CaptureOptions captureOptions;
+    for (int i = 1; i < argc; ++i) {
+        if (std::strcmp(argv[i], "--seed") == 0 && i + 1 < argc) sceneSeed = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--trace") == 0 && i + 1 < argc) tracePath = argv[++i];
+        else if (std::strcmp(argv[i], "--record") == 0 && i + 1 < argc) recordPath = argv[++i];
+        else if (std::strcmp(argv[i], "--lot") == 0) lotMode = true;
+        else if (std::strcmp(argv[i], "--lot-full") == 0) lotFullBatch = true;
+        else if (std::strcmp(argv[i], "--lot-bays") == 0 && i + 1 < argc) lotConfig.bays = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--lot-slots") == 0 && i + 1 < argc) lotConfig.slotsPerRow = std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc) lotThreads = (unsigned)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--capture") == 0 && i + 1 < argc) captureOptions.directory = argv[++i];
+        else if (std::strcmp(argv[i], "--capture-format") == 0 && i + 1 < argc)
+            captureOptions.format = std::strcmp(argv[++i], "pam") == 0 ? CaptureFormat::Pam : CaptureFormat::Png;
+        else if (std::strcmp(argv[i], "--capture-workers") == 0 && i + 1 < argc) captureOptions.workers = (unsigned)std::atoi(argv[++i]);
+        else if (std::strcmp(argv[i], "--capture-frames") == 0 && i + 1 < argc) captureOptions.frames = std::strtoull(argv[++i], nullptr, 10);
+        else if (std::strcmp(argv[i], "--headless") == 0) captureOptions.headless = true;
+    }
+    if (tracePath) {
+        traceSetThreadName("main");
+        traceEnable(true);
+    }
+    if (lotMode) {
+        lotConfig.seed = sceneSeed;
+        const int rc = runLotView(lotConfig, lotThreads, lotFullBatch, captureOptions);
+        if (tracePath) writeTrace(tracePath);
+        return rc;
     }
-    return maxShift;
-}
 
-int main() {
     // 1. 初始化窗口
     const int screenWidth = 2000;
     const int screenHeight = 700;
+    if (captureOptions.headless) SetConfigFlags(FLAG_WINDOW_HIDDEN);
     InitWindow(screenWidth, screenHeight, "Segment Pushing - Bounded Range");
+    FrameCapture capture;
+    if (captureOptions.enabled() && !capture.open(captureOptions, GetRenderWidth(), GetRenderHeight())) {
+        std::cerr << capture.error() << std::endl;
+        CloseWindow();
+        return 1;
+    }
 
     // 2. 初始化线段属性
     Vec2 idealBasePos = {300, 150};
@@ -84,89 +129,313 @@ int main() {
     Vec2 heading = {1, 0};      // 线段受压后向右移动
     double margin = 30.0;       // 必须保持的安全距离
     double detectionRange = 600.0; // 探测距离：只考虑线段右侧100像素内的物体
-    double currentShift = 0.0;
 
     // 3. 创建静态障碍物
     std::vector<std::vector<Vec2>> staticObstacles;
-    staticObstacles.push_back(CreateComplexPoly({250, 200}, 10, 40));
-    staticObstacles.push_back(CreateComplexPoly({280, 500}, 8, 55));
+    ScenarioRng rng(sceneSeed);
+    staticObstacles.push_back(createStarPolygon(rng, {250, 200}, 10, 40));
+    staticObstacles.push_back(createStarPolygon(rng, {280, 500}, 8, 55));
+
+    // 静态障碍物的线框只在启动时生成一次；鼠标障碍物随每帧结果重建
+    // 线框按当前视图裁剪与简化，视图变化时随之重建
+    LineBatch staticLines, dynamicLines;
+    const uint64_t staticMapGeneration = 0; // 静态地图变化时递增，使线框与静态图层一起失效
+    const ObstacleSet staticSet = buildObstacleSet(staticObstacles);
+    StaticLayer staticLayer;
+
+    // 视图：滚轮以光标为中心缩放，右键拖动平移，0 键复位。世界坐标与旧版屏幕坐标一致
+    const Camera2D homeCamera = {{0.0f, 0.0f}, {0.0f, 0.0f}, 0.0f, 1.0f};
+    Camera2D camera = homeCamera;
+    const double outlineDetailPx = 2.0; // 屏幕上短于这个长度的轮廓细节被简化
+    const float lineWidthPx = 2.0f;
 
     // 4. 初始化鼠标障碍物（复杂多边形）
-    std::vector<Vec2> mousePolyTemplate = CreateComplexPoly({0, 0}, 15, 60);
+    std::vector<Vec2> mousePolyTemplate = createStarPolygon(rng, {0, 0}, 15, 60);
+
+    // 5. 性能面板 (F1 开关)
+    PerfHud hud;
+    PhaseTimer frameTimer;
+
+    RecordingWriter recorder;
+    if (recordPath && !recorder.open(recordPath)) {
+        std::cerr << recorder.error() << std::endl;
+        capture.close(); // PBO 须在 CloseWindow 之前释放
+        CloseWindow();
+        return 1;
+    }
+    const Clock::time_point startTime = Clock::now();
+
+    // 6. 流水线：组装与计算各占一个线程，raylib 的输入与绘制必须留在主线程
+    std::atomic<bool> running(true);
+    SpscRing<InputSnapshot> inputQueue(4);
+    SpscRing<WorldFrame> worldQueue(4);
+    SpscRing<ShiftFrame> resultQueue(4);
+    std::atomic<uint64_t> droppedInputs(0);
+    std::atomic<uint64_t> droppedResults(0);
+    // 每条线段最新的目标 / 平滑推移量，由计算线程发布，绘制或其他消费者随时读取最新一份
+    ShiftPublisher publisher(1);
+
+    std::thread ingestThread([&] {
+        traceSetThreadName("ingest");
+        SpinBackoff backoff;
+        InputSnapshot in;
+        while (running.load(std::memory_order_relaxed)) {
+            if (!inputQueue.tryPop(in)) {
+                backoff.pause();
+                continue;
+            }
+            backoff.reset();
+            WorldFrame w;
+            w.seq = in.seq;
+            w.captured = in.captured;
+            w.inputWaitMs = msBetween(in.enqueued, Clock::now());
+            w.ideal = { idealBasePos, {idealBasePos.x, idealBasePos.y + in.segLength}, heading };
+            {
+                SLOTSHIFT_TRACE_SCOPE("assemble");
+                PhaseTimer t;
+                // 更新鼠标多边形位置
+                std::vector<Vec2> currentMousePoly;
+                for(auto& v : mousePolyTemplate) {
+                    currentMousePoly.push_back({ v.x + in.mouse.x, v.y + in.mouse.y });
+                }
+
+                // 合并所有障碍物
+                w.allWorld = staticObstacles;
+                w.allWorld.push_back(currentMousePoly);
+                w.worldSet = buildObstacleSet(w.allWorld);
+                w.assembleMs = t.lapMs();
+            }
+            // 计算跟不上时在这里等 (反压)，障碍物帧不丢
+            w.enqueued = Clock::now();
+            while (!worldQueue.tryPush(std::move(w))) {
+                if (!running.load(std::memory_order_relaxed)) return;
+                backoff.pause();
+            }
+            backoff.reset();
+        }
+    });
 
-    SetTargetFPS(60);
+    std::thread computeThread([&] {
+        traceSetThreadName("compute");
+        SpinBackoff backoff;
+        WorldFrame w;
+        double currentShift = 0.0;
+        while (running.load(std::memory_order_relaxed)) {
+            if (!worldQueue.tryPop(w)) {
+                backoff.pause();
+                continue;
+            }
+            backoff.reset();
+            ShiftFrame r;
+            r.worldWaitMs = msBetween(w.enqueued, Clock::now());
+            // SoA 变体与参考实现逐位一致，同时能给出剔除 / 命中计数
+            PhaseTimer t;
+            r.targetShift = calculateSegmentShiftSoA(w.ideal, w.worldSet, margin, detectionRange, r.stats);
+            r.shiftMs = t.lapMs();
+
+            // 平滑插值 (Lerp)：每个输入帧一次，与渲染帧率一致
+            {
+                SLOTSHIFT_TRACE_SCOPE("smooth");
+                currentShift += (r.targetShift - currentShift) * 0.15f;
+            }
+            uint64_t ns = (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(w.captured - startTime).count();
+            publisher.publish(w.seq, ns, &r.targetShift, &currentShift);
+
+            if (recorder.isOpen()) {
+                SLOTSHIFT_TRACE_SCOPE("record");
+                if (!recorder.writeFrame(w.worldSet, &w.ideal, &r.targetShift, 1, margin, detectionRange, ns)) {
+                    std::cerr << recorder.error() << std::endl;
+                    recorder.close();
+                }
+            }
+
+            // 渲染只要最新结果：队列满说明渲染落后，直接丢掉这一帧而不是等 EndDrawing
+            r.world = std::move(w);
+            r.enqueued = Clock::now();
+            if (!resultQueue.tryPush(std::move(r))) droppedResults.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+
+    SetTargetFPS(captureOptions.headless ? 0 : 60);
+
+    uint64_t inputSeq = 0;
+    ShiftFrame latest;       // 最近一次收到的计算结果
+    ShiftFrame incoming;
+    bool haveResult = false;
+    double resultWaitMs = 0.0;
+    ShiftSnapshot shown;
+
+    while (!WindowShouldClose() && !capture.finished()) {
+        SLOTSHIFT_TRACE_SCOPE("frame");
+        hud.pushFrameTime(frameTimer.lapMs());
+        PhaseTimer phase;
 
-    while (!WindowShouldClose()) {
         // --- A. 交互控制 ---
         // 调节线段长度: 键盘上下键
         if (IsKeyDown(KEY_UP)) segLength += 2.0;
         if (IsKeyDown(KEY_DOWN)) segLength = std::max(20.0, segLength - 2.0);
-        
-        // 更新理想线段状态
-        Segment currentIdeal = { idealBasePos, {idealBasePos.x, idealBasePos.y + segLength}, heading };
-
-        // 更新鼠标多边形位置
-        Vector2 m = GetMousePosition();
-        std::vector<Vec2> currentMousePoly;
-        for(auto& v : mousePolyTemplate) {
-            currentMousePoly.push_back({ v.x + m.x, v.y + m.y });
+        if (IsKeyPressed(KEY_F1)) hud.toggle();
+        updateCamera(camera, homeCamera);
+
+        {
+            SLOTSHIFT_TRACE_SCOPE("input");
+            Vector2 m = GetScreenToWorld2D(GetMousePosition(), camera);
+            InputSnapshot in;
+            in.seq = inputSeq++;
+            in.captured = in.enqueued = Clock::now();
+            in.mouse = {m.x, m.y};
+            in.segLength = segLength;
+            if (!inputQueue.tryPush(std::move(in))) droppedInputs.fetch_add(1, std::memory_order_relaxed);
+        }
+
+        // --- B. 取最新的计算结果 ---
+        // 积压的旧结果直接跳过；还没有新结果时沿用上一帧的
+        while (resultQueue.tryPop(incoming)) {
+            resultWaitMs = msBetween(incoming.enqueued, Clock::now());
+            std::swap(latest, incoming);
+            haveResult = true;
+        }
+        hud.setPhase("input", phase.lapMs());
+        if (haveResult) {
+            hud.setPhase("assemble", latest.world.assembleMs);
+            hud.setPhase("shift", latest.shiftMs);
+            hud.setPhase("input->render", msBetween(latest.world.captured, Clock::now()));
+            const ShiftStats& stats = latest.stats;
+            hud.setCounter("polygons", stats.polygonsVisited);
+            hud.setCounter("culled", stats.polygonsCulled);
+            hud.setCounter("verts tested", stats.verticesTested);
+            hud.setCounter("in window", stats.verticesInWindow);
+            hud.setCounter("band hits", stats.bandHits);
+            hud.setCounter("max polygon", (uint64_t)(stats.maxPolygon + 1)); // 0 表示没有顶点产生推移
         }
+        hud.setQueue("input", inputQueue.size(), inputQueue.capacity(), latest.world.inputWaitMs);
+        hud.setQueue("world", worldQueue.size(), worldQueue.capacity(), latest.worldWaitMs);
+        hud.setQueue("result", resultQueue.size(), resultQueue.capacity(), resultWaitMs);
+        hud.setCounter("dropped input", droppedInputs.load(std::memory_order_relaxed));
+        hud.setCounter("dropped result", droppedResults.load(std::memory_order_relaxed));
 
-        // 合并所有障碍物
-        std::vector<std::vector<Vec2>> allWorld = staticObstacles;
-        allWorld.push_back(currentMousePoly);
+        // 绘制用的线段与障碍物都取自同一帧结果，保持一致
+        const Segment currentIdeal = haveResult ? latest.world.ideal
+                                                : Segment{ idealBasePos, {idealBasePos.x, idealBasePos.y + segLength}, heading };
+        const double drawLength = currentIdeal.length();
+        const std::vector<std::vector<Vec2>>& allWorld = latest.world.allWorld;
 
-        // --- B. 核心计算 ---
-        double targetShift = calculateSegmentShift(currentIdeal, allWorld, margin, detectionRange);
-        
-        // 平滑插值 (Lerp)
-        currentShift += (targetShift - currentShift) * 0.15f;
+        // 显示的推移量取自发布的最新快照，不经过结果队列
+        publisher.readLatest(shown);
+        const double currentShift = shown.current[0];
+        hud.setCounter("published", shown.version);
+
+        // 当前视图在世界坐标下的范围；线宽与简化阈值按缩放换算成世界单位，屏幕上保持不变
+        const LineBatchView lineView = cameraView(camera, screenWidth, screenHeight, outlineDetailPx);
+        const float lineWidth = lineWidthPx / camera.zoom;
+        const uint64_t viewKey = cameraKey(camera);
+
+        staticLines.setPolygons(staticSet, lineWidth, StaticLayer::mixKey(viewKey, staticMapGeneration), &lineView);
+        if (haveResult) {
+            dynamicLines.setPolygons(allWorld, staticObstacles.size(), allWorld.size(), lineWidth,
+                                     StaticLayer::mixKey(viewKey, latest.world.seq), &lineView);
+        }
+        hud.setCounter("line edges", staticLines.edgeCount() + dynamicLines.edgeCount());
+        hud.setCounter("line uploads", staticLines.uploads() + dynamicLines.uploads());
+        hud.setCounter("lines culled", staticLines.polygonsCulled() + dynamicLines.polygonsCulled());
+        hud.setCounter("lines simplified", staticLines.polygonsSimplified() + dynamicLines.polygonsSimplified());
+        hud.setCounter("read retries", publisher.readRetries());
 
         // --- C. 绘图 ---
-        BeginDrawing();
-        ClearBackground(RAYWHITE);
-
-        // 1. 绘制探测有效区 (可视化检测范围)
-        DrawRectangleV({(float)currentIdeal.start.x, (float)currentIdeal.start.y}, 
-                       {(float)detectionRange, (float)segLength}, ColorAlpha(LIME, 0.08f));
-        DrawRectangleLinesEx({(float)currentIdeal.start.x, (float)currentIdeal.start.y, (float)detectionRange, (float)segLength}, 
-                             1.0f, ColorAlpha(LIME, 0.3f));
-
-        // 2. 绘制理想位置参考线 (灰)
-        DrawLineV({(float)currentIdeal.start.x, (float)currentIdeal.start.y}, 
-                  {(float)currentIdeal.end.x, (float)currentIdeal.end.y}, Fade(GRAY, 0.5f));
-
-        // 3. 计算并绘制实际线段 (蓝)
-        Vec2 offset = heading * currentShift;
-        Vector2 p1 = {(float)(currentIdeal.start.x + offset.x), (float)(currentIdeal.start.y + offset.y)};
-        Vector2 p2 = {(float)(currentIdeal.end.x + offset.x), (float)(currentIdeal.end.y + offset.y)};
-        
-        // 绘制排斥感应区 (Margin)
-        DrawRectangleRec({p1.x - (float)margin, p1.y, (float)margin, (float)segLength}, ColorAlpha(SKYBLUE, 0.2f));
-        // 绘制主线段
-        DrawLineEx(p1, p2, 6.0f, DARKBLUE);
-        DrawCircleV(p1, 5, DARKBLUE);
-        DrawCircleV(p2, 5, DARKBLUE);
-
-        // 4. 绘制所有多边形
-        for (const auto& poly : allWorld) {
-            for (size_t i = 0; i < poly.size(); i++) {
-                DrawLineEx({(float)poly[i].x, (float)poly[i].y}, 
-                           {(float)poly[(i+1)%poly.size()].x, (float)poly[(i+1)%poly.size()].y}, 
-                           2.0f, MAROON);
+        {
+            SLOTSHIFT_TRACE_SCOPE("draw");
+            // 1. 静态图层：探测有效区、理想位置参考线与静态障碍物，只在地图、视图或理想线段变化时重画
+            uint64_t layerKey = StaticLayer::mixKey(viewKey, staticMapGeneration);
+            layerKey = StaticLayer::mixKey(layerKey, currentIdeal.start.x);
+            layerKey = StaticLayer::mixKey(layerKey, currentIdeal.start.y);
+            layerKey = StaticLayer::mixKey(layerKey, drawLength);
+            layerKey = StaticLayer::mixKey(layerKey, detectionRange);
+            staticLayer.update(screenWidth, screenHeight, layerKey, RAYWHITE, [&]() {
+                BeginMode2D(camera);
+                // 探测有效区 (可视化检测范围)
+                DrawRectangleV({(float)currentIdeal.start.x, (float)currentIdeal.start.y},
+                               {(float)detectionRange, (float)drawLength}, ColorAlpha(LIME, 0.08f));
+                DrawRectangleLinesEx({(float)currentIdeal.start.x, (float)currentIdeal.start.y, (float)detectionRange, (float)drawLength},
+                                     1.0f, ColorAlpha(LIME, 0.3f));
+                // 理想位置参考线 (灰)
+                DrawLineV({(float)currentIdeal.start.x, (float)currentIdeal.start.y},
+                          {(float)currentIdeal.end.x, (float)currentIdeal.end.y}, Fade(GRAY, 0.5f));
+                staticLines.draw(MAROON);
+                EndMode2D();
+            });
+            hud.setCounter("layer redraws", staticLayer.redraws());
+
+            BeginDrawing();
+            ClearBackground(RAYWHITE);
+            staticLayer.draw();
+
+            BeginMode2D(camera);
+            // 2. 计算并绘制实际线段 (蓝)，连同排斥感应区整个在视图外时跳过
+            Vec2 offset = heading * currentShift;
+            Vector2 p1 = {(float)(currentIdeal.start.x + offset.x), (float)(currentIdeal.start.y + offset.y)};
+            Vector2 p2 = {(float)(currentIdeal.end.x + offset.x), (float)(currentIdeal.end.y + offset.y)};
+            const Bounds segmentBounds = {std::min(p1.x, p2.x) - margin, std::min(p1.y, p2.y),
+                                          std::max(p1.x, p2.x) + margin, std::max(p1.y, p2.y)};
+            const Bounds& vp = lineView.viewport;
+            if (segmentBounds.minX <= vp.maxX && vp.minX <= segmentBounds.maxX &&
+                segmentBounds.minY <= vp.maxY && vp.minY <= segmentBounds.maxY) {
+                // 绘制排斥感应区 (Margin)
+                DrawRectangleRec({p1.x - (float)margin, p1.y, (float)margin, (float)drawLength}, ColorAlpha(SKYBLUE, 0.2f));
+                // 绘制主线段
+                DrawLineEx(p1, p2, 6.0f / camera.zoom, DARKBLUE);
+                DrawCircleV(p1, 5.0f / camera.zoom, DARKBLUE);
+                DrawCircleV(p2, 5.0f / camera.zoom, DARKBLUE);
             }
+
+            // 3. 鼠标障碍物 (静态障碍物已在图层里)
+            dynamicLines.draw(MAROON);
+            EndMode2D();
+
+            // 4. 状态文字
+            DrawText("Controls:", 10, 10, 20, DARKGRAY);
+            DrawText("- UP/DOWN: Resize Line", 10, 35, 18, GRAY);
+            DrawText("- Mouse: Move Obstacle", 10, 55, 18, GRAY);
+            DrawText(TextFormat("Detection Range: %.0f px", detectionRange), 10, 85, 20, DARKGREEN);
+            DrawText(TextFormat("Current Shift: %.1f", currentShift), 10, 110, 20, DARKBLUE);
+            DrawText("- F1: Performance HUD", 10, 135, 18, GRAY);
+            DrawText(TextFormat("- Wheel / Right drag / 0: Zoom %.2fx / Pan / Reset", camera.zoom), 10, 155, 18, GRAY);
+
+            // 5. 性能面板 (绘制阶段显示的是上一帧的耗时)
+            hud.draw(screenWidth - 430, 10);
         }
+        hud.setPhase("draw", phase.lapMs());
 
-        // 5. 状态文字
-        DrawText("Controls:", 10, 10, 20, DARKGRAY);
-        DrawText("- UP/DOWN: Resize Line", 10, 35, 18, GRAY);
-        DrawText("- Mouse: Move Obstacle", 10, 55, 18, GRAY);
-        DrawText(TextFormat("Detection Range: %.0f px", detectionRange), 10, 85, 20, DARKGREEN);
-        DrawText(TextFormat("Current Shift: %.1f", currentShift), 10, 110, 20, DARKBLUE);
+        if (capture.isOpen()) {
+            SLOTSHIFT_TRACE_SCOPE("capture");
+            capture.capture();
+            hud.setPhase("capture", phase.lapMs());
+            hud.setCounter("captured", capture.framesCaptured());
+            hud.setCounter("encoded", capture.framesWritten());
+        }
 
-        EndDrawing();
+        {
+            // 交换缓冲并按目标帧率等待；组装与计算线程不受影响
+            SLOTSHIFT_TRACE_SCOPE("end_drawing");
+            EndDrawing();
+        }
     }
 
+    running.store(false);
+    ingestThread.join();
+    computeThread.join();
+
+    staticLayer.unload();
+    staticLines.unload();
+    dynamicLines.unload();
+    if (capture.isOpen()) {
+        if (capture.close()) std::cout << "captured " << capture.framesWritten() << " frames to " << captureOptions.directory << std::endl;
+        else std::cerr << capture.error() << std::endl;
+    }
     CloseWindow();
+    if (recorder.isOpen()) {
+        if (recorder.close()) std::cout << "recorded " << recorder.framesWritten() << " frames to " << recordPath << std::endl;
+        else std::cerr << recorder.error() << std::endl;
+    }
+    if (tracePath) writeTrace(tracePath);
     return 0;
-}
\ No newline at end of file
+}
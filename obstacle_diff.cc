@@ -0,0 +1,184 @@
+#include "obstacle_diff.h"
+
+#include <algorithm>
+#include <cstring>
+
+// --- 多边形内容哈希 ---
+
+namespace {
+
+const uint64_t kMul = 0x9E3779B97F4A7C15ull;
+
+inline uint64_t bitsOf(double v) {
+    uint64_t b;
+    std::memcpy(&b, &v, sizeof(b));
+    return b;
+}
+
+inline uint64_t rotl(uint64_t x, int r) { return x << r | x >> (64 - r); }
+
+const int kLanes = 4;
+
+// 吸收一段坐标 (XXH3 的累加步)：坐标与随下标变化的密钥异或后低 32 位乘高 32 位，再加上交换高低半的原值。
+// 32x32->64 的乘法对应 SSE2 的 pmuludq / AVX2 的 vpmuludq，4 路之间没有依赖，编译器按向量展开；
+// 密钥按下标递增 (Weyl 序列)，交换两个坐标的位置会改变哈希
+inline void absorbArray(uint64_t acc[kLanes], const double* v, size_t n, uint64_t key) {
+    uint64_t a[kLanes], keys[kLanes];
+    for (int j = 0; j < kLanes; ++j) {
+        a[j] = acc[j];
+        keys[j] = key + (uint64_t)j * kMul;
+    }
+    size_t i = 0;
+    for (; i + kLanes <= n; i += kLanes) {
+        uint64_t w[kLanes];
+        std::memcpy(w, v + i, sizeof(w));
+        for (int j = 0; j < kLanes; ++j) {
+            const uint64_t k = w[j] ^ keys[j];
+            a[j] += rotl(w[j], 32) + (k & 0xffffffffull) * (k >> 32);
+            keys[j] += kLanes * kMul;
+        }
+    }
+    for (int j = 0; i < n; ++i, ++j) {
+        const uint64_t w = bitsOf(v[i]);
+        const uint64_t k = w ^ keys[j];
+        a[j] += rotl(w, 32) + (k & 0xffffffffull) * (k >> 32);
+    }
+    for (int j = 0; j < kLanes; ++j) acc[j] = a[j];
+}
+
+// splitmix64 的收尾
+inline uint64_t finalize(uint64_t h) {
+    h ^= h >> 30;
+    h *= 0xBF58476D1CE4E5B9ull;
+    h ^= h >> 27;
+    h *= 0x94D049BB133111EBull;
+    return h ^ (h >> 31);
+}
+
+} // namespace
+
+uint64_t hashPolygon(const double* xs, const double* ys, size_t vertices) {
+    uint64_t acc[kLanes] = {0x243F6A8885A308D3ull, 0x13198A2E03707344ull, 0xA4093822299F31D0ull, 0x082EFA98EC4E6C89ull};
+    absorbArray(acc, xs, vertices, 0x452821E638D01377ull);
+    absorbArray(acc, ys, vertices, 0xBE5466CF34E90C6Cull);
+    // 累加只在各路内部扩散，合并时逐路雪崩
+    uint64_t h = (uint64_t)vertices * kMul;
+    for (int j = 0; j < kLanes; ++j) h = finalize(h ^ acc[j]);
+    return h;
+}
+
+void hashPolygons(const ObstacleView& obstacles, uint64_t* out) {
+    for (size_t p = 0; p < obstacles.polygonCount(); ++p) {
+        const uint32_t begin = obstacles.offsets[p];
+        out[p] = hashPolygon(obstacles.xs + begin, obstacles.ys + begin, obstacles.offsets[p + 1] - begin);
+    }
+}
+
+// --- 逐帧障碍物差分 ---
+
+bool ObstacleFrameDiff::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+void ObstacleFrameDiff::reset() {
+    byId_.clear();
+    previous_.clear();
+    nextTrackerId_ = 0;
+    frame_ = 0;
+    stats_ = ObstacleDiffStats();
+    error_.clear();
+}
+
+bool ObstacleFrameDiff::apply(const ObstacleView& frame, const uint64_t* ids, SlotTracker& tracker) {
+    ++frame_;
+    stats_ = ObstacleDiffStats();
+    stats_.polygons = frame.polygonCount();
+    stats_.verticesHashed = frame.vertexCount();
+    hashes_.resize(frame.polygonCount());
+    hashPolygons(frame, hashes_.data());
+    return ids ? applyById(frame, ids, tracker) : applyByHash(frame, tracker);
+}
+
+bool ObstacleFrameDiff::applyById(const ObstacleView& frame, const uint64_t* ids, SlotTracker& tracker) {
+    for (size_t p = 0; p < frame.polygonCount(); ++p) {
+        const uint32_t begin = frame.offsets[p];
+        const size_t n = frame.offsets[p + 1] - begin;
+        const uint64_t id = ids[p];
+        auto it = byId_.find(id);
+        if (it == byId_.end()) {
+            if (!tracker.addObstacle(id, frame.xs + begin, frame.ys + begin, n)) return fail(tracker.error());
+            byId_[id] = Entry{hashes_[p], frame_};
+            ++stats_.added;
+            continue;
+        }
+        Entry& e = it->second;
+        if (e.seen == frame_) return fail("duplicate obstacle id " + std::to_string(id));
+        e.seen = frame_;
+        if (e.hash == hashes_[p]) {
+            ++stats_.unchanged;
+            continue;
+        }
+        if (!tracker.moveObstacle(id, frame.xs + begin, frame.ys + begin, n)) return fail(tracker.error());
+        e.hash = hashes_[p];
+        ++stats_.moved;
+    }
+    for (auto it = byId_.begin(); it != byId_.end();) {
+        if (it->second.seen == frame_) {
+            ++it;
+            continue;
+        }
+        if (!tracker.removeObstacle(it->first)) return fail(tracker.error());
+        it = byId_.erase(it);
+        ++stats_.removed;
+    }
+    return true;
+}
+
+bool ObstacleFrameDiff::applyByHash(const ObstacleView& frame, SlotTracker& tracker) {
+    current_.clear();
+    for (size_t p = 0; p < frame.polygonCount(); ++p) current_.push_back(std::make_pair(hashes_[p], (uint32_t)p));
+    std::sort(current_.begin(), current_.end());
+
+    // 两个有序序列归并：哈希相同的一对直接沿用，其余分别进入 stale_ / pending_
+    next_.clear();
+    stale_.clear();
+    pending_.clear();
+    size_t i = 0, j = 0;
+    while (i < previous_.size() || j < current_.size()) {
+        if (j == current_.size() || (i < previous_.size() && previous_[i].first < current_[j].first)) {
+            stale_.push_back(previous_[i++].second);
+        } else if (i == previous_.size() || current_[j].first < previous_[i].first) {
+            pending_.push_back(current_[j++].second);
+        } else {
+            next_.push_back(previous_[i++]);
+            ++j;
+            ++stats_.unchanged;
+        }
+    }
+
+    for (uint32_t p : pending_) {
+        const uint32_t begin = frame.offsets[p];
+        const size_t n = frame.offsets[p + 1] - begin;
+        uint64_t id;
+        if (!stale_.empty()) {
+            id = stale_.back();
+            stale_.pop_back();
+            if (!tracker.moveObstacle(id, frame.xs + begin, frame.ys + begin, n)) return fail(tracker.error());
+            ++stats_.moved;
+        } else {
+            id = nextTrackerId_++;
+            if (!tracker.addObstacle(id, frame.xs + begin, frame.ys + begin, n)) return fail(tracker.error());
+            ++stats_.added;
+        }
+        next_.push_back(std::make_pair(hashes_[p], id));
+    }
+    for (uint64_t id : stale_) {
+        if (!tracker.removeObstacle(id)) return fail(tracker.error());
+        ++stats_.removed;
+    }
+
+    std::sort(next_.begin(), next_.end());
+    previous_.swap(next_);
+    return true;
+}
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "slot_shift.h"
+#include "slot_tracker.h"
+
+// --- 多边形内容哈希 ---
+// 对顶点坐标的位模式求 64 位哈希：逐位相同的多边形哈希相同 (-0.0 与 0.0、不同的 NaN 载荷视为不同)。
+// 坐标数组按 4 路做 XXH3 式的累加 (32x32->64 乘法，SSE2 / AVX2 下编译器可向量化)，最后逐路雪崩合并。
+uint64_t hashPolygon(const double* xs, const double* ys, size_t vertices);
+// 对视图里的每个多边形求哈希，写入 out[0..polygons)
+void hashPolygons(const ObstacleView& obstacles, uint64_t* out);
+
+// --- 逐帧障碍物差分 ---
+// 感知每帧重发完整的障碍物列表，其中大部分多边形与上一帧逐位相同。ObstacleFrameDiff 把整帧列表
+// 与上一帧对比，只把真正变化的多边形作为增加 / 移动 / 删除交给 SlotTracker：
+// 没变的多边形不调用追踪器，其包围盒、网格登记与各线段上缓存的贡献全部原样复用。
+//   - 提供 ids 时按 id 匹配：哈希或顶点数不同即视为移动，新 id 为增加，本帧缺席的 id 为删除。
+//   - 不提供 ids 时按哈希匹配：哈希相同的多边形视为同一个，剩下的新多边形优先顶替消失的旧多边形 (移动)，
+//     多出的增加、缺少的删除。追踪器里的 id 由差分器内部分配。
+// 哈希相同即认为内容相同，两个不同多边形哈希碰撞的概率约为 2^-64。
+// 一个 ObstacleFrameDiff 只应驱动一个追踪器，且两种匹配方式不能混用 (切换前先 reset)。
+struct ObstacleDiffStats {
+    size_t polygons = 0;  // 本帧多边形数
+    size_t unchanged = 0;
+    size_t moved = 0;
+    size_t added = 0;
+    size_t removed = 0;
+    uint64_t verticesHashed = 0;
+};
+
+class ObstacleFrameDiff {
+public:
+    // 忘掉上一帧 (追踪器应同时 reset)
+    void reset();
+
+    // frame 为本帧完整的障碍物列表；ids 为 nullptr 或 frame.polygonCount() 个互不相同的 id。
+    // 只修改 tracker 的障碍物，不调用 tracker.update()。返回 false (例如 id 重复) 时 tracker 可能已部分更新，
+    // 调用方应同时 reset 差分器与追踪器
+    bool apply(const ObstacleView& frame, const uint64_t* ids, SlotTracker& tracker);
+
+    const ObstacleDiffStats& lastStats() const { return stats_; }
+    const std::string& error() const { return error_; }
+
+private:
+    struct Entry {
+        uint64_t hash;
+        uint32_t seen; // 最近一次出现在哪一帧
+    };
+    bool fail(const std::string& message);
+    bool applyById(const ObstacleView& frame, const uint64_t* ids, SlotTracker& tracker);
+    bool applyByHash(const ObstacleView& frame, SlotTracker& tracker);
+
+    std::unordered_map<uint64_t, Entry> byId_; // id 模式：调用方 id -> 上一帧内容
+    // 哈希模式：上一帧的 (哈希, 追踪器 id)，按哈希排序，与本帧排好序的 (哈希, 多边形下标) 归并匹配
+    std::vector<std::pair<uint64_t, uint64_t>> previous_;
+    std::vector<std::pair<uint64_t, uint64_t>> next_;
+    std::vector<std::pair<uint64_t, uint32_t>> current_;
+    std::vector<uint64_t> stale_;   // 本帧没有匹配上的旧多边形
+    std::vector<uint32_t> pending_; // 本帧没有匹配上的新多边形
+    uint64_t nextTrackerId_ = 0;
+    uint32_t frame_ = 0;
+    std::vector<uint64_t> hashes_;
+    ObstacleDiffStats stats_;
+    std::string error_;
+};
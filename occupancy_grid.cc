@@ -0,0 +1,417 @@
+#include "occupancy_grid.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+
+#include "trace.h"
+
+// --- 占用栅格 ---
+bool OccupancyGrid::reset(int32_t w, int32_t h, double cell, Vec2 o) {
+    if (w < 0 || h < 0 || w > kMaxGridSide || h > kMaxGridSide) return false;
+    if (!(cell > 0) || !std::isfinite(cell) || !std::isfinite(o.x) || !std::isfinite(o.y)) return false;
+    width = w;
+    height = h;
+    cellSize = cell;
+    origin = o;
+    wordsPerRow = ((size_t)w + 1 + 63) / 64;
+    bits.assign(wordsPerRow * (size_t)h, 0);
+    return true;
+}
+
+void OccupancyGrid::set(int32_t x, int32_t y, bool value) {
+    if (x < 0 || y < 0 || x >= width || y >= height) return;
+    uint64_t& word = bits[(size_t)y * wordsPerRow + ((uint32_t)x >> 6)];
+    const uint64_t bit = 1ull << (x & 63);
+    word = value ? word | bit : word & ~bit;
+}
+
+void OccupancyGrid::fillRow(int32_t y, int32_t x0, int32_t x1) {
+    if (y < 0 || y >= height) return;
+    x0 = std::max(x0, 0);
+    x1 = std::min(x1, width - 1);
+    uint64_t* r = bits.data() + (size_t)y * wordsPerRow;
+    for (int32_t x = x0; x <= x1;) {
+        const int32_t w = x >> 6, first = x & 63;
+        const int32_t last = std::min(63, first + (x1 - x));
+        const uint64_t high = last == 63 ? ~0ull : (2ull << last) - 1;
+        r[w] |= high & (~0ull << first);
+        x += last - first + 1;
+    }
+}
+
+size_t OccupancyGrid::occupiedCount() const {
+    size_t n = 0;
+    for (uint64_t w : bits) {
+        for (; w; w &= w - 1) ++n;
+    }
+    return n;
+}
+
+void rasterizePolygons(const std::vector<std::vector<Vec2>>& polys, OccupancyGrid& grid) {
+    const double cell = grid.cellSize;
+    std::vector<double> crossings;
+    for (const auto& poly : polys) {
+        if (poly.empty()) continue;
+        double minY = HUGE_VAL, maxY = -HUGE_VAL;
+        for (const Vec2& v : poly) {
+            // 含顶点的格子：细长或小于一格的多边形也不会整个丢失
+            const double fx = std::floor((v.x - grid.origin.x) / cell), fy = std::floor((v.y - grid.origin.y) / cell);
+            if (fx >= 0 && fy >= 0 && fx < grid.width && fy < grid.height) grid.set((int32_t)fx, (int32_t)fy, true);
+            minY = std::min(minY, v.y);
+            maxY = std::max(maxY, v.y);
+        }
+        if (!std::isfinite(minY) || !std::isfinite(maxY)) continue;
+        const double rowLo = std::max(0.0, std::floor((minY - grid.origin.y) / cell));
+        const double rowHi = std::min((double)grid.height - 1, std::floor((maxY - grid.origin.y) / cell));
+        for (double ry = rowLo; ry <= rowHi; ++ry) {
+            // 扫描线取格子中心的高度，奇偶规则下相邻两个交点之间为内部
+            const double yc = grid.origin.y + (ry + 0.5) * cell;
+            crossings.clear();
+            for (size_t i = 0, j = poly.size() - 1; i < poly.size(); j = i++) {
+                const Vec2 a = poly[j], b = poly[i];
+                if ((a.y > yc) == (b.y > yc)) continue;
+                crossings.push_back(a.x + (yc - a.y) * (b.x - a.x) / (b.y - a.y));
+            }
+            std::sort(crossings.begin(), crossings.end());
+            for (size_t k = 0; k + 1 < crossings.size(); k += 2) {
+                const double x0 = std::ceil((crossings[k] - grid.origin.x) / cell - 0.5);
+                const double x1 = std::floor((crossings[k + 1] - grid.origin.x) / cell - 0.5);
+                if (!(x0 <= x1) || x1 < 0 || x0 >= grid.width) continue;
+                grid.fillRow((int32_t)ry, (int32_t)std::max(0.0, x0), (int32_t)std::min((double)grid.width - 1, x1));
+            }
+        }
+    }
+}
+
+std::vector<std::vector<Vec2>> occupancyPolygons(const OccupancyGrid& grid) {
+    std::vector<std::vector<Vec2>> polys;
+    for (int32_t y = 0; y < grid.height; ++y) {
+        for (int32_t x = 0; x < grid.width; ++x) {
+            if (!grid.occupied(x, y)) continue;
+            polys.push_back({grid.corner(x, y), grid.corner(x + 1, y), grid.corner(x + 1, y + 1), grid.corner(x, y + 1)});
+        }
+    }
+    return polys;
+}
+
+void GridShiftStats::merge(const GridShiftStats& other) {
+    segmentsRowScan += other.segmentsRowScan;
+    segmentsColumnScan += other.segmentsColumnScan;
+    segmentsRasterized += other.segmentsRasterized;
+    segmentsExhaustive += other.segmentsExhaustive;
+    rowsScanned += other.rowsScanned;
+    cornersTested += other.cornersTested;
+}
+
+// --- 栅格推移内核 ---
+namespace {
+
+constexpr bool kStatsCompiled = SLOTSHIFT_ENABLE_STATS != 0;
+
+// 光栅化区间的相对放宽量，远大于各种舍入误差；区间只需是有效角点的超集
+const double kSlack = 1e-12;
+
+inline int lowestBit(uint64_t v) {
+#if defined(__GNUC__)
+    return __builtin_ctzll(v);
+#else
+    int n = 0;
+    while (!(v & 1)) {
+        v >>= 1;
+        ++n;
+    }
+    return n;
+#endif
+}
+
+inline int highestBit(uint64_t v) {
+#if defined(__GNUC__)
+    return 63 - __builtin_clzll(v);
+#else
+    int n = 0;
+    while (v >>= 1) ++n;
+    return n;
+#endif
+}
+
+inline uint64_t bitsFrom(int b) { return ~0ull << b; }
+inline uint64_t bitsUpTo(int b) { return b == 63 ? ~0ull : (2ull << b) - 1; }
+
+// 角点行 cy 两侧 (cy - 1 与 cy) 的格子行按位或
+inline uint64_t cellPair(const OccupancyGrid& g, int64_t cy, size_t w) {
+    uint64_t m = 0;
+    if (cy > 0) m |= g.row((int32_t)cy - 1)[w];
+    if (cy < g.height) m |= g.row((int32_t)cy)[w];
+    return m;
+}
+
+// 角点行 cy 的第 w 个掩码字：格子列 x 占用时角点列 x 与 x + 1 都是顶点
+inline uint64_t cornerWord(const OccupancyGrid& g, int64_t cy, size_t w) {
+    const uint64_t m = cellPair(g, cy, w);
+    return m | m << 1 | (w > 0 ? cellPair(g, cy, w - 1) >> 63 : 0);
+}
+
+// 角点行 cy 上 [lo, hi] 内的每个顶点列，从小到大
+template <class F>
+void forEachCorner(const OccupancyGrid& g, int64_t cy, int64_t lo, int64_t hi, F f) {
+    const size_t w0 = (size_t)lo >> 6, w1 = (size_t)hi >> 6;
+    uint64_t prev = w0 > 0 ? cellPair(g, cy, w0 - 1) : 0;
+    for (size_t w = w0; w <= w1; ++w) {
+        const uint64_t m = cellPair(g, cy, w);
+        uint64_t c = m | m << 1 | prev >> 63;
+        prev = m;
+        if (w == w0) c &= bitsFrom((int)(lo & 63));
+        if (w == w1) c &= bitsUpTo((int)(hi & 63));
+        for (; c; c &= c - 1) f((int64_t)(w << 6) + lowestBit(c));
+    }
+}
+
+// [lo, hi] 内最右 / 最左的顶点列，没有时返回 -1
+int64_t lastCorner(const OccupancyGrid& g, int64_t cy, int64_t lo, int64_t hi) {
+    const size_t w0 = (size_t)lo >> 6;
+    for (size_t w = ((size_t)hi >> 6) + 1; w-- > w0;) {
+        uint64_t c = cornerWord(g, cy, w);
+        if (w == w0) c &= bitsFrom((int)(lo & 63));
+        if (w == ((size_t)hi >> 6)) c &= bitsUpTo((int)(hi & 63));
+        if (c) return (int64_t)(w << 6) + highestBit(c);
+    }
+    return -1;
+}
+
+int64_t firstCorner(const OccupancyGrid& g, int64_t cy, int64_t lo, int64_t hi) {
+    const size_t w1 = (size_t)hi >> 6;
+    for (size_t w = (size_t)lo >> 6; w <= w1; ++w) {
+        uint64_t c = cornerWord(g, cy, w);
+        if (w == ((size_t)lo >> 6)) c &= bitsFrom((int)(lo & 63));
+        if (w == w1) c &= bitsUpTo((int)(hi & 63));
+        if (c) return (int64_t)(w << 6) + lowestBit(c);
+    }
+    return -1;
+}
+
+// 与 shiftReference 的逐顶点判定逐字相同
+struct CornerTest {
+    const Segment& seg;
+    Vec2 dir;
+    double segLen;
+    double margin;
+    double detectionRange;
+
+    bool operator()(Vec2 p, double& push) const {
+        Vec2 vToStart = p - seg.start;
+        double projLen = vToStart.dot(dir);
+        if (!(projLen >= 0 && projLen <= segLen)) return false;
+        double dist = vToStart.dot(seg.heading);
+        if (!(dist < detectionRange && dist > -margin)) return false;
+        push = dist + margin;
+        return true;
+    }
+};
+
+// 世界坐标转角点下标并裁剪到 [0, n]，向外多留一格；NaN 按不限处理
+inline int64_t lowerIndex(double v, double origin, double cell, int64_t n) {
+    const double t = std::floor((v - origin) / cell) - 1;
+    if (!(t > 0)) return 0;
+    return t >= (double)n ? n : (int64_t)t;
+}
+
+inline int64_t upperIndex(double v, double origin, double cell, int64_t n) {
+    const double t = std::ceil((v - origin) / cell) + 1;
+    if (!(t < (double)n)) return n;
+    return t <= 0 ? 0 : (int64_t)t;
+}
+
+// 角点行 y 上满足 a <= (x - sx) * ux + (y - sy) * uy <= b 的 x 区间 (放宽)，收窄 [lo, hi]
+void clipSlab(const OccupancyGrid& g, double y, double sx, double sy, double ux, double uy, double a, double b,
+              double magnitude, int64_t& lo, int64_t& hi) {
+    const double t = (y - sy) * uy;
+    if (!std::isfinite(t)) return;
+    const double slack = kSlack * (std::fabs(a) + std::fabs(b) + std::fabs(t) + magnitude * (std::fabs(ux) + std::fabs(uy)));
+    const double p = a - t - slack, q = b - t + slack; // (x - sx) * ux 的取值范围
+    if (ux == 0.0) {
+        if (!(p <= 0 && 0 <= q)) hi = lo - 1;
+        return;
+    }
+    const double x0 = sx + p / ux, x1 = sx + q / ux;
+    const double xl = std::min(x0, x1), xh = std::max(x0, x1);
+    if (std::isnan(xl) || std::isnan(xh)) return;
+    lo = std::max(lo, lowerIndex(xl, g.origin.x, g.cellSize, g.width));
+    hi = std::min(hi, upperIndex(xh, g.origin.x, g.cellSize, g.width));
+}
+
+struct GridScratch {
+    std::vector<int64_t> lo, hi; // 每个角点行的候选列区间，lo > hi 表示空
+};
+
+template <bool kStats>
+double shiftGrid(const Segment& seg, const OccupancyGrid& g, double margin, double detectionRange, GridScratch& s,
+                 GridShiftStats* stats) {
+    double maxShift = 0.0;
+    if (g.width <= 0 || g.height <= 0) return maxShift;
+    const CornerTest test = {seg, seg.getDir(), seg.length(), margin, detectionRange};
+    const Vec2 dir = test.dir, h = seg.heading;
+    const int64_t W = g.width, H = g.height;
+    auto consider = [&](int64_t cx, int64_t cy) {
+        if (kStats) ++stats->cornersTested;
+        double push;
+        if (test(g.corner(cx, cy), push) && push > maxShift) maxShift = push;
+    };
+
+    const bool finite = std::isfinite(seg.start.x) && std::isfinite(seg.start.y) && std::isfinite(dir.x) &&
+                        std::isfinite(dir.y) && std::isfinite(test.segLen) && std::isfinite(h.x) &&
+                        std::isfinite(h.y) && std::isfinite(margin) && std::isfinite(detectionRange);
+    if (!finite) {
+        if (kStats) {
+            ++stats->segmentsExhaustive;
+            stats->rowsScanned += (uint64_t)H + 1;
+        }
+        for (int64_t cy = 0; cy <= H; ++cy) forEachCorner(g, cy, 0, W, [&](int64_t cx) { consider(cx, cy); });
+        return maxShift;
+    }
+
+    // 1. 角点行范围：两条带相交成平行四边形，取其包围盒；方向接近平行时不收窄
+    const Vec2 far = g.corner(W, H);
+    const double magnitude = std::max(std::fabs(g.origin.x), std::fabs(far.x)) +
+                             std::max(std::fabs(g.origin.y), std::fabs(far.y)) + std::fabs(seg.start.x) +
+                             std::fabs(seg.start.y);
+    int64_t r0 = 0, r1 = H;
+    const double det = dir.x * h.y - dir.y * h.x;
+    if (std::fabs(det) > 1e-6 * (std::fabs(dir.x) + std::fabs(dir.y)) * (std::fabs(h.x) + std::fabs(h.y))) {
+        double minY = HUGE_VAL, maxY = -HUGE_VAL;
+        for (double a : {0.0, test.segLen}) {
+            for (double b : {-margin, detectionRange}) {
+                const double y = seg.start.y + (dir.x * b - h.x * a) / det;
+                minY = std::min(minY, y);
+                maxY = std::max(maxY, y);
+            }
+        }
+        const double slack = kSlack * (std::fabs(minY) + std::fabs(maxY) + magnitude);
+        if (std::isfinite(minY) && std::isfinite(maxY)) {
+            r0 = lowerIndex(minY - slack, g.origin.y, g.cellSize, H);
+            r1 = upperIndex(maxY + slack, g.origin.y, g.cellSize, H);
+        }
+    }
+
+    // 2. 每个角点行上两条带各给出一个 x 区间，取交集
+    s.lo.assign((size_t)(r1 - r0 + 1), 0);
+    s.hi.assign((size_t)(r1 - r0 + 1), W);
+    int64_t rowMin = r1 + 1, rowMax = r0 - 1, colMin = W + 1, colMax = -1;
+    for (int64_t cy = r0; cy <= r1; ++cy) {
+        int64_t& lo = s.lo[(size_t)(cy - r0)];
+        int64_t& hi = s.hi[(size_t)(cy - r0)];
+        const double y = g.corner(0, cy).y;
+        clipSlab(g, y, seg.start.x, seg.start.y, dir.x, dir.y, 0.0, test.segLen, magnitude, lo, hi);
+        if (lo <= hi) clipSlab(g, y, seg.start.x, seg.start.y, h.x, h.y, -margin, detectionRange, magnitude, lo, hi);
+        if (lo > hi) continue;
+        rowMin = std::min(rowMin, cy);
+        rowMax = std::max(rowMax, cy);
+        colMin = std::min(colMin, lo);
+        colMax = std::max(colMax, hi);
+    }
+    if (rowMin > rowMax) {
+        if (kStats) ++stats->segmentsRasterized;
+        return maxShift;
+    }
+
+    // 3. 按 heading 的主轴选择扫描方式。相邻两个角点行 (列) 的横向距离至少差 cellSize * |主分量|，
+    //    候选角点在另一轴上的跨度最多带来 span * |次分量| 的差异，前者更大 (再扣除舍入误差) 时远处的行整体优先
+    const double hx = std::fabs(h.x), hy = std::fabs(h.y);
+    const double roundoff = 64 * DBL_EPSILON * magnitude * (hx + hy);
+    auto interval = [&](int64_t cy, int64_t& lo, int64_t& hi) {
+        lo = s.lo[(size_t)(cy - r0)];
+        hi = s.hi[(size_t)(cy - r0)];
+        return lo <= hi;
+    };
+    if (hy >= hx && g.cellSize * hy - (double)(colMax - colMin) * g.cellSize * hx > roundoff) {
+        if (kStats) ++stats->segmentsRowScan;
+        const int64_t step = h.y > 0 ? -1 : 1;
+        for (int64_t cy = h.y > 0 ? rowMax : rowMin; cy >= rowMin && cy <= rowMax; cy += step) {
+            int64_t lo, hi;
+            if (!interval(cy, lo, hi)) continue;
+            if (kStats) ++stats->rowsScanned;
+            bool found = false;
+            forEachCorner(g, cy, lo, hi, [&](int64_t cx) {
+                if (kStats) ++stats->cornersTested;
+                double push;
+                if (!test(g.corner(cx, cy), push)) return;
+                found = true;
+                if (push > maxShift) maxShift = push;
+            });
+            if (found) break;
+        }
+        return maxShift;
+    }
+    if (hx > hy && g.cellSize * hx - (double)(rowMax - rowMin) * g.cellSize * hy > roundoff) {
+        if (kStats) ++stats->segmentsColumnScan;
+        // 各行最远的顶点列里取最远的一列逐行判定；该列的角点全都无效 (落在区间放宽出的边缘上) 时排除它再找
+        const bool right = h.x > 0;
+        int64_t limit = right ? W : 0;
+        for (;;) {
+            int64_t best = -1;
+            for (int64_t cy = rowMin; cy <= rowMax; ++cy) {
+                int64_t lo, hi;
+                if (!interval(cy, lo, hi)) continue;
+                if (right ? lo > limit : hi < limit) continue;
+                if (kStats) ++stats->rowsScanned;
+                const int64_t c = right ? lastCorner(g, cy, lo, std::min(hi, limit))
+                                        : firstCorner(g, cy, std::max(lo, limit), hi);
+                if (c >= 0 && (best < 0 || (right ? c > best : c < best))) best = c;
+            }
+            if (best < 0) return maxShift;
+            bool found = false;
+            for (int64_t cy = rowMin; cy <= rowMax; ++cy) {
+                int64_t lo, hi;
+                if (!interval(cy, lo, hi) || best < lo || best > hi || firstCorner(g, cy, best, best) < 0) continue;
+                if (kStats) ++stats->cornersTested;
+                double push;
+                if (!test(g.corner(best, cy), push)) continue;
+                found = true;
+                if (push > maxShift) maxShift = push;
+            }
+            if (found) return maxShift;
+            if (right ? best == 0 : best == W) return maxShift;
+            limit = right ? best - 1 : best + 1;
+        }
+    }
+
+    if (kStats) ++stats->segmentsRasterized;
+    for (int64_t cy = rowMin; cy <= rowMax; ++cy) {
+        int64_t lo, hi;
+        if (!interval(cy, lo, hi)) continue;
+        if (kStats) ++stats->rowsScanned;
+        forEachCorner(g, cy, lo, hi, [&](int64_t cx) { consider(cx, cy); });
+    }
+    return maxShift;
+}
+
+template <bool kStats>
+void shiftGridBatch(const Segment* segs, size_t n, const OccupancyGrid& grid, double margin, double detectionRange,
+                    double* out, GridShiftStats* stats) {
+    GridScratch scratch;
+    for (size_t i = 0; i < n; ++i) out[i] = shiftGrid<kStats>(segs[i], grid, margin, detectionRange, scratch, stats);
+}
+
+} // namespace
+
+double calculateSegmentShiftGrid(const Segment& seg, const OccupancyGrid& grid, double margin, double detectionRange) {
+    SLOTSHIFT_TRACE_SCOPE("shift_grid");
+    GridScratch scratch;
+    return shiftGrid<false>(seg, grid, margin, detectionRange, scratch, nullptr);
+}
+
+void calculateSegmentShiftGridBatch(const Segment* segs, size_t n, const OccupancyGrid& grid, double margin,
+                                    double detectionRange, double* out) {
+    SLOTSHIFT_TRACE_SCOPE("shift_grid_batch");
+    shiftGridBatch<false>(segs, n, grid, margin, detectionRange, out, nullptr);
+}
+
+void calculateSegmentShiftGridBatch(const Segment* segs, size_t n, const OccupancyGrid& grid, double margin,
+                                    double detectionRange, double* out, GridShiftStats& stats) {
+    SLOTSHIFT_TRACE_SCOPE("shift_grid_batch");
+    shiftGridBatch<kStatsCompiled>(segs, n, grid, margin, detectionRange, out, &stats);
+}
+
+void cornerMask(const OccupancyGrid& grid, int64_t cy, uint64_t* out) {
+    for (size_t w = 0; w < grid.wordsPerRow; ++w) out[w] = cornerWord(grid, cy, w);
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "slot_shift.h"
+
+// --- 占用栅格 ---
+// 部分感知栈直接给出位图栅格而不是多边形。格子 (x, y) 覆盖
+// [origin.x + x * cellSize, origin.x + (x + 1) * cellSize) x [origin.y + y * cellSize, ...)，
+// 每行按 64 格一个字打包，第 x 格是 row(y)[x / 64] 的第 x % 64 位。
+//
+// 栅格上的障碍物定义为“每个占用格子一个正方形多边形” (occupancyPolygons)，顶点是格子的四个角点 corner(cx, cy)，
+// 角点列 cx 取 [0, width]、角点行 cy 取 [0, height]。calculateSegmentShiftGrid 直接在位图上求同一组顶点的推移量，
+// 与对 occupancyPolygons 的结果运行参考实现逐位一致，省去逐格生成多边形。
+const int32_t kMaxGridSide = 1 << 20;
+
+struct OccupancyGrid {
+    Vec2 origin{0.0, 0.0};
+    double cellSize = 1.0;
+    int32_t width = 0;  // 格子列数
+    int32_t height = 0; // 格子行数
+    size_t wordsPerRow = 0; // 按角点列数 width + 1 取整，角点掩码移位时不越界
+    std::vector<uint64_t> bits;
+
+    // 清空并改变尺寸；cellSize 须为正的有限值、origin 有限、尺寸不超过 kMaxGridSide，否则返回 false 且不改动
+    bool reset(int32_t width, int32_t height, double cellSize, Vec2 origin);
+
+    bool occupied(int32_t x, int32_t y) const {
+        return (bits[(size_t)y * wordsPerRow + ((uint32_t)x >> 6)] >> (x & 63)) & 1u;
+    }
+    void set(int32_t x, int32_t y, bool value);
+    // 把第 y 行的 [x0, x1] 格全部置为占用 (已裁剪到栅格内)
+    void fillRow(int32_t y, int32_t x0, int32_t x1);
+    const uint64_t* row(int32_t y) const { return bits.data() + (size_t)y * wordsPerRow; }
+    size_t occupiedCount() const;
+
+    // 角点坐标。多边形转换与栅格内核都经由这里计算，保证两边的顶点逐位相同
+    Vec2 corner(int64_t cx, int64_t cy) const { return {origin.x + cx * cellSize, origin.y + cy * cellSize}; }
+};
+
+// 角点行 cy (0..height) 的顶点掩码写入 out[0..wordsPerRow)：两侧格子行任一占用的格子列 x 贡献角点列 x 与 x + 1
+void cornerMask(const OccupancyGrid& grid, int64_t cy, uint64_t* out);
+
+// 格子中心落在多边形内 (奇偶规则) 或含有多边形顶点的格子置为占用，只增不减。
+// 用于把多边形场景栅格化成测试输入
+void rasterizePolygons(const std::vector<std::vector<Vec2>>& polys, OccupancyGrid& grid);
+
+// 每个占用格子一个正方形 (逆时针四个角点)，即栅格障碍物的多边形定义
+std::vector<std::vector<Vec2>> occupancyPolygons(const OccupancyGrid& grid);
+
+// --- 栅格推移内核 ---
+// 先把探测带 (纵向 [0, segLen] 与横向 (-margin, detectionRange) 两条带的交集) 光栅化成每个角点行上的保守列区间，
+// 再按 heading 的主轴分三种扫描，候选角点一律用与参考实现相同的表达式逐个判定：
+//   - heading 接近竖直 (推移方向沿行递进)：从最远的角点行往回扫，区间内有角点就逐个判定，
+//     第一行出现有效角点即可停止：相邻角点行的横向距离差大于同一行内的差异，更近的行不可能更大。
+//   - heading 接近水平：每行在列区间内用一次 find-last-set / find-first-set 找最远角点，取各行中最远的那一列判定。
+//   - 其余朝向 (与坐标轴夹角较大的旋转车位线)：逐行取区间内的角点掩码，按位遍历全部候选。
+// 坐标、方向或参数非有限时退化为遍历全部角点。
+struct GridShiftStats {
+    uint64_t segmentsRowScan = 0;    // 推移方向沿行，从远到近逐行扫描
+    uint64_t segmentsColumnScan = 0; // 推移方向沿列，逐行 find-last-set
+    uint64_t segmentsRasterized = 0; // 旋转车位线，遍历光栅化探测带内的全部角点
+    uint64_t segmentsExhaustive = 0; // 非有限输入，遍历全部角点
+    uint64_t rowsScanned = 0;
+    uint64_t cornersTested = 0;
+
+    void merge(const GridShiftStats& other);
+};
+
+double calculateSegmentShiftGrid(const Segment& seg, const OccupancyGrid& grid, double margin, double detectionRange);
+
+void calculateSegmentShiftGridBatch(const Segment* segs, size_t n, const OccupancyGrid& grid, double margin,
+                                    double detectionRange, double* out);
+void calculateSegmentShiftGridBatch(const Segment* segs, size_t n, const OccupancyGrid& grid, double margin,
+                                    double detectionRange, double* out, GridShiftStats& stats);
@@ -0,0 +1,292 @@
+#include "parking_lot.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+#include "scenario.h"
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+// 行人使用独立的子流区间，避免与按排编号的子流重叠
+const uint64_t kPedestrianStreamBase = 1ull << 40;
+
+struct RowSpec {
+    double aisleY; // 通道侧边线的 y
+    double sign;   // 车位从通道线伸展的方向 (+1 向 +y，-1 向 -y)
+    double angleDeg;
+    bool pillars;  // 是否在背线上放柱子
+};
+
+struct RowOutput {
+    std::vector<ParkingSlot> slots;
+    std::vector<Segment> segments;
+    std::vector<std::vector<Vec2>> polys;
+};
+
+// 角度为 90° 的整数倍时给出精确的 0 / ±1：std::cos(π/2) 约为 6e-17，会让垂直车位线与直角旋转后的边线偏离坐标轴，
+// 用不上只认精确沿轴线段的距离场
+void sinCos(double rad, double& s, double& c) {
+    const double quarters = rad / (0.5 * kPi);
+    const double k = std::round(quarters);
+    if (std::isfinite(k) && std::fabs(quarters - k) <= 1e-12 * std::max(1.0, std::fabs(k))) {
+        static const double kSin[4] = {0.0, 1.0, 0.0, -1.0};
+        static const double kCos[4] = {1.0, 0.0, -1.0, 0.0};
+        int q = (int)std::fmod(k, 4.0);
+        if (q < 0) q += 4;
+        s = kSin[q];
+        c = kCos[q];
+        return;
+    }
+    s = std::sin(rad);
+    c = std::cos(rad);
+}
+
+inline double rowHeight(const LotConfig& cfg, double angleDeg) {
+    double s, c;
+    sinCos(angleDeg * kPi / 180.0, s, c);
+    return cfg.slotDepth * s;
+}
+
+void generateRow(const LotConfig& cfg, const RowSpec& row, ScenarioRng rng, RowOutput& out) {
+    double sinT, cosT;
+    sinCos(row.angleDeg * kPi / 180.0, sinT, cosT);
+    const double pitch = cfg.slotWidth / sinT;
+    const Vec2 depth = {cfg.slotDepth * cosT, row.sign * cfg.slotDepth * sinT};
+    const Vec2 along = {pitch, 0};
+
+    // 侧边线的单位法向，取指向车位内侧 (朝 along 方向) 的那一侧
+    Vec2 n = {-depth.y / cfg.slotDepth, depth.x / cfg.slotDepth};
+    if (n.dot(along) < 0) n = n * -1.0;
+
+    for (int i = 0; i < cfg.slotsPerRow; ++i) {
+        Vec2 base = {i * pitch, row.aisleY};
+        ParkingSlot slot;
+        slot.corners[0] = base;
+        slot.corners[1] = base + along;
+        slot.corners[2] = base + along + depth;
+        slot.corners[3] = base + depth;
+        slot.angleDeg = row.angleDeg;
+        slot.occupied = rng.uniform() < cfg.occupancy;
+        slot.firstSegment = 0; // 合并时再填
+        out.slots.push_back(slot);
+
+        out.segments.push_back({slot.corners[0], slot.corners[3], n});
+        out.segments.push_back({slot.corners[1], slot.corners[2], n * -1.0});
+
+        if (slot.occupied) {
+            Vec2 center = base + along * 0.5 + depth * 0.5 + n * rng.uniform(-cfg.parkingJitter, cfg.parkingJitter);
+            double yaw = std::atan2(depth.y, depth.x) + rng.uniform(-3.0, 3.0) * kPi / 180.0;
+            std::vector<Vec2> car = createVehicle(rng, center, yaw, cfg.slotDepth * 0.9, cfg.slotWidth * 0.75);
+            out.polys.push_back(densifyPolygon(car, cfg.vehicleVertices));
+        }
+    }
+
+    if (row.pillars && cfg.pillarEvery > 0) {
+        for (int i = 0; i <= cfg.slotsPerRow; i += cfg.pillarEvery) {
+            Vec2 p = Vec2{i * pitch, row.aisleY} + depth;
+            out.polys.push_back(createPillar(p, cfg.pillarSize));
+        }
+    }
+}
+
+inline Vec2 rotate(Vec2 v, double c, double s) { return {v.x * c - v.y * s, v.x * s + v.y * c}; }
+
+// 行人圆心可达的范围：通道向内收一个半径，通道比行人还窄时收成中线
+Bounds walkable(const Bounds& aisle, double radius) {
+    const double rx = std::min(radius, 0.5 * (aisle.maxX - aisle.minX));
+    const double ry = std::min(radius, 0.5 * (aisle.maxY - aisle.minY));
+    return {aisle.minX + rx, aisle.minY + ry, aisle.maxX - rx, aisle.maxY - ry};
+}
+
+} // namespace
+
+std::vector<Vec2> densifyPolygon(const std::vector<Vec2>& poly, int targetVertices) {
+    const size_t n = poly.size();
+    if (n < 2 || targetVertices <= (int)n) return poly;
+
+    std::vector<double> cum(n + 1, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        Vec2 d = poly[(i + 1) % n] - poly[i];
+        cum[i + 1] = cum[i] + std::sqrt(d.x * d.x + d.y * d.y);
+    }
+    const double perimeter = cum[n];
+    const int extra = targetVertices - (int)n;
+
+    std::vector<Vec2> out;
+    out.reserve(targetVertices);
+    for (size_t i = 0; i < n; ++i) {
+        // 按累计周长取整分配，保证总数正好等于 targetVertices，原有顶点全部保留
+        int e0 = perimeter > 0 ? (int)std::lround(extra * cum[i] / perimeter) : (int)(extra * i / n);
+        int e1 = perimeter > 0 ? (int)std::lround(extra * cum[i + 1] / perimeter) : (int)(extra * (i + 1) / n);
+        int k = e1 - e0;
+        Vec2 a = poly[i];
+        Vec2 b = poly[(i + 1) % n];
+        out.push_back(a);
+        for (int j = 1; j <= k; ++j) out.push_back(a + (b - a) * ((double)j / (k + 1)));
+    }
+    return out;
+}
+
+ParkingLot generateParkingLot(const LotConfig& cfg) {
+    ParkingLot lot;
+    lot.config = cfg;
+    // 夹角为 0 时车位间距 slotWidth / sin 0 无穷大，区间外的取值一律跳过
+    std::vector<double> angles;
+    for (double a : cfg.rowAngles)
+        if (a > 0.0 && a <= 90.0) angles.push_back(a);
+    if (angles.empty()) angles.push_back(90.0);
+
+    // 1. 排布：通道 | A 排 (向 +y 伸展) | 路沿 | B 排 (向 -y 伸展，通道在下方) | 通道 ...
+    std::vector<RowSpec> rows;
+    std::vector<double> curbYs;
+    std::vector<double> aisleYs{0.0}; // 各通道的下沿
+    double y = cfg.aisleWidth;
+    double width = 0.0;
+    for (int b = 0; b < cfg.bays; ++b) {
+        double angleA = angles[(2 * b) % angles.size()];
+        double angleB = angles[(2 * b + 1) % angles.size()];
+        double hA = rowHeight(cfg, angleA);
+        double hB = rowHeight(cfg, angleB);
+        rows.push_back({y, 1.0, angleA, true});
+        curbYs.push_back(y + hA);
+        rows.push_back({y + hA + hB, -1.0, angleB, false});
+        aisleYs.push_back(y + hA + hB);
+        y += hA + hB + cfg.aisleWidth;
+        for (double a : {angleA, angleB}) {
+            double sinA, cosA;
+            sinCos(a * kPi / 180.0, sinA, cosA);
+            width = std::max(width, cfg.slotsPerRow * cfg.slotWidth / sinA + std::abs(cfg.slotDepth * cosA));
+        }
+    }
+    const double height = y;
+
+    // 2. 按排生成，每排使用独立子流，可并行且结果与线程数无关
+    ScenarioRng root(cfg.seed);
+    std::vector<RowOutput> outputs(rows.size());
+    auto generateRange = [&](size_t begin, size_t end) {
+        for (size_t r = begin; r < end; ++r) generateRow(cfg, rows[r], root.substream(r), outputs[r]);
+    };
+    unsigned threads = cfg.threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : cfg.threads;
+    threads = (unsigned)std::min<size_t>(threads, rows.size());
+    if (threads <= 1) {
+        generateRange(0, rows.size());
+    } else {
+        std::vector<std::thread> workers;
+        const size_t chunk = (rows.size() + threads - 1) / threads;
+        for (unsigned t = 1; t < threads; ++t) {
+            size_t begin = std::min(rows.size(), t * chunk);
+            workers.emplace_back(generateRange, begin, std::min(rows.size(), begin + chunk));
+        }
+        generateRange(0, std::min(rows.size(), chunk));
+        for (auto& w : workers) w.join();
+    }
+
+    // 3. 合并
+    for (RowOutput& out : outputs) {
+        for (size_t i = 0; i < out.slots.size(); ++i) {
+            out.slots[i].firstSegment = (uint32_t)(lot.segments.size() + 2 * i);
+        }
+        for (size_t i = 0; i < out.segments.size(); ++i) {
+            lot.segmentSlot.push_back((uint32_t)(lot.slots.size() + i / 2));
+        }
+        lot.slots.insert(lot.slots.end(), out.slots.begin(), out.slots.end());
+        lot.segments.insert(lot.segments.end(), out.segments.begin(), out.segments.end());
+        for (auto& poly : out.polys) lot.allWorld.push_back(std::move(poly));
+    }
+
+    // 路沿：背靠背两排之间一道，外加四周围墙
+    for (double cy : curbYs) lot.allWorld.push_back(createWall({0, cy}, {width, cy}, cfg.curbThickness));
+    lot.allWorld.push_back(createWall({0, 0}, {width, 0}, cfg.curbThickness));
+    lot.allWorld.push_back(createWall({width, 0}, {width, height}, cfg.curbThickness));
+    lot.allWorld.push_back(createWall({width, height}, {0, height}, cfg.curbThickness));
+    lot.allWorld.push_back(createWall({0, height}, {0, 0}, cfg.curbThickness));
+
+    // 4. 整体旋转
+    double s, c;
+    sinCos(cfg.lotYaw, s, c);
+    if (cfg.lotYaw != 0.0) {
+        for (ParkingSlot& slot : lot.slots)
+            for (Vec2& p : slot.corners) p = rotate(p, c, s);
+        for (Segment& seg : lot.segments) {
+            seg.start = rotate(seg.start, c, s);
+            seg.end = rotate(seg.end, c, s);
+            seg.heading = rotate(seg.heading, c, s);
+        }
+        for (auto& poly : lot.allWorld)
+            for (Vec2& p : poly) p = rotate(p, c, s);
+    }
+    lot.extent = {HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+    for (Vec2 p : {Vec2{0, 0}, Vec2{width, 0}, Vec2{width, height}, Vec2{0, height}}) {
+        Vec2 q = rotate(p, c, s);
+        lot.extent.minX = std::min(lot.extent.minX, q.x);
+        lot.extent.minY = std::min(lot.extent.minY, q.y);
+        lot.extent.maxX = std::max(lot.extent.maxX, q.x);
+        lot.extent.maxY = std::max(lot.extent.maxY, q.y);
+    }
+    lot.staticPolygonCount = lot.allWorld.size();
+
+    // 5. 行人：在未旋转的坐标系里随机挑一条通道出生，匀速直线行走
+    for (double ay : aisleYs) lot.aisles.push_back({0.0, ay, width, ay + cfg.aisleWidth});
+    for (int k = 0; k < cfg.pedestrians; ++k) {
+        ScenarioRng rng = root.substream(kPedestrianStreamBase + k);
+        Pedestrian ped;
+        ped.aisle = (uint32_t)rng.uniformInt(0, (int)lot.aisles.size() - 1);
+        const Bounds a = walkable(lot.aisles[ped.aisle], cfg.pedestrianRadius);
+        ped.pos = {rng.uniform(a.minX, a.maxX), rng.uniform(a.minY, a.maxY)};
+        double heading = rng.uniform(0.0, 2.0 * kPi);
+        double speed = cfg.pedestrianSpeed * rng.uniform(0.5, 1.5);
+        ped.vel = {speed * std::cos(heading), speed * std::sin(heading)};
+        lot.pedestrians.push_back(ped);
+        lot.allWorld.push_back(createPillar(rotate(ped.pos, c, s), 2.0 * cfg.pedestrianRadius, 8));
+    }
+
+    lot.obstacles = buildObstacleSet(lot.allWorld);
+    return lot;
+}
+
+void advancePedestrians(ParkingLot& lot, double dt) {
+    double s, c;
+    sinCos(lot.config.lotYaw, s, c);
+    for (size_t k = 0; k < lot.pedestrians.size(); ++k) {
+        Pedestrian& ped = lot.pedestrians[k];
+        const Bounds e = walkable(lot.aisles[ped.aisle], lot.config.pedestrianRadius);
+        ped.pos = ped.pos + ped.vel * dt;
+        if (ped.pos.x < e.minX || ped.pos.x > e.maxX) {
+            ped.vel.x = -ped.vel.x;
+            ped.pos.x = std::min(std::max(ped.pos.x, e.minX), e.maxX);
+        }
+        if (ped.pos.y < e.minY || ped.pos.y > e.maxY) {
+            ped.vel.y = -ped.vel.y;
+            ped.pos.y = std::min(std::max(ped.pos.y, e.minY), e.maxY);
+        }
+
+        const size_t p = lot.staticPolygonCount + k;
+        std::vector<Vec2>& poly = lot.allWorld[p];
+        poly = createPillar(rotate(ped.pos, c, s), 2.0 * lot.config.pedestrianRadius, (int)poly.size());
+
+        // ObstacleSet 中行人多边形顶点数不变，直接原地覆盖坐标与包围盒
+        Bounds b = {HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+        uint32_t off = lot.obstacles.offsets[p];
+        for (size_t i = 0; i < poly.size(); ++i) {
+            lot.obstacles.xs[off + i] = poly[i].x;
+            lot.obstacles.ys[off + i] = poly[i].y;
+            b.minX = std::min(b.minX, poly[i].x);
+            b.minY = std::min(b.minY, poly[i].y);
+            b.maxX = std::max(b.maxX, poly[i].x);
+            b.maxY = std::max(b.maxY, poly[i].y);
+        }
+        lot.obstacles.bounds[p] = b;
+    }
+}
+
+LotConfig lotConfig(int slots, uint64_t seed) {
+    LotConfig cfg;
+    cfg.seed = seed;
+    cfg.slotsPerRow = 50;
+    cfg.bays = std::max(1, (slots + 2 * cfg.slotsPerRow - 1) / (2 * cfg.slotsPerRow));
+    cfg.pedestrians = std::max(20, slots / 20);
+    cfg.threads = 0;
+    return cfg;
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "slot_shift.h"
+
+// --- 停车场场景生成 ---
+// 默认尺寸按 1 单位 = 0.1 m 取值 (车位 2.5 m x 5 m)，与可视化程序的像素尺度相当。
+struct LotConfig {
+    uint64_t seed = 1;
+
+    // 布局：每个车位区 (bay) 由背靠背的两排车位组成，车位区之间是通道
+    int bays = 4;
+    int slotsPerRow = 40;
+    double slotWidth = 25.0;
+    double slotDepth = 50.0;
+    double aisleWidth = 60.0;
+    // 各排车位与通道的夹角 (度，(0, 90])，按排轮流取用；90 为垂直车位。区间外的取值被忽略，全部无效时按 90 处理
+    std::vector<double> rowAngles{90.0, 60.0, 45.0};
+    // 整个停车场绕原点的旋转 (弧度)，让线段不再与坐标轴对齐
+    double lotYaw = 0.0;
+
+    // 障碍物
+    double occupancy = 0.6;     // 停了车的车位比例
+    double parkingJitter = 3.0; // 停车横向偏差上限，偏差大的车会压到相邻车位线
+    int vehicleVertices = 8;    // 车辆轮廓顶点数，>8 时沿边加密，用来把场景推到百万顶点规模
+    int pillarEvery = 3;        // 每隔多少个车位在背线上放一根柱子，<=0 表示不放
+    double pillarSize = 8.0;
+    double curbThickness = 3.0;
+    int pedestrians = 20;
+    double pedestrianRadius = 4.0;
+    double pedestrianSpeed = 14.0; // 单位 / 秒
+
+    // 计算参数
+    double margin = 3.0;
+    double detectionRange = 10.0;
+
+    // 生成线程数 (0 表示硬件并发数)，不影响结果
+    unsigned threads = 1;
+};
+
+struct ParkingSlot {
+    Vec2 corners[4];   // 通道侧左、通道侧右、背线右、背线左
+    double angleDeg;
+    bool occupied;
+    uint32_t firstSegment; // 该车位两条侧边在 segments 里的下标 (左、右)
+};
+
+// 行人的位置与速度在停车场未旋转 (lotYaw 之前) 的坐标系里，障碍物多边形按 lotYaw 旋转后写入 allWorld
+struct Pedestrian {
+    Vec2 pos;
+    Vec2 vel;
+    uint32_t aisle; // 所在通道在 ParkingLot::aisles 里的下标
+};
+
+struct ParkingLot {
+    LotConfig config;
+    Bounds extent;
+
+    std::vector<ParkingSlot> slots;
+    // 每个车位两条侧边线，heading 指向车位内侧：相邻车辆越线时把边线推进车位
+    std::vector<Segment> segments;
+    std::vector<uint32_t> segmentSlot;
+    // 通道 (车位区之间与两端) 的范围，未旋转的坐标系；行人只在通道里走
+    std::vector<Bounds> aisles;
+
+    // 障碍物：静态部分 (车辆、柱子、路沿) 在前，行人在最后 staticPolygonCount 之后
+    std::vector<std::vector<Vec2>> allWorld;
+    size_t staticPolygonCount = 0;
+    std::vector<Pedestrian> pedestrians;
+    ObstacleSet obstacles;
+
+    size_t obstacleVertexCount() const { return obstacles.vertexCount(); }
+};
+
+ParkingLot generateParkingLot(const LotConfig& cfg);
+
+// 命令行工具共用的整场规模：每排 50 个车位，排数按 slots 取整，行人数随规模增长，生成线程取硬件并发数。
+// 同样的 slots / seed 得到同样的场景，录制端与回放端、写者与读者、服务端与压测端各自生成也能对上
+LotConfig lotConfig(int slots, uint64_t seed);
+
+// 让行人按各自速度走 dt 秒，碰到所在通道的边界反弹；allWorld 与 obstacles 中行人部分原地更新
+void advancePedestrians(ParkingLot& lot, double dt);
+
+// 把多边形沿边均匀加密到 targetVertices 个顶点 (不少于原顶点数)
+std::vector<Vec2> densifyPolygon(const std::vector<Vec2>& poly, int targetVertices);
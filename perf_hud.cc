@@ -0,0 +1,101 @@
+#include "perf_hud.h"
+
+#include <algorithm>
+
+#include "raylib.h"
+
+PerfHud::PerfHud(size_t historyFrames) : history_(std::max<size_t>(historyFrames, 2), 0.0f) {}
+
+void PerfHud::upsert(std::vector<Entry>& entries, const char* name, double value) {
+    for (auto& e : entries) {
+        if (e.name == name) {
+            e.value = value;
+            return;
+        }
+    }
+    entries.push_back({name, value});
+}
+
+void PerfHud::setPhase(const char* name, double ms) { upsert(phases_, name, ms); }
+
+void PerfHud::setCounter(const char* name, uint64_t value) { upsert(counters_, name, (double)value); }
+
+void PerfHud::setQueue(const char* name, size_t depth, size_t capacity, double waitMs) {
+    for (auto& q : queues_) {
+        if (q.name == name) {
+            q.depth = depth;
+            q.capacity = capacity;
+            q.waitMs = waitMs;
+            return;
+        }
+    }
+    queues_.push_back({name, depth, capacity, waitMs});
+}
+
+void PerfHud::pushFrameTime(double ms) {
+    history_[head_] = (float)ms;
+    head_ = (head_ + 1) % history_.size();
+    filled_ = std::min(filled_ + 1, history_.size());
+}
+
+double PerfHud::frameTimePercentile(double p) const {
+    if (filled_ == 0) return 0.0;
+    std::vector<float> v(history_.begin(), history_.begin() + filled_);
+    size_t k = std::min(filled_ - 1, (size_t)(p * (filled_ - 1) + 0.5));
+    std::nth_element(v.begin(), v.begin() + k, v.end());
+    return v[k];
+}
+
+void PerfHud::draw(int x, int y) const {
+    if (!visible_) return;
+
+    const int width = 420;
+    const int lineH = 18;
+    const int graphH = 80;
+    const int rows = 2 + (int)phases_.size() + (int)counters_.size() + (int)queues_.size();
+    const int height = 10 + rows * lineH + graphH + 16;
+
+    DrawRectangle(x, y, width, height, Fade(BLACK, 0.6f));
+    int ty = y + 6;
+    DrawText("Performance (F1)", x + 8, ty, 18, RAYWHITE);
+    ty += lineH + 2;
+
+    for (const auto& e : phases_) {
+        DrawText(TextFormat("%-14s %8.3f ms", e.name.c_str(), e.value), x + 8, ty, 16, LIGHTGRAY);
+        ty += lineH;
+    }
+    for (const auto& e : counters_) {
+        DrawText(TextFormat("%-14s %10.0f", e.name.c_str(), e.value), x + 8, ty, 16, SKYBLUE);
+        ty += lineH;
+    }
+    for (const auto& q : queues_) {
+        Color c = q.depth >= q.capacity ? ORANGE : GOLD;
+        DrawText(TextFormat("q %-12s %3d/%-3d %8.3f ms", q.name.c_str(), (int)q.depth, (int)q.capacity, q.waitMs),
+                 x + 8, ty, 16, c);
+        ty += lineH;
+    }
+
+    double p50 = frameTimePercentile(0.50);
+    double p99 = frameTimePercentile(0.99);
+    DrawText(TextFormat("frame p50 %.2f ms  p99 %.2f ms", p50, p99), x + 8, ty, 16, YELLOW);
+    ty += lineH + 4;
+
+    // 滚动帧时间曲线：纵轴上限取 33.3 ms 与 1.2 * p99 中较大者，16.7 ms 处画参考线
+    const int gx = x + 8;
+    const int gw = width - 16;
+    const float scaleMs = (float)std::max(33.3, p99 * 1.2);
+    DrawRectangleLines(gx, ty, gw, graphH, GRAY);
+    int ref = ty + graphH - (int)(graphH * 16.67f / scaleMs);
+    DrawLine(gx, ref, gx + gw, ref, Fade(GREEN, 0.6f));
+
+    const size_t n = history_.size();
+    for (size_t i = 0; i < filled_; ++i) {
+        size_t idx = (head_ + n - filled_ + i) % n;
+        float ms = history_[idx];
+        int h = std::min(graphH, (int)(graphH * ms / scaleMs));
+        int bx = gx + (int)((float)i * gw / n);
+        Color c = ms > 16.67f ? ORANGE : LIME;
+        if (ms > p99) c = RED;
+        DrawLine(bx, ty + graphH, bx, ty + graphH - h, c);
+    }
+}
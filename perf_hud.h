@@ -0,0 +1,64 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// --- 可视化程序的性能面板 ---
+// 每帧记录各阶段耗时与内核计数，叠加显示在窗口右上角；滚动帧时间曲线带 p50 / p99。
+class PerfHud {
+public:
+    explicit PerfHud(size_t historyFrames = 240);
+
+    void toggle() { visible_ = !visible_; }
+    bool visible() const { return visible_; }
+
+    // 阶段与计数器按首次出现的顺序显示，同名再次设置时覆盖
+    void setPhase(const char* name, double ms);
+    void setCounter(const char* name, uint64_t value);
+    // 流水线队列：当前深度 / 容量，以及最近一项在队列里等待的时间
+    void setQueue(const char* name, size_t depth, size_t capacity, double waitMs);
+    void pushFrameTime(double ms);
+
+    double frameTimePercentile(double p) const;
+
+    void draw(int x, int y) const;
+
+private:
+    struct Entry {
+        std::string name;
+        double value;
+    };
+    struct QueueEntry {
+        std::string name;
+        size_t depth;
+        size_t capacity;
+        double waitMs;
+    };
+    static void upsert(std::vector<Entry>& entries, const char* name, double value);
+
+    bool visible_ = false;
+    std::vector<Entry> phases_;
+    std::vector<Entry> counters_;
+    std::vector<QueueEntry> queues_;
+    std::vector<float> history_; // 环形缓冲
+    size_t head_ = 0;
+    size_t filled_ = 0;
+};
+
+// 简单的阶段计时器：构造时开始，lapMs() 返回距上次 lap 的毫秒数
+class PhaseTimer {
+public:
+    PhaseTimer() : last_(Clock::now()) {}
+    double lapMs() {
+        Clock::time_point now = Clock::now();
+        double ms = std::chrono::duration<double, std::milli>(now - last_).count();
+        last_ = now;
+        return ms;
+    }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point last_;
+};
@@ -0,0 +1,273 @@
+#include "recording.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static_assert(sizeof(RecordingFileHeader) == 64, "file header layout is part of the format");
+static_assert(sizeof(RecordingFrameHeader) == 64, "frame header layout is part of the format");
+static_assert(sizeof(RecordingIndexHeader) == 64, "index header layout is part of the format");
+static_assert(sizeof(RecordingFooter) == 16, "footer layout is part of the format");
+// 线段与包围盒按内存布局原样落盘，映射后直接当作数组使用
+static_assert(std::is_standard_layout<Segment>::value && sizeof(Segment) == 6 * sizeof(double) &&
+                  offsetof(Segment, end) == 2 * sizeof(double) && offsetof(Segment, heading) == 4 * sizeof(double),
+              "Segment layout is part of the format");
+static_assert(std::is_standard_layout<Bounds>::value && sizeof(Bounds) == 4 * sizeof(double),
+              "Bounds layout is part of the format");
+
+namespace {
+
+// 单帧上限，防止损坏的文件让读端越界
+const uint32_t kMaxElements = 1u << 28;
+
+uint64_t alignUp(uint64_t x) {
+    return (x + kRecordingAlignment - 1) & ~(uint64_t)(kRecordingAlignment - 1);
+}
+
+const unsigned char kZeros[kRecordingAlignment] = {};
+
+} // namespace
+
+RecordingFrameLayout recordingFrameLayout(uint32_t polygonCount, uint32_t vertexCount, uint32_t segmentCount) {
+    RecordingFrameLayout l;
+    uint64_t pos = sizeof(RecordingFrameHeader);
+    l.offsets = pos;
+    pos = alignUp(pos + sizeof(uint32_t) * ((uint64_t)polygonCount + 1));
+    l.xs = pos;
+    pos = alignUp(pos + sizeof(double) * (uint64_t)vertexCount);
+    l.ys = pos;
+    pos = alignUp(pos + sizeof(double) * (uint64_t)vertexCount);
+    l.bounds = pos;
+    pos = alignUp(pos + sizeof(Bounds) * (uint64_t)polygonCount);
+    l.segments = pos;
+    pos = alignUp(pos + sizeof(Segment) * (uint64_t)segmentCount);
+    l.shifts = pos;
+    pos = alignUp(pos + sizeof(double) * (uint64_t)segmentCount);
+    l.bytes = pos;
+    return l;
+}
+
+// --- 写端 ---
+bool RecordingWriter::fail(const std::string& what) {
+    error_ = what;
+    return false;
+}
+
+bool RecordingWriter::writeBlock(const void* data, size_t bytes) {
+    if (bytes && std::fwrite(data, 1, bytes, file_) != bytes) return false;
+    pos_ += bytes;
+    return true;
+}
+
+// 补零到下一个对齐边界
+bool RecordingWriter::pad() {
+    return writeBlock(kZeros, alignUp(pos_) - pos_);
+}
+
+bool RecordingWriter::open(const std::string& path) {
+    close();
+    error_.clear();
+    frameOffsets_.clear();
+    pos_ = 0;
+    file_ = std::fopen(path.c_str(), "wb");
+    if (!file_) return fail("cannot open " + path + ": " + std::strerror(errno));
+
+    RecordingFileHeader header = {};
+    std::memcpy(header.magic, kRecordingMagic, sizeof(header.magic));
+    header.version = kRecordingVersion;
+    header.endianTag = kRecordingEndianTag;
+    header.alignment = kRecordingAlignment;
+    if (!writeBlock(&header, sizeof(header))) return fail("failed to write file header");
+    return true;
+}
+
+bool RecordingWriter::writeFrame(const ObstacleView& obstacles, const Segment* segments, const double* shifts,
+                                 size_t segmentCount, double margin, double detectionRange, uint64_t timestampNs) {
+    if (!file_) return fail("recording is not open");
+    if (obstacles.polygonCount() > kMaxElements || obstacles.vertexCount() > kMaxElements ||
+        segmentCount > kMaxElements)
+        return fail("frame is too large to record");
+
+    RecordingFrameHeader header = {};
+    header.magic = kFrameMagic;
+    header.polygonCount = (uint32_t)obstacles.polygonCount();
+    header.vertexCount = (uint32_t)obstacles.vertexCount();
+    header.segmentCount = (uint32_t)segmentCount;
+    header.frameIndex = frameOffsets_.size();
+    header.timestampNs = timestampNs;
+    header.margin = margin;
+    header.detectionRange = detectionRange;
+    header.frameBytes = recordingFrameLayout(header.polygonCount, header.vertexCount, header.segmentCount).bytes;
+
+    const uint64_t start = pos_;
+    const size_t P = obstacles.polygonCount(), V = obstacles.vertexCount();
+    bool ok = writeBlock(&header, sizeof(header)) &&
+              writeBlock(obstacles.offsets, sizeof(uint32_t) * (P + 1)) && pad() &&
+              writeBlock(obstacles.xs, sizeof(double) * V) && pad() &&
+              writeBlock(obstacles.ys, sizeof(double) * V) && pad() &&
+              writeBlock(obstacles.bounds, sizeof(Bounds) * P) && pad() &&
+              writeBlock(segments, sizeof(Segment) * segmentCount) && pad() &&
+              writeBlock(shifts, sizeof(double) * segmentCount) && pad();
+    if (!ok) return fail("failed to write frame " + std::to_string(frameOffsets_.size()));
+    frameOffsets_.push_back(start);
+    return true;
+}
+
+bool RecordingWriter::writeFrame(const RecordedFrame& frame) {
+    return writeFrame(frame.obstacles, frame.segments, frame.shifts, frame.segmentCount, frame.margin,
+                      frame.detectionRange, frame.timestampNs);
+}
+
+bool RecordingWriter::close() {
+    if (!file_) return error_.empty();
+    RecordingIndexHeader index = {};
+    index.magic = kIndexMagic;
+    index.frameCount = frameOffsets_.size();
+    RecordingFooter footer;
+    std::memcpy(footer.magic, kRecordingFooterMagic, sizeof(footer.magic));
+    footer.indexOffset = pos_;
+    bool ok = writeBlock(&index, sizeof(index)) &&
+              writeBlock(frameOffsets_.data(), sizeof(uint64_t) * frameOffsets_.size()) &&
+              writeBlock(&footer, sizeof(footer));
+    ok = std::fclose(file_) == 0 && ok;
+    file_ = nullptr;
+    return ok ? true : fail("failed to write frame index");
+}
+
+// --- 映射读端 ---
+bool MappedRecording::fail(const std::string& what) {
+    error_ = what;
+    return false;
+}
+
+bool MappedRecording::open(const std::string& path) {
+    close();
+    error_.clear();
+    fd_ = ::open(path.c_str(), O_RDONLY);
+    if (fd_ < 0) return fail("cannot open " + path + ": " + std::strerror(errno));
+    struct stat st;
+    if (fstat(fd_, &st) != 0) return fail("cannot stat " + path + ": " + std::strerror(errno));
+    if ((size_t)st.st_size < sizeof(RecordingFileHeader)) return fail("truncated file header");
+    size_ = (size_t)st.st_size;
+    void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (p == MAP_FAILED) {
+        size_ = 0;
+        return fail("cannot map " + path + ": " + std::strerror(errno));
+    }
+    base_ = (unsigned char*)p;
+
+    const RecordingFileHeader* header = (const RecordingFileHeader*)base_;
+    if (std::memcmp(header->magic, kRecordingMagic, sizeof(header->magic)) != 0) return fail("not a slot recording");
+    if (header->endianTag != kRecordingEndianTag) return fail("recording was written with a different byte order");
+    if (header->version != kRecordingVersion)
+        return fail("unsupported recording version " + std::to_string(header->version));
+    if (header->alignment != kRecordingAlignment) return fail("unsupported block alignment");
+
+    if (!loadIndex()) scanFrames();
+    return true;
+}
+
+// 读文件末尾的索引；任何一处对不上都返回 false，改为扫描
+bool MappedRecording::loadIndex() {
+    if (size_ < sizeof(RecordingFileHeader) + sizeof(RecordingIndexHeader) + sizeof(RecordingFooter)) return false;
+    const RecordingFooter* footer = (const RecordingFooter*)(base_ + size_ - sizeof(RecordingFooter));
+    if (std::memcmp(footer->magic, kRecordingFooterMagic, sizeof(footer->magic)) != 0) return false;
+    const uint64_t indexOffset = footer->indexOffset;
+    if (indexOffset < sizeof(RecordingFileHeader) || indexOffset % kRecordingAlignment != 0 ||
+        indexOffset + sizeof(RecordingIndexHeader) > size_)
+        return false;
+    const RecordingIndexHeader* index = (const RecordingIndexHeader*)(base_ + indexOffset);
+    if (index->magic != kIndexMagic) return false;
+    if (index->frameCount > size_ / sizeof(uint64_t) ||
+        indexOffset + sizeof(RecordingIndexHeader) + index->frameCount * sizeof(uint64_t) + sizeof(RecordingFooter) != size_)
+        return false;
+
+    const uint64_t* offsets = (const uint64_t*)(base_ + indexOffset + sizeof(RecordingIndexHeader));
+    uint64_t prev = 0;
+    for (uint64_t i = 0; i < index->frameCount; ++i) {
+        const uint64_t off = offsets[i];
+        if (off < sizeof(RecordingFileHeader) || off % kRecordingAlignment != 0 || off <= prev ||
+            off + sizeof(RecordingFrameHeader) > indexOffset)
+            return false;
+        prev = off;
+    }
+    frameOffsets_.assign(offsets, offsets + index->frameCount);
+    framesEnd_ = indexOffset;
+    indexRecovered_ = false;
+    return true;
+}
+
+// 从第一帧开始顺着 frameBytes 往后走，遇到索引、截断或损坏的头部就停下
+void MappedRecording::scanFrames() {
+    frameOffsets_.clear();
+    indexRecovered_ = true;
+    uint64_t off = sizeof(RecordingFileHeader);
+    while (off + sizeof(RecordingFrameHeader) <= size_) {
+        const RecordingFrameHeader* h = (const RecordingFrameHeader*)(base_ + off);
+        if (h->magic != kFrameMagic || h->polygonCount > kMaxElements || h->vertexCount > kMaxElements ||
+            h->segmentCount > kMaxElements)
+            break;
+        if (h->frameBytes != recordingFrameLayout(h->polygonCount, h->vertexCount, h->segmentCount).bytes ||
+            off + h->frameBytes > size_)
+            break;
+        frameOffsets_.push_back(off);
+        off += h->frameBytes;
+    }
+    framesEnd_ = off;
+}
+
+bool MappedRecording::frame(size_t i, RecordedFrame& out) {
+    if (!base_) return fail("recording is not open");
+    if (i >= frameOffsets_.size()) return fail("frame " + std::to_string(i) + " out of range");
+
+    const uint64_t off = frameOffsets_[i];
+    const RecordingFrameHeader* h = (const RecordingFrameHeader*)(base_ + off);
+    const std::string where = "frame " + std::to_string(i);
+    if (h->magic != kFrameMagic) return fail(where + " has a bad magic");
+    if (h->polygonCount > kMaxElements || h->vertexCount > kMaxElements || h->segmentCount > kMaxElements)
+        return fail(where + " is implausibly large");
+    const RecordingFrameLayout l = recordingFrameLayout(h->polygonCount, h->vertexCount, h->segmentCount);
+    if (h->frameBytes != l.bytes || off + l.bytes > frameEnd(i)) return fail(where + " is truncated");
+
+    const unsigned char* f = base_ + off;
+    const uint32_t* offsets = (const uint32_t*)(f + l.offsets);
+    // 内核按 offsets 下标访问坐标，必须保证单调且不越界
+    if (offsets[0] != 0 || offsets[h->polygonCount] != h->vertexCount)
+        return fail(where + " has inconsistent polygon offsets");
+    for (uint32_t p = 0; p < h->polygonCount; ++p) {
+        if (offsets[p + 1] < offsets[p]) return fail(where + " has inconsistent polygon offsets");
+    }
+
+    out.frameIndex = h->frameIndex;
+    out.timestampNs = h->timestampNs;
+    out.margin = h->margin;
+    out.detectionRange = h->detectionRange;
+    out.obstacles.xs = (const double*)(f + l.xs);
+    out.obstacles.ys = (const double*)(f + l.ys);
+    out.obstacles.offsets = offsets;
+    out.obstacles.bounds = (const Bounds*)(f + l.bounds);
+    out.obstacles.polygons = h->polygonCount;
+    out.obstacles.vertices = h->vertexCount;
+    out.segments = (const Segment*)(f + l.segments);
+    out.shifts = (const double*)(f + l.shifts);
+    out.segmentCount = h->segmentCount;
+    return true;
+}
+
+void MappedRecording::close() {
+    if (base_) munmap(base_, size_);
+    if (fd_ >= 0) ::close(fd_);
+    base_ = nullptr;
+    size_ = 0;
+    fd_ = -1;
+    framesEnd_ = 0;
+    frameOffsets_.clear();
+    indexRecovered_ = false;
+}
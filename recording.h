@@ -0,0 +1,156 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "slot_shift.h"
+
+// --- 障碍物帧录制格式 (v2) ---
+// 小端，所有块按 64 字节对齐，整个文件 mmap 之后每帧的 SoA 数组可以直接作为 ObstacleView 交给内核：
+//
+//   FileHeader                                  64 字节
+//   重复 N 次 (每帧从 64 字节边界开始)：
+//     FrameHeader                               64 字节
+//     uint32_t offsets[polygonCount + 1]        以下每块都从 64 字节边界开始
+//     double   xs[vertexCount]
+//     double   ys[vertexCount]
+//     Bounds   bounds[polygonCount]
+//     Segment  segments[segmentCount]
+//     double   shifts[segmentCount]             录制时内核给出的目标推移量
+//   IndexHeader                                 64 字节
+//   uint64_t frameOffsets[N]                    每帧 FrameHeader 的文件偏移
+//   Footer                                      16 字节，位于文件末尾
+//
+// 块在帧内的位置只由三个计数决定 (recordingFrameLayout)，文件里不另存。
+// 帧索引在 close() 时写入；录制中途崩溃的文件没有索引，读端会顺着 frameBytes 重新扫描出已写完的帧。
+const char kRecordingMagic[8] = {'S', 'L', 'O', 'T', 'R', 'E', 'C', '\0'};
+const char kRecordingFooterMagic[8] = {'S', 'L', 'O', 'T', 'I', 'D', 'X', '\0'};
+const uint32_t kRecordingVersion = 2;
+const uint32_t kRecordingEndianTag = 0x01020304;
+const uint32_t kRecordingAlignment = 64;
+const uint32_t kFrameMagic = 0x4d524646; // "FFRM"
+const uint32_t kIndexMagic = 0x58444e49; // "INDX"
+
+struct RecordingFileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag; // 读端据此拒绝字节序不同的文件
+    uint32_t alignment;
+    uint8_t reserved[44];
+};
+
+struct RecordingFrameHeader {
+    uint32_t magic;
+    uint32_t polygonCount;
+    uint32_t vertexCount;
+    uint32_t segmentCount;
+    uint64_t frameIndex;
+    uint64_t timestampNs;
+    double margin;
+    double detectionRange;
+    uint64_t frameBytes; // 含本头部与末尾填充，下一帧紧随其后
+    uint64_t reserved;
+};
+
+struct RecordingIndexHeader {
+    uint32_t magic;
+    uint32_t reserved0;
+    uint64_t frameCount;
+    uint8_t reserved[48];
+};
+
+struct RecordingFooter {
+    char magic[8];
+    uint64_t indexOffset; // IndexHeader 的文件偏移
+};
+
+// 各块相对帧起点的字节偏移
+struct RecordingFrameLayout {
+    uint64_t offsets, xs, ys, bounds, segments, shifts;
+    uint64_t bytes; // 整帧大小 (对齐后)
+};
+
+RecordingFrameLayout recordingFrameLayout(uint32_t polygonCount, uint32_t vertexCount, uint32_t segmentCount);
+
+// 一帧的只读视图。从 MappedRecording 取得时所有指针都直接指向映射区，在 close() 之前有效。
+struct RecordedFrame {
+    uint64_t frameIndex = 0;
+    uint64_t timestampNs = 0;
+    double margin = 0.0;
+    double detectionRange = 0.0;
+    ObstacleView obstacles;
+    const Segment* segments = nullptr;
+    const double* shifts = nullptr; // 与 segments 一一对应
+    size_t segmentCount = 0;
+};
+
+class RecordingWriter {
+public:
+    RecordingWriter() = default;
+    ~RecordingWriter() { close(); }
+    RecordingWriter(const RecordingWriter&) = delete;
+    RecordingWriter& operator=(const RecordingWriter&) = delete;
+
+    bool open(const std::string& path);
+    bool writeFrame(const ObstacleView& obstacles, const Segment* segments, const double* shifts, size_t segmentCount,
+                    double margin, double detectionRange, uint64_t timestampNs);
+    bool writeFrame(const RecordedFrame& frame);
+    // 写入帧索引并关闭文件
+    bool close();
+
+    bool isOpen() const { return file_ != nullptr; }
+    uint64_t framesWritten() const { return frameOffsets_.size(); }
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& what);
+    bool writeBlock(const void* data, size_t bytes);
+    bool pad();
+
+    FILE* file_ = nullptr;
+    uint64_t pos_ = 0;
+    std::vector<uint64_t> frameOffsets_;
+    std::string error_;
+};
+
+// 把整个录制文件只读映射进来，按帧下标随机访问，不拷贝、不反序列化。
+class MappedRecording {
+public:
+    MappedRecording() = default;
+    ~MappedRecording() { close(); }
+    MappedRecording(const MappedRecording&) = delete;
+    MappedRecording& operator=(const MappedRecording&) = delete;
+
+    bool open(const std::string& path);
+    void close();
+
+    size_t frameCount() const { return frameOffsets_.size(); }
+    // 校验并返回第 i 帧；只检查头部与 offsets 数组，不触碰坐标数据
+    bool frame(size_t i, RecordedFrame& out);
+    // 文件没有有效索引 (例如录制中途退出)，帧列表是扫描出来的
+    bool indexRecovered() const { return indexRecovered_; }
+
+    // 映射区与每帧的字节范围，供预读提示使用
+    const unsigned char* data() const { return base_; }
+    size_t size() const { return size_; }
+    uint64_t frameOffset(size_t i) const { return frameOffsets_[i]; }
+    uint64_t frameEnd(size_t i) const { return i + 1 < frameOffsets_.size() ? frameOffsets_[i + 1] : framesEnd_; }
+    int fd() const { return fd_; }
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& what);
+    bool loadIndex();
+    void scanFrames();
+
+    int fd_ = -1;
+    unsigned char* base_ = nullptr;
+    size_t size_ = 0;
+    uint64_t framesEnd_ = 0; // 最后一帧的结束位置 (索引或文件尾)
+    std::vector<uint64_t> frameOffsets_;
+    bool indexRecovered_ = false;
+    std::string error_;
+};
@@ -0,0 +1,134 @@
+#include "recording_stream.h"
+
+#include <chrono>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "trace.h"
+
+bool RecordingStream::open(const std::string& path, size_t depth, bool releaseConsumed) {
+    close();
+    error_.clear();
+    if (!rec_.open(path)) {
+        error_ = rec_.error();
+        return false;
+    }
+    depth_ = depth;
+    releaseConsumed_ = releaseConsumed;
+    long page = sysconf(_SC_PAGESIZE);
+    pageSize_ = page > 0 ? (size_t)page : 4096;
+    produced_ = consumed_ = 0;
+    producerDone_ = stop_ = false;
+    producerError_.clear();
+    stalls_ = stallNs_ = 0;
+
+    // 整个文件按顺序读：让内核加大预读窗口，读过的页优先回收
+    posix_fadvise(rec_.fd(), 0, 0, POSIX_FADV_SEQUENTIAL);
+    madvise((void*)rec_.data(), rec_.size(), MADV_SEQUENTIAL);
+
+    if (depth_ > 0) {
+        ring_.assign(depth_, RecordedFrame());
+        thread_ = std::thread(&RecordingStream::prefetchLoop, this);
+    }
+    return true;
+}
+
+// 把第 i 帧的页提前调进来并映射到本进程：先发 WILLNEED 让内核异步读盘，再逐页读一个字节
+void RecordingStream::prefault(size_t i) {
+    SLOTSHIFT_TRACE_SCOPE("stream_prefault");
+    const uintptr_t base = (uintptr_t)rec_.data();
+    uintptr_t begin = (base + rec_.frameOffset(i)) & ~(uintptr_t)(pageSize_ - 1);
+    uintptr_t end = base + rec_.frameEnd(i);
+    madvise((void*)begin, end - begin, MADV_WILLNEED);
+    unsigned sum = 0;
+    for (uintptr_t p = begin; p < end; p += pageSize_) sum += *(const volatile unsigned char*)p;
+    (void)sum;
+}
+
+// 交还第 i 帧独占的整页；与相邻帧共享的首尾页留着，避免把已经预读的下一帧丢掉
+void RecordingStream::release(size_t i) {
+    const uintptr_t base = (uintptr_t)rec_.data();
+    uintptr_t begin = (base + rec_.frameOffset(i) + pageSize_ - 1) & ~(uintptr_t)(pageSize_ - 1);
+    uintptr_t end = (base + rec_.frameEnd(i)) & ~(uintptr_t)(pageSize_ - 1);
+    if (end > begin) madvise((void*)begin, end - begin, MADV_DONTNEED);
+}
+
+void RecordingStream::prefetchLoop() {
+    traceSetThreadName("recording_prefetch");
+    const size_t total = rec_.frameCount();
+    for (size_t i = 0; i < total; ++i) {
+        {
+            std::unique_lock<std::mutex> lock(mu_);
+            space_.wait(lock, [&] { return stop_ || produced_ - consumed_ < depth_; });
+            if (stop_) return;
+        }
+        RecordedFrame frame;
+        bool ok = rec_.frame(i, frame);
+        if (ok) prefault(i);
+
+        std::lock_guard<std::mutex> lock(mu_);
+        if (!ok) {
+            producerError_ = rec_.error();
+            break;
+        }
+        ring_[i % depth_] = frame;
+        produced_ = i + 1;
+        ready_.notify_one();
+    }
+    std::lock_guard<std::mutex> lock(mu_);
+    producerDone_ = true;
+    ready_.notify_one();
+}
+
+bool RecordingStream::next(RecordedFrame& frame) {
+    if (!rec_.data()) {
+        error_ = "recording is not open";
+        return false;
+    }
+    // 上一帧的视图到此失效
+    if (releaseConsumed_ && consumed_ > 0) release(consumed_ - 1);
+
+    if (depth_ == 0) {
+        if (consumed_ >= rec_.frameCount()) return false;
+        if (!rec_.frame(consumed_, frame)) {
+            error_ = rec_.error();
+            return false;
+        }
+        ++consumed_;
+        return true;
+    }
+
+    std::unique_lock<std::mutex> lock(mu_);
+    if (produced_ == consumed_ && !producerDone_) {
+        SLOTSHIFT_TRACE_SCOPE("stream_stall");
+        std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+        ready_.wait(lock, [&] { return produced_ > consumed_ || producerDone_; });
+        ++stalls_;
+        stallNs_ += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - t0).count();
+    }
+    if (produced_ == consumed_) {
+        error_ = producerError_;
+        return false;
+    }
+    frame = ring_[consumed_ % depth_];
+    ++consumed_;
+    lock.unlock();
+    space_.notify_one();
+    return true;
+}
+
+void RecordingStream::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mu_);
+            stop_ = true;
+        }
+        space_.notify_one();
+        thread_.join();
+    }
+    ring_.clear();
+    rec_.close();
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "recording.h"
+
+// --- 带预读的顺序回放 ---
+// 后台线程沿着映射区往前走最多 depth 帧：校验帧头、madvise(WILLNEED) 并逐页触碰，
+// 把缺页与磁盘读取挪出计算线程；准备好的帧视图放进容量为 depth 的环形队列按顺序交付。
+// 消费者取走下一帧时，上一帧占用的整页用 madvise(DONTNEED) 交还，常驻内存只与 depth 有关，与文件大小无关。
+// depth 为 0 时不启线程，next() 同步校验并返回下一帧，便于对比。
+class RecordingStream {
+public:
+    RecordingStream() = default;
+    ~RecordingStream() { close(); }
+    RecordingStream(const RecordingStream&) = delete;
+    RecordingStream& operator=(const RecordingStream&) = delete;
+
+    bool open(const std::string& path, size_t depth = 8, bool releaseConsumed = true);
+    // 按顺序取下一帧；返回的视图在下一次调用 next() 或 close() 之前有效。
+    // 结束或出错时返回 false，二者用 error() 是否为空区分
+    bool next(RecordedFrame& frame);
+    void close();
+
+    size_t frameCount() const { return rec_.frameCount(); }
+    bool indexRecovered() const { return rec_.indexRecovered(); }
+    // 消费者在 next() 里等待预读线程的次数与总时长
+    uint64_t stalls() const { return stalls_; }
+    double stallSeconds() const { return stallNs_ * 1e-9; }
+    const std::string& error() const { return error_; }
+
+private:
+    void prefetchLoop();
+    void prefault(size_t i);
+    void release(size_t i);
+
+    MappedRecording rec_;
+    size_t depth_ = 0;
+    bool releaseConsumed_ = true;
+    size_t pageSize_ = 4096;
+
+    std::thread thread_;
+    std::mutex mu_;
+    std::condition_variable ready_; // 队列非空或预读结束
+    std::condition_variable space_; // 队列有空位或要求停止
+    std::vector<RecordedFrame> ring_;
+    size_t produced_ = 0; // 已放入队列的帧数 (也是下一个要预读的帧下标)
+    size_t consumed_ = 0; // 已交付给消费者的帧数
+    bool producerDone_ = false;
+    bool stop_ = false;
+    std::string producerError_;
+
+    uint64_t stalls_ = 0;
+    uint64_t stallNs_ = 0;
+    std::string error_;
+};
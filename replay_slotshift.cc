@@ -0,0 +1,266 @@
+// replay_slotshift：在录制文件上全速重跑内核变体，与录制时的结果逐帧比对并统计耗时。
+// 也可以用 --generate 从停车场生成器无界面地录制一段场景。
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+#include "parking_lot.h"
+#include "recording.h"
+#include "recording_stream.h"
+#include "shift_variants.h"
+#include "tool_stats.h"
+#include "trace.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string input;
+    std::vector<std::string> variants; // 为空表示全部
+    int repeat = 1;
+    unsigned threads = 0;
+    int prefetch = 8; // 预读深度 (帧)，0 表示在计算线程里同步读取
+    double tolerance = 0.0;
+    bool verbose = false;
+    const char* tracePath = nullptr;
+
+    // --generate
+    std::string generatePath;
+    int frames = 300;
+    int slots = 2000;
+    uint64_t seed = 1;
+};
+
+struct VariantReport {
+    explicit VariantReport(const ShiftVariant* v) : variant(v) {}
+
+    const ShiftVariant* variant;
+    uint64_t frames = 0;
+    uint64_t segments = 0;
+    double work = 0.0; // 线段数 x 顶点数
+    double seconds = 0.0;
+    std::vector<double> frameMs;
+    uint64_t mismatches = 0;
+    double maxAbsDiff = 0.0;
+    int64_t firstMismatchFrame = -1;
+    int64_t firstMismatchSegment = -1;
+};
+
+void usage(const char* argv0) {
+    std::printf("usage: %s <recording> [--variant NAME]... [--repeat N] [--threads N] [--tolerance T] [--verbose]\n"
+                "                      [--prefetch N] [--trace out.json]\n"
+                "       %s --generate <recording> [--frames N] [--slots N] [--seed N]\n"
+                "variants:",
+                argv0, argv0);
+    for (const ShiftVariant& v : shiftVariants()) std::printf(" %s", v.name);
+    std::printf("\n");
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", a.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--variant") {
+            opt.variants.push_back(next());
+        } else if (a == "--repeat") {
+            opt.repeat = std::max(1, std::atoi(next()));
+        } else if (a == "--threads") {
+            opt.threads = (unsigned)std::atoi(next());
+        } else if (a == "--prefetch") {
+            opt.prefetch = std::max(0, std::atoi(next()));
+        } else if (a == "--tolerance") {
+            opt.tolerance = std::atof(next());
+        } else if (a == "--verbose") {
+            opt.verbose = true;
+        } else if (a == "--trace") {
+            opt.tracePath = next();
+        } else if (a == "--generate") {
+            opt.generatePath = next();
+        } else if (a == "--frames") {
+            opt.frames = std::max(1, std::atoi(next()));
+        } else if (a == "--slots") {
+            opt.slots = std::max(1, std::atoi(next()));
+        } else if (a == "--seed") {
+            opt.seed = std::strtoull(next(), nullptr, 10);
+        } else if (!a.empty() && a[0] != '-' && opt.input.empty()) {
+            opt.input = a;
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.input.empty() && opt.generatePath.empty()) {
+        usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+// 无界面录制：停车场 + 走动的行人，每帧算出全部车位边线的推移量 (批量内核与参考实现逐位一致)
+int generate(const Options& opt) {
+    const LotConfig cfg = lotConfig(opt.slots, opt.seed);
+    ParkingLot lot = generateParkingLot(cfg);
+
+    RecordingWriter writer;
+    if (!writer.open(opt.generatePath)) {
+        std::fprintf(stderr, "%s\n", writer.error().c_str());
+        return 1;
+    }
+    const double dt = 1.0 / 30.0;
+    std::vector<double> shifts(lot.segments.size());
+    for (int f = 0; f < opt.frames; ++f) {
+        advancePedestrians(lot, dt);
+        calculateSegmentShiftBatchParallel(lot.segments.data(), lot.segments.size(), lot.obstacles, cfg.margin,
+                                           cfg.detectionRange, shifts.data(), opt.threads);
+        if (!writer.writeFrame(lot.obstacles, lot.segments.data(), shifts.data(), shifts.size(), cfg.margin,
+                               cfg.detectionRange, (uint64_t)(f * dt * 1e9))) {
+            std::fprintf(stderr, "%s\n", writer.error().c_str());
+            return 1;
+        }
+    }
+    if (!writer.close()) {
+        std::fprintf(stderr, "%s\n", writer.error().c_str());
+        return 1;
+    }
+    std::printf("wrote %d frames (%zu segments, %zu obstacle vertices per frame) to %s\n", opt.frames,
+                lot.segments.size(), lot.obstacleVertexCount(), opt.generatePath.c_str());
+    return 0;
+}
+
+int replay(const Options& opt) {
+    std::vector<VariantReport> reports;
+    if (opt.variants.empty()) {
+        for (const ShiftVariant& v : shiftVariants()) reports.emplace_back(&v);
+    } else {
+        for (const std::string& name : opt.variants) {
+            const ShiftVariant* v = findShiftVariant(name);
+            if (!v) {
+                std::fprintf(stderr, "unknown variant '%s'\n", name.c_str());
+                return 2;
+            }
+            reports.emplace_back(v);
+        }
+    }
+    bool needPolygons = false;
+    for (const VariantReport& r : reports) needPolygons = needPolygons || r.variant->needsPolygons;
+
+    RecordingStream stream;
+    if (!stream.open(opt.input, (size_t)opt.prefetch)) {
+        std::fprintf(stderr, "%s\n", stream.error().c_str());
+        return 1;
+    }
+    if (stream.indexRecovered())
+        std::fprintf(stderr, "warning: %s has no frame index (unfinished recording?), recovered %zu frames\n",
+                     opt.input.c_str(), stream.frameCount());
+
+    RecordedFrame frame;
+    std::vector<std::vector<Vec2>> polygons;
+    std::vector<double> out;
+    uint64_t frames = 0;
+    Clock::time_point wall0 = Clock::now();
+    double ioSeconds = 0.0;
+    for (;;) {
+        // 帧数据直接指向映射区，预读线程已校验头部并调入页面；参考实现需要的 AoS 副本在计时区外构建
+        Clock::time_point t0 = Clock::now();
+        {
+            SLOTSHIFT_TRACE_SCOPE("replay_next_frame");
+            if (!stream.next(frame)) break;
+            if (needPolygons) polygons = obstaclePolygons(frame.obstacles);
+        }
+        ioSeconds += std::chrono::duration<double>(Clock::now() - t0).count();
+        ++frames;
+
+        ShiftProblem p;
+        p.segments = frame.segments;
+        p.segmentCount = frame.segmentCount;
+        p.obstacles = frame.obstacles;
+        p.polygons = &polygons;
+        p.margin = frame.margin;
+        p.detectionRange = frame.detectionRange;
+        p.threads = opt.threads;
+        out.resize(p.segmentCount);
+
+        for (VariantReport& r : reports) {
+            double best = HUGE_VAL;
+            for (int k = 0; k < opt.repeat; ++k) {
+                Clock::time_point t = Clock::now();
+                r.variant->run(p, out.data());
+                double s = std::chrono::duration<double>(Clock::now() - t).count();
+                r.seconds += s;
+                best = std::min(best, s);
+            }
+            r.frameMs.push_back(best * 1e3);
+            r.frames++;
+            r.segments += p.segmentCount;
+            r.work += (double)p.segmentCount * frame.obstacles.vertexCount() * opt.repeat;
+
+            const double tol = std::max(opt.tolerance, r.variant->tolerance);
+            for (size_t i = 0; i < p.segmentCount; ++i) {
+                double diff = std::fabs(out[i] - frame.shifts[i]);
+                bool bad = tol == 0.0 ? out[i] != frame.shifts[i] : !(diff <= tol);
+                if (!bad) continue;
+                r.maxAbsDiff = std::max(r.maxAbsDiff, diff);
+                if (r.mismatches++ == 0) {
+                    r.firstMismatchFrame = (int64_t)frame.frameIndex;
+                    r.firstMismatchSegment = (int64_t)i;
+                }
+                if (opt.verbose) {
+                    std::printf("mismatch %s frame %llu seg %zu: %.17g vs recorded %.17g\n", r.variant->name,
+                                (unsigned long long)frame.frameIndex, i, out[i], frame.shifts[i]);
+                }
+            }
+        }
+    }
+    if (!stream.error().empty()) {
+        std::fprintf(stderr, "%s (after %llu frames)\n", stream.error().c_str(), (unsigned long long)frames);
+        return 1;
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - wall0).count();
+
+    std::printf("%llu frames, next-frame %.3f s (%llu stalls, %.3f s waiting on prefetch depth %d), wall %.3f s\n",
+                (unsigned long long)frames, ioSeconds, (unsigned long long)stream.stalls(), stream.stallSeconds(),
+                opt.prefetch, wall);
+    std::printf("%-12s %8s | %9s %9s %9s | %9s %10s | %10s %10s\n", "variant", "segs", "ms p50", "ms p99", "ms max",
+                "ns/vertex", "vert/s", "mismatch", "max diff");
+    bool ok = true;
+    for (const VariantReport& r : reports) {
+        std::printf("%-12s %8llu | %9.3f %9.3f %9.3f | %9.4f %10.3e | %10llu %10.3g\n", r.variant->name,
+                    (unsigned long long)r.segments, percentile(r.frameMs, 0.5), percentile(r.frameMs, 0.99),
+                    percentile(r.frameMs, 1.0), r.work > 0 ? r.seconds * 1e9 / r.work : 0.0,
+                    r.seconds > 0 ? r.work / r.seconds : 0.0, (unsigned long long)r.mismatches, r.maxAbsDiff);
+        if (r.mismatches) {
+            std::printf("  first mismatch: frame %lld segment %lld\n", (long long)r.firstMismatchFrame,
+                        (long long)r.firstMismatchSegment);
+            ok = false;
+        }
+    }
+    return ok ? 0 : 1;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+    if (opt.tracePath) {
+        traceSetThreadName("replay");
+        traceEnable(true);
+    }
+    int rc = opt.generatePath.empty() ? replay(opt) : generate(opt);
+    if (opt.tracePath) {
+        traceEnable(false);
+        if (!traceWriteChromeJson(opt.tracePath)) std::fprintf(stderr, "failed to write trace %s\n", opt.tracePath);
+    }
+    return rc;
+}
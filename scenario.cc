@@ -0,0 +1,114 @@
+#include "scenario.h"
+
+#include <algorithm>
+#include <cmath>
+#include <thread>
+
+namespace {
+
+const double kPi = 3.14159265358979323846;
+
+inline uint64_t splitmix64(uint64_t z) {
+    z += 0x9E3779B97F4A7C15ull;
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+inline Vec2 rotate(Vec2 v, double c, double s) { return {v.x * c - v.y * s, v.x * s + v.y * c}; }
+
+} // namespace
+
+// --- 可复现的计数器随机数 ---
+uint64_t ScenarioRng::hash(uint64_t seed, uint64_t stream, uint64_t counter) {
+    return splitmix64(seed ^ splitmix64(stream ^ splitmix64(counter)));
+}
+
+int ScenarioRng::uniformInt(int lo, int hi) {
+    uint64_t span = (uint64_t)((int64_t)hi - (int64_t)lo + 1);
+    return (int)((int64_t)lo + (int64_t)(((next() >> 32) * span) >> 32));
+}
+
+// --- 障碍物生成 ---
+std::vector<Vec2> createStarPolygon(ScenarioRng& rng, Vec2 center, int sides, double avgRadius) {
+    std::vector<Vec2> poly;
+    poly.reserve(sides);
+    for (int i = 0; i < sides; ++i) {
+        double angle = i * (2.0 * kPi / sides);
+        // 随机改变半径，产生凹凸感
+        double r = avgRadius * (0.6 + (double)rng.uniformInt(0, 80) / 100.0);
+        poly.push_back({center.x + r * std::cos(angle), center.y + r * std::sin(angle)});
+    }
+    return poly;
+}
+
+std::vector<Vec2> createVehicle(ScenarioRng& rng, Vec2 center, double yaw, double length, double width) {
+    double hl = 0.5 * length * rng.uniform(0.9, 1.1);
+    double hw = 0.5 * width * rng.uniform(0.92, 1.08);
+    double cf = 0.35 * hw; // 四角倒角
+    const Vec2 local[8] = {
+        {hl, -hw + cf}, {hl, hw - cf}, {hl - cf, hw}, {-hl + cf, hw},
+        {-hl, hw - cf}, {-hl, -hw + cf}, {-hl + cf, -hw}, {hl - cf, -hw},
+    };
+    double c = std::cos(yaw), s = std::sin(yaw);
+    std::vector<Vec2> poly;
+    poly.reserve(8);
+    for (const Vec2& v : local) poly.push_back(center + rotate(v, c, s));
+    return poly;
+}
+
+std::vector<Vec2> createPillar(Vec2 center, double size, int sides) {
+    std::vector<Vec2> poly;
+    double h = 0.5 * size;
+    if (sides <= 4) {
+        poly = {{center.x - h, center.y - h}, {center.x + h, center.y - h},
+                {center.x + h, center.y + h}, {center.x - h, center.y + h}};
+        return poly;
+    }
+    poly.reserve(sides);
+    for (int i = 0; i < sides; ++i) {
+        double angle = i * (2.0 * kPi / sides);
+        poly.push_back({center.x + h * std::cos(angle), center.y + h * std::sin(angle)});
+    }
+    return poly;
+}
+
+std::vector<Vec2> createWall(Vec2 a, Vec2 b, double thickness) {
+    Vec2 d = b - a;
+    double len = std::sqrt(d.x * d.x + d.y * d.y);
+    Vec2 n = (len > 1e-9) ? Vec2{-d.y / len, d.x / len} : Vec2{0, 1};
+    Vec2 off = n * (0.5 * thickness);
+    return {a + off, b + off, b - off, a - off};
+}
+
+std::vector<std::vector<Vec2>> generateStarPolygons(uint64_t seed, size_t count, const StarPolygonSpec& spec,
+                                                    unsigned threads) {
+    std::vector<std::vector<Vec2>> polys(count);
+    ScenarioRng root(seed);
+    auto generateRange = [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            ScenarioRng rng = root.substream(i);
+            Vec2 center = {rng.uniform(spec.minX, spec.maxX), rng.uniform(spec.minY, spec.maxY)};
+            int sides = rng.uniformInt(spec.minSides, spec.maxSides);
+            double radius = rng.uniform(spec.minRadius, spec.maxRadius);
+            polys[i] = createStarPolygon(rng, center, sides, radius);
+        }
+    };
+
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, count / 256));
+    if (threads <= 1) {
+        generateRange(0, count);
+        return polys;
+    }
+    std::vector<std::thread> workers;
+    const size_t chunk = (count + threads - 1) / threads;
+    for (unsigned t = 1; t < threads; ++t) {
+        size_t begin = std::min(count, t * chunk);
+        size_t end = std::min(count, begin + chunk);
+        workers.emplace_back(generateRange, begin, end);
+    }
+    generateRange(0, std::min(count, chunk));
+    for (auto& w : workers) w.join();
+    return polys;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "slot_shift.h"
+
+// --- 可复现的计数器随机数 ---
+// 第 n 个随机数只由 (seed, stream, n) 决定，与调用顺序、线程划分、标准库实现都无关。
+// 约定每个多边形使用独立的 stream，这样可以并行生成且结果与串行完全一致。
+class ScenarioRng {
+public:
+    ScenarioRng(uint64_t seed, uint64_t stream = 0) : seed_(seed), stream_(stream), counter_(0) {}
+
+    static uint64_t hash(uint64_t seed, uint64_t stream, uint64_t counter);
+
+    uint64_t next() { return hash(seed_, stream_, counter_++); }
+    // [0, 1) 均匀分布，取高 53 位
+    double uniform() { return (next() >> 11) * (1.0 / 9007199254740992.0); }
+    double uniform(double lo, double hi) { return lo + (hi - lo) * uniform(); }
+    // [lo, hi] 闭区间整数
+    int uniformInt(int lo, int hi);
+
+    // 派生子流：同一个种子下互不重叠的随机序列
+    ScenarioRng substream(uint64_t index) const { return ScenarioRng(hash(seed_, stream_, ~index), index); }
+
+private:
+    uint64_t seed_;
+    uint64_t stream_;
+    uint64_t counter_;
+};
+
+// --- 障碍物生成 ---
+// 星形随机多边形：与最初的 CreateComplexPoly 相同，半径在 [0.6, 1.4] * avgRadius 之间取值，产生凹凸感
+std::vector<Vec2> createStarPolygon(ScenarioRng& rng, Vec2 center, int sides, double avgRadius);
+
+// 车辆外轮廓：倒角矩形，yaw 为车头朝向 (弧度)，长宽带少量随机扰动
+std::vector<Vec2> createVehicle(ScenarioRng& rng, Vec2 center, double yaw, double length, double width);
+
+// 柱子：sides <= 4 时为正方形，否则为正多边形近似的圆柱
+std::vector<Vec2> createPillar(Vec2 center, double size, int sides = 4);
+
+// 墙体：沿 a -> b 的细长矩形
+std::vector<Vec2> createWall(Vec2 a, Vec2 b, double thickness);
+
+struct StarPolygonSpec {
+    double minX, minY, maxX, maxY; // 中心点分布范围
+    int minSides, maxSides;
+    double minRadius, maxRadius;
+};
+
+// 批量生成星形多边形：第 i 个多边形只使用子流 i，threads (0 表示硬件并发数) 不影响结果
+std::vector<std::vector<Vec2>> generateStarPolygons(uint64_t seed, size_t count, const StarPolygonSpec& spec,
+                                                    unsigned threads = 1);
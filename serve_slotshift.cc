@@ -0,0 +1,273 @@
+// serve_slotshift：本机推移量查询服务的守护进程与压测客户端。
+// --serve 持有停车场世界并在 Unix 域套接字上提供查询；--load 开若干连接并发查询，统计吞吐与尾延迟。
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "parking_lot.h"
+#include "shift_service.h"
+#include "tool_stats.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string socketPath = "/tmp/slotshift.sock";
+    bool serve = false;
+    bool load = false;
+    int slots = 2000; // 停车场规模 (车位数)
+    uint64_t seed = 1;
+    unsigned threads = 0;
+    int coalesceUs = 200;
+    int minBatch = 4096;
+    int tickMs = 16;
+    // 压测
+    int clients = 8;
+    double seconds = 5.0;
+    int requestSegments = 16;
+    int inflight = 1;    // 每个连接上同时在途的请求数 (流水线深度)
+    bool sendSegments = false; // 默认按下标查询，打开后发送线段本身
+    bool verify = false;
+};
+
+void usage(const char* argv0) {
+    std::printf("usage: %s --serve|--load [--socket PATH] [--slots N] [--seed N]\n"
+                "  serve: [--threads N] [--coalesce-us N] [--min-batch N] [--tick-ms N]\n"
+                "  load:  [--clients N] [--seconds S] [--request N] [--inflight N] [--segments] [--verify]\n",
+                argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", a.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--serve") {
+            opt.serve = true;
+        } else if (a == "--load") {
+            opt.load = true;
+        } else if (a == "--socket") {
+            opt.socketPath = next();
+        } else if (a == "--slots") {
+            opt.slots = std::max(1, std::atoi(next()));
+        } else if (a == "--seed") {
+            opt.seed = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--threads") {
+            opt.threads = (unsigned)std::atoi(next());
+        } else if (a == "--coalesce-us") {
+            opt.coalesceUs = std::max(0, std::atoi(next()));
+        } else if (a == "--min-batch") {
+            opt.minBatch = std::max(0, std::atoi(next()));
+        } else if (a == "--tick-ms") {
+            opt.tickMs = std::max(0, std::atoi(next()));
+        } else if (a == "--clients") {
+            opt.clients = std::max(1, std::atoi(next()));
+        } else if (a == "--seconds") {
+            opt.seconds = std::max(0.1, std::atof(next()));
+        } else if (a == "--request") {
+            opt.requestSegments = std::max(1, std::atoi(next()));
+        } else if (a == "--inflight") {
+            opt.inflight = std::max(1, std::atoi(next()));
+        } else if (a == "--segments") {
+            opt.sendSegments = true;
+        } else if (a == "--verify") {
+            opt.verify = true;
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (opt.serve == opt.load) {
+        usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+ShiftServer* gServer = nullptr;
+
+void onSignal(int) {
+    if (gServer) gServer->stop();
+}
+
+int serve(const Options& opt) {
+    ShiftServerConfig config;
+    config.socketPath = opt.socketPath;
+    config.threads = opt.threads;
+    config.coalesceUs = opt.coalesceUs;
+    config.minBatchSegments = (size_t)opt.minBatch;
+    config.tickMs = opt.tickMs;
+
+    ParkingLot lot = generateParkingLot(lotConfig(opt.slots, opt.seed));
+    const size_t segments = lot.segments.size(), polygons = lot.obstacles.polygonCount();
+    ShiftServer server;
+    if (!server.open(config, std::move(lot))) {
+        std::fprintf(stderr, "serve: %s\n", server.error().c_str());
+        return 1;
+    }
+    gServer = &server;
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    std::printf("serve: %s, %zu segments, %zu obstacles, tick %d ms, coalesce %d us / %d segments\n",
+                opt.socketPath.c_str(), segments, polygons, opt.tickMs, opt.coalesceUs, opt.minBatch);
+    std::fflush(stdout);
+
+    const bool ok = server.run();
+    gServer = nullptr;
+    const ShiftServerStats& s = server.stats();
+    std::printf("serve: %llu connections, %llu requests, %llu segments in %llu batches (%.1f requests / batch), "
+                "kernel %.3f s, %llu ticks, %llu read pauses\n",
+                (unsigned long long)s.connections, (unsigned long long)s.requests, (unsigned long long)s.segments,
+                (unsigned long long)s.batches, s.batches ? (double)s.requests / s.batches : 0.0, s.kernelSeconds,
+                (unsigned long long)s.ticks, (unsigned long long)s.readPauses);
+    if (!ok) {
+        std::fprintf(stderr, "serve: %s\n", server.error().c_str());
+        return 1;
+    }
+    return 0;
+}
+
+struct ClientResult {
+    std::vector<double> latencyUs;
+    uint64_t segments = 0;
+    uint64_t mismatches = 0;
+    uint64_t verified = 0;
+    std::string error;
+};
+
+// 单个压测连接：保持 inflight 个请求在途，收到一个应答就补发一个
+void runClient(const Options& opt, const ParkingLot& lot, const std::vector<double>& reference, int id,
+               Clock::time_point deadline, ClientResult& result) {
+    ShiftClient client;
+    if (!client.connect(opt.socketPath)) {
+        result.error = client.error();
+        return;
+    }
+    const size_t k = (size_t)opt.requestSegments;
+    const size_t depth = (size_t)opt.inflight;
+    std::mt19937 rng((uint32_t)(opt.seed * 7919 + (uint64_t)id));
+    std::uniform_int_distribution<uint32_t> pick(0, (uint32_t)lot.segments.size() - 1);
+
+    // 在途请求按顺序放在环里：下标、发送时刻
+    std::vector<uint32_t> indices(depth * k);
+    std::vector<Segment> segs(k);
+    std::vector<Clock::time_point> sentAt(depth);
+    std::vector<double> shifts(k);
+    uint64_t nextId = 0, doneId = 0;
+
+    auto sendOne = [&]() -> bool {
+        const size_t slot = (size_t)(nextId % depth);
+        uint32_t* idx = &indices[slot * k];
+        for (size_t i = 0; i < k; ++i) idx[i] = pick(rng);
+        sentAt[slot] = Clock::now();
+        bool ok;
+        if (opt.sendSegments) {
+            for (size_t i = 0; i < k; ++i) segs[i] = lot.segments[idx[i]];
+            ok = client.sendSegments(nextId, segs.data(), k);
+        } else {
+            ok = client.sendIndices(nextId, idx, k);
+        }
+        ++nextId;
+        return ok;
+    };
+
+    for (size_t i = 0; i < depth; ++i) {
+        if (!sendOne()) {
+            result.error = client.error();
+            return;
+        }
+    }
+    while (doneId < nextId) {
+        ShiftResponseHeader h;
+        if (!client.receive(h, shifts.data())) {
+            result.error = client.error();
+            return;
+        }
+        const Clock::time_point now = Clock::now();
+        const size_t slot = (size_t)(doneId % depth);
+        if (h.requestId != doneId || h.count != k) {
+            result.error = "out-of-order or short response " + std::to_string(h.requestId);
+            return;
+        }
+        result.latencyUs.push_back(std::chrono::duration<double, std::micro>(now - sentAt[slot]).count());
+        result.segments += k;
+        // 世界静止 (tick 0) 时结果应与本地内核逐位一致
+        if (!reference.empty() && h.worldTick == 0) {
+            const uint32_t* idx = &indices[slot * k];
+            for (size_t i = 0; i < k; ++i) result.mismatches += shifts[i] != reference[idx[i]];
+            ++result.verified;
+        }
+        ++doneId;
+        if (now < deadline && !sendOne()) {
+            result.error = client.error();
+            return;
+        }
+    }
+}
+
+int load(const Options& opt) {
+    const LotConfig cfg = lotConfig(opt.slots, opt.seed);
+    const ParkingLot lot = generateParkingLot(cfg);
+    std::vector<double> reference;
+    if (opt.verify) {
+        reference.resize(lot.segments.size());
+        calculateSegmentShiftBatch(lot.segments.data(), lot.segments.size(), lot.obstacles, cfg.margin,
+                                   cfg.detectionRange, reference.data());
+    }
+
+    std::vector<ClientResult> results((size_t)opt.clients);
+    std::vector<std::thread> workers;
+    const Clock::time_point start = Clock::now();
+    const Clock::time_point deadline = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(opt.seconds));
+    for (int c = 0; c < opt.clients; ++c) {
+        workers.emplace_back([&, c]() { runClient(opt, lot, reference, c, deadline, results[(size_t)c]); });
+    }
+    for (std::thread& t : workers) t.join();
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::vector<double> latency;
+    uint64_t segments = 0, mismatches = 0, verified = 0;
+    int failed = 0;
+    for (const ClientResult& r : results) {
+        latency.insert(latency.end(), r.latencyUs.begin(), r.latencyUs.end());
+        segments += r.segments;
+        mismatches += r.mismatches;
+        verified += r.verified;
+        if (!r.error.empty()) {
+            std::fprintf(stderr, "load: %s\n", r.error.c_str());
+            ++failed;
+        }
+    }
+    std::printf("load: %d clients x %d in flight, %d %s / request, %.2f s\n", opt.clients, opt.inflight,
+                opt.requestSegments, opt.sendSegments ? "segments" : "indices", wall);
+    std::printf("load: %zu requests (%.0f req/s), %llu segments (%.0f seg/s)\n", latency.size(), latency.size() / wall,
+                (unsigned long long)segments, segments / wall);
+    std::printf("load: latency us p50 %.1f p99 %.1f p99.9 %.1f max %.1f\n", percentile(latency, 0.5),
+                percentile(latency, 0.99), percentile(latency, 0.999), percentile(latency, 1.0));
+    if (opt.verify) {
+        std::printf("load: verify %llu mismatches over %llu requests at tick 0\n", (unsigned long long)mismatches,
+                    (unsigned long long)verified);
+    }
+    return (failed || mismatches) ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+    return opt.serve ? serve(opt) : load(opt);
+}
@@ -0,0 +1,244 @@
+#include "shift_async.h"
+
+#include <algorithm>
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+AsyncShiftResult failed(const std::string& message) {
+    AsyncShiftResult r;
+    r.error = message;
+    return r;
+}
+
+} // namespace
+
+AsyncShiftService::~AsyncShiftService() { stop(); }
+
+// --- 世界快照 ---
+
+void AsyncShiftService::setWorld(const AsyncWorld& world) {
+    std::lock_guard<std::mutex> lock(worldMutex_);
+    std::shared_ptr<Snapshot> next = std::make_shared<Snapshot>();
+    next->world = world;
+    next->version = world_ ? world_->version + 1 : 1;
+    world_ = next;
+}
+
+uint64_t AsyncShiftService::worldVersion() const {
+    std::lock_guard<std::mutex> lock(worldMutex_);
+    return world_ ? world_->version : 0;
+}
+
+std::shared_ptr<const AsyncShiftService::Snapshot> AsyncShiftService::snapshot() const {
+    std::lock_guard<std::mutex> lock(worldMutex_);
+    return world_;
+}
+
+// --- 提交 ---
+
+int AsyncShiftService::createQueue(const AsyncQueueConfig& config) {
+    std::unique_ptr<Queue> q(new Queue);
+    q->config = config;
+    q->config.maxBatchSegments = std::max<size_t>(1, config.maxBatchSegments);
+    Queue* raw = q.get();
+    std::lock_guard<std::mutex> lock(queuesMutex_);
+    queues_.push_back(std::move(q));
+    raw->thread = std::thread([this, raw]() { schedule(*raw); });
+    return (int)queues_.size() - 1;
+}
+
+std::future<AsyncShiftResult> AsyncShiftService::submit(int queue, std::vector<Segment> segments) {
+    Submission s;
+    s.segments = std::move(segments);
+    std::future<AsyncShiftResult> f = s.promise.get_future();
+    enqueue(queue, std::move(s));
+    return f;
+}
+
+std::future<AsyncShiftResult> AsyncShiftService::submitSlots(int queue, std::vector<uint32_t> indices) {
+    Submission s;
+    s.indices = std::move(indices);
+    s.bySlot = true;
+    std::future<AsyncShiftResult> f = s.promise.get_future();
+    enqueue(queue, std::move(s));
+    return f;
+}
+
+void AsyncShiftService::submit(int queue, std::vector<Segment> segments, AsyncShiftCallback done) {
+    Submission s;
+    s.segments = std::move(segments);
+    s.done = std::move(done);
+    enqueue(queue, std::move(s));
+}
+
+void AsyncShiftService::submitSlots(int queue, std::vector<uint32_t> indices, AsyncShiftCallback done) {
+    Submission s;
+    s.indices = std::move(indices);
+    s.bySlot = true;
+    s.done = std::move(done);
+    enqueue(queue, std::move(s));
+}
+
+void AsyncShiftService::enqueue(int queue, Submission&& s) {
+    Queue* q = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(queuesMutex_);
+        if (queue >= 0 && (size_t)queue < queues_.size()) q = queues_[(size_t)queue].get();
+    }
+    const char* rejected = q ? nullptr : "unknown queue";
+    if (q) {
+        const size_t n = s.bySlot ? s.indices.size() : s.segments.size();
+        std::unique_lock<std::mutex> lock(q->mutex);
+        if (q->stopping) {
+            rejected = "service stopped";
+        } else {
+            const bool wasEmpty = q->pending.empty();
+            if (wasEmpty) q->oldest = Clock::now();
+            q->pending.push_back(std::move(s));
+            q->pendingSegments += n;
+            // 只在队列由空变非空、或攒够一批时唤醒调度线程，窗口内的其余提交不打扰它
+            const bool wake = wasEmpty || q->pendingSegments >= q->config.maxBatchSegments;
+            lock.unlock();
+            if (wake) q->wake.notify_one();
+            return;
+        }
+    }
+    // 被拒绝的提交就地完成，调用方不会永远等下去
+    if (s.done) {
+        s.done(failed(rejected));
+    } else {
+        s.promise.set_value(failed(rejected));
+    }
+}
+
+// --- 调度 ---
+
+void AsyncShiftService::schedule(Queue& q) {
+    std::vector<Submission> batch;
+    std::unique_lock<std::mutex> lock(q.mutex);
+    for (;;) {
+        q.wake.wait(lock, [&q]() { return q.stopping || !q.pending.empty(); });
+        if (q.pending.empty()) return; // 已停止且排空
+
+        // 窗口从队首提交到达时算起；上一批剩下的提交早已过了窗口，会立即发车
+        const Clock::time_point deadline = q.oldest + std::chrono::microseconds(q.config.windowUs);
+        while (!q.stopping && q.pendingSegments < q.config.maxBatchSegments) {
+            if (q.wake.wait_until(lock, deadline) == std::cv_status::timeout) break;
+        }
+
+        // 至少取一个提交；单个提交超过上限时独自成批
+        batch.clear();
+        size_t segments = 0;
+        while (!q.pending.empty()) {
+            const Submission& front = q.pending.front();
+            const size_t n = front.bySlot ? front.indices.size() : front.segments.size();
+            if (!batch.empty() && segments + n > q.config.maxBatchSegments) break;
+            segments += n;
+            batch.push_back(std::move(q.pending.front()));
+            q.pending.pop_front();
+        }
+        q.pendingSegments -= segments;
+
+        lock.unlock();
+        runBatch(q, batch);
+        lock.lock();
+    }
+}
+
+void AsyncShiftService::runBatch(Queue& q, std::vector<Submission>& batch) {
+    const std::shared_ptr<const Snapshot> snap = snapshot();
+    const uint64_t batchId = nextBatch_.fetch_add(1, std::memory_order_relaxed);
+
+    // 拼批：按下标的提交在这里对照当前快照解析，越界的提交单独失败，不影响同批其他提交
+    std::vector<AsyncShiftResult> results(batch.size());
+    std::vector<size_t> first(batch.size(), 0);
+    q.batchSegments.clear();
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Submission& s = batch[i];
+        AsyncShiftResult& r = results[i];
+        if (!snap || !snap->world.obstacles) {
+            r.error = "no world has been set";
+            continue;
+        }
+        first[i] = q.batchSegments.size();
+        if (!s.bySlot) {
+            q.batchSegments.insert(q.batchSegments.end(), s.segments.begin(), s.segments.end());
+        } else {
+            const std::vector<Segment>* slots = snap->world.segments.get();
+            const size_t count = slots ? slots->size() : 0;
+            bool inRange = true;
+            for (uint32_t idx : s.indices) inRange = inRange && idx < count;
+            if (!inRange) {
+                r.error = "segment index out of range";
+                continue;
+            }
+            for (uint32_t idx : s.indices) q.batchSegments.push_back((*slots)[idx]);
+        }
+        r.ok = true;
+    }
+
+    const size_t n = q.batchSegments.size();
+    q.batchShifts.resize(n);
+    double seconds = 0.0;
+    if (n > 0) {
+        const AsyncWorld& w = snap->world;
+        const Clock::time_point t0 = Clock::now();
+        calculateSegmentShiftBatchParallel(q.batchSegments.data(), n, *w.obstacles, w.margin, w.detectionRange,
+                                           q.batchShifts.data(), q.config.threads);
+        seconds = std::chrono::duration<double>(Clock::now() - t0).count();
+    }
+    {
+        std::lock_guard<std::mutex> lock(q.mutex);
+        q.stats.submissions += batch.size();
+        q.stats.segments += n;
+        q.stats.batches += n > 0;
+        q.stats.kernelSeconds += seconds;
+    }
+
+    for (size_t i = 0; i < batch.size(); ++i) {
+        Submission& s = batch[i];
+        AsyncShiftResult& r = results[i];
+        r.batchId = batchId;
+        if (r.ok) {
+            const size_t count = s.bySlot ? s.indices.size() : s.segments.size();
+            r.shifts.assign(q.batchShifts.begin() + (std::ptrdiff_t)first[i],
+                            q.batchShifts.begin() + (std::ptrdiff_t)(first[i] + count));
+            r.worldVersion = snap->version;
+        }
+        if (s.done) {
+            s.done(std::move(r));
+        } else {
+            s.promise.set_value(std::move(r));
+        }
+    }
+    batch.clear();
+}
+
+AsyncQueueStats AsyncShiftService::stats(int queue) const {
+    std::lock_guard<std::mutex> lock(queuesMutex_);
+    if (queue < 0 || (size_t)queue >= queues_.size()) return AsyncQueueStats();
+    Queue& q = *queues_[(size_t)queue];
+    std::lock_guard<std::mutex> qlock(q.mutex);
+    return q.stats;
+}
+
+void AsyncShiftService::stop() {
+    // 队列只增不删，拿到指针后即可放开 queuesMutex_；回调里再提交或查询统计不会死锁
+    std::vector<Queue*> queues;
+    {
+        std::lock_guard<std::mutex> lock(queuesMutex_);
+        for (const std::unique_ptr<Queue>& q : queues_) queues.push_back(q.get());
+    }
+    for (Queue* q : queues) {
+        {
+            std::lock_guard<std::mutex> qlock(q->mutex);
+            q->stopping = true;
+        }
+        q->wake.notify_one();
+    }
+    for (Queue* q : queues) {
+        if (q->thread.joinable() && q->thread.get_id() != std::this_thread::get_id()) q->thread.join();
+    }
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "slot_shift.h"
+
+// --- 异步推移量查询 ---
+// 对延迟敏感的线程提交一批线段 (或车位线段下标) 后立即返回，拿到 future 或在完成时收到回调，
+// 不在自己的线程里跑内核。每个提交队列有一个调度线程：队列里第一个提交到达后最多等 windowUs 微秒，
+// 期间到达的提交合成一批，调用一次批量内核，再把结果拆回各自的 future / 回调。
+// 窗口与批量上限按队列配置：交互式查询用短窗口换延迟，后台查询用长窗口换吞吐。
+//
+// 世界 (障碍物与车位线段) 以不可变快照的形式交给服务，setWorld 只替换指针；
+// 已经开始计算的批量继续使用旧快照，结果里的 worldVersion 指明用的是哪一份。
+struct AsyncWorld {
+    std::shared_ptr<const ObstacleSet> obstacles;
+    std::shared_ptr<const std::vector<Segment>> segments; // 按下标提交时使用，可为空
+    double margin = 3.0;
+    double detectionRange = 10.0;
+};
+
+struct AsyncQueueConfig {
+    int windowUs = 200;              // 攒批窗口，0 表示来一个算一个 (仍会顺带合并已在排队的提交)
+    size_t maxBatchSegments = 16384; // 攒够这么多线段立即发车，不等窗口结束
+    unsigned threads = 1;            // 每批的内核线程数，0 表示硬件并发数
+};
+
+struct AsyncShiftResult {
+    bool ok = false;
+    std::string error;         // ok 为 false 时的原因 (下标越界、还没有世界、服务已停止)
+    std::vector<double> shifts;
+    uint64_t worldVersion = 0; // 计算所用世界快照的序号，setWorld 每次加 1
+    uint64_t batchId = 0;      // 同一批算出的结果 batchId 相同
+};
+
+// 回调在调度线程上执行，应尽快返回；耗时的处理请转交给自己的线程
+typedef std::function<void(AsyncShiftResult&&)> AsyncShiftCallback;
+
+struct AsyncQueueStats {
+    uint64_t submissions = 0;
+    uint64_t segments = 0;
+    uint64_t batches = 0;
+    double kernelSeconds = 0.0;
+};
+
+class AsyncShiftService {
+public:
+    AsyncShiftService() = default;
+    // 停止全部队列；已提交但尚未计算的请求仍会算完再返回
+    ~AsyncShiftService();
+    AsyncShiftService(const AsyncShiftService&) = delete;
+    AsyncShiftService& operator=(const AsyncShiftService&) = delete;
+
+    // 任意线程调用
+    void setWorld(const AsyncWorld& world);
+    uint64_t worldVersion() const;
+
+    // 新建提交队列并启动它的调度线程，返回队列编号
+    int createQueue(const AsyncQueueConfig& config);
+
+    std::future<AsyncShiftResult> submit(int queue, std::vector<Segment> segments);
+    std::future<AsyncShiftResult> submitSlots(int queue, std::vector<uint32_t> indices);
+    void submit(int queue, std::vector<Segment> segments, AsyncShiftCallback done);
+    void submitSlots(int queue, std::vector<uint32_t> indices, AsyncShiftCallback done);
+
+    AsyncQueueStats stats(int queue) const;
+    void stop();
+
+private:
+    struct Submission {
+        std::vector<Segment> segments;
+        std::vector<uint32_t> indices;
+        bool bySlot = false;
+        std::promise<AsyncShiftResult> promise;
+        AsyncShiftCallback done; // 为空时兑现 promise
+    };
+    struct Queue {
+        AsyncQueueConfig config;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::deque<Submission> pending;
+        size_t pendingSegments = 0;
+        std::chrono::steady_clock::time_point oldest; // 队首提交的到达时刻
+        bool stopping = false;
+        AsyncQueueStats stats;
+        std::thread thread;
+        // 调度线程独占的拼批缓冲，反复使用不再分配
+        std::vector<Segment> batchSegments;
+        std::vector<double> batchShifts;
+    };
+    struct Snapshot {
+        AsyncWorld world;
+        uint64_t version = 0;
+    };
+
+    void enqueue(int queue, Submission&& s);
+    void schedule(Queue& q);
+    void runBatch(Queue& q, std::vector<Submission>& batch);
+    std::shared_ptr<const Snapshot> snapshot() const;
+
+    mutable std::mutex worldMutex_;
+    std::shared_ptr<const Snapshot> world_;
+    mutable std::mutex queuesMutex_;
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::atomic<uint64_t> nextBatch_{1};
+};
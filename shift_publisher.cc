@@ -0,0 +1,81 @@
+#include "shift_publisher.h"
+
+#include <algorithm>
+
+ShiftPublisher::ShiftPublisher(size_t segmentCount, size_t buffers) : segmentCount_(segmentCount) {
+    buffers = std::max<size_t>(buffers, 2);
+    slots_.reserve(buffers);
+    for (size_t b = 0; b < buffers; ++b) {
+        std::unique_ptr<Slot> slot(new Slot);
+        slot->target.reset(new std::atomic<double>[segmentCount]);
+        slot->current.reset(new std::atomic<double>[segmentCount]);
+        for (size_t i = 0; i < segmentCount; ++i) {
+            slot->target[i].store(0.0, std::memory_order_relaxed);
+            slot->current[i].store(0.0, std::memory_order_relaxed);
+        }
+        slots_.push_back(std::move(slot));
+    }
+}
+
+void ShiftPublisher::publish(uint64_t frameIndex, uint64_t timestampNs, const double* target, const double* current) {
+    if (!current) current = target;
+    const uint64_t v = latest_.load(std::memory_order_relaxed) + 1;
+    Slot& s = *slots_[v % slots_.size()];
+
+    s.seq.store(2 * v - 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.frameIndex.store(frameIndex, std::memory_order_relaxed);
+    s.timestampNs.store(timestampNs, std::memory_order_relaxed);
+    for (size_t i = 0; i < segmentCount_; ++i) {
+        s.target[i].store(target[i], std::memory_order_relaxed);
+        s.current[i].store(current[i], std::memory_order_relaxed);
+    }
+    s.seq.store(2 * v, std::memory_order_release);
+    latest_.store(v, std::memory_order_release);
+}
+
+// 取最新序号对应的槽，拷贝后核对版本号没有变化；槽已被后来的发布覆盖时换成新的最新槽重来。
+// 拷贝直接写进调用方的缓冲，中途放弃会留下撕裂的数据，所以重读不设上限 (lock-free，不是 wait-free)
+template <typename CopyFn>
+bool ShiftPublisher::readConsistent(CopyFn copy, uint64_t* version) const {
+    for (;;) {
+        const uint64_t v = latest_.load(std::memory_order_acquire);
+        if (v == 0) return false;
+        const Slot& s = *slots_[v % slots_.size()];
+        const uint64_t before = s.seq.load(std::memory_order_acquire);
+        if (before == 2 * v) {
+            copy(s);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (s.seq.load(std::memory_order_relaxed) == before) {
+                if (version) *version = v;
+                return true;
+            }
+        }
+        retries_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+bool ShiftPublisher::readLatest(ShiftSnapshot& out) const {
+    out.target.resize(segmentCount_);
+    out.current.resize(segmentCount_);
+    return readConsistent(
+        [&](const Slot& s) {
+            out.frameIndex = s.frameIndex.load(std::memory_order_relaxed);
+            out.timestampNs = s.timestampNs.load(std::memory_order_relaxed);
+            for (size_t i = 0; i < segmentCount_; ++i) {
+                out.target[i] = s.target[i].load(std::memory_order_relaxed);
+                out.current[i] = s.current[i].load(std::memory_order_relaxed);
+            }
+        },
+        &out.version);
+}
+
+bool ShiftPublisher::readSegment(size_t segment, double& target, double& current, uint64_t* version) const {
+    if (segment >= segmentCount_) return false;
+    return readConsistent(
+        [&](const Slot& s) {
+            target = s.target[segment].load(std::memory_order_relaxed);
+            current = s.current[segment].load(std::memory_order_relaxed);
+        },
+        version);
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// --- 最新推移量的发布 ---
+// 规划、HMI、日志等消费者只关心每个车位线段最新的推移量，不需要逐帧排队。
+// 计算阶段 (唯一的写者) 每帧把完整的一组结果写进 buffers 个快照槽中的下一个，槽上带 seqlock 版本号；
+// 任意多个读者拷贝出最新一份完整快照，写者从不等待读者 (写是 wait-free 的)。
+// 读是 lock-free 而非 wait-free：读者只有在拷贝期间写者恰好绕回覆盖同一个槽时才重读，
+// buffers 个槽意味着一次拷贝期间要连续发布 buffers - 1 次才会发生；重读次数没有上限，
+// 写者发布得比读者拷贝一份快照还快时读者可能一直重读。读者拷贝慢 (线段多) 而写者频繁时加大 buffers。
+// 数据以 relaxed 原子读写，配合栅栏保证拷贝出的快照来自同一次发布 (不存在撕裂的半帧)。
+struct ShiftSnapshot {
+    uint64_t version = 0; // 第几次发布，从 1 开始
+    uint64_t frameIndex = 0;
+    uint64_t timestampNs = 0;
+    std::vector<double> target;  // 内核给出的目标推移量
+    std::vector<double> current; // 平滑后的当前推移量
+};
+
+class ShiftPublisher {
+public:
+    explicit ShiftPublisher(size_t segmentCount, size_t buffers = 4);
+    ShiftPublisher(const ShiftPublisher&) = delete;
+    ShiftPublisher& operator=(const ShiftPublisher&) = delete;
+
+    size_t segmentCount() const { return segmentCount_; }
+
+    // 仅写者线程调用；target / current 各 segmentCount 个，current 可为 nullptr (视为与 target 相同)
+    void publish(uint64_t frameIndex, uint64_t timestampNs, const double* target, const double* current);
+
+    // 任意线程调用，不加锁但可能重读 (见上)；还没有发布过时返回 false。out 的数组按需扩容，反复读取不再分配内存
+    bool readLatest(ShiftSnapshot& out) const;
+    // 只读单条线段，开销与线段总数无关
+    bool readSegment(size_t segment, double& target, double& current, uint64_t* version = nullptr) const;
+
+    uint64_t version() const { return latest_.load(std::memory_order_acquire); }
+    // 读者因槽被覆盖而重读的累计次数
+    uint64_t readRetries() const { return retries_.load(std::memory_order_relaxed); }
+
+private:
+    struct Slot {
+        std::atomic<uint64_t> seq{0}; // 奇数表示正在写；偶数 2v 表示存放第 v 次发布
+        std::atomic<uint64_t> frameIndex{0};
+        std::atomic<uint64_t> timestampNs{0};
+        std::unique_ptr<std::atomic<double>[]> target;
+        std::unique_ptr<std::atomic<double>[]> current;
+    };
+
+    template <typename CopyFn>
+    bool readConsistent(CopyFn copy, uint64_t* version) const;
+
+    size_t segmentCount_;
+    std::vector<std::unique_ptr<Slot>> slots_;
+    alignas(64) std::atomic<uint64_t> latest_{0}; // 最近一次完成的发布序号
+    alignas(64) mutable std::atomic<uint64_t> retries_{0};
+};
@@ -0,0 +1,476 @@
+#include "shift_service.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/timerfd.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+struct ShiftServer::Connection {
+    int fd = -1;
+    std::vector<unsigned char> in;
+    size_t inStart = 0; // in 里已解析掉的前缀
+    std::vector<unsigned char> out;
+    size_t outSent = 0;
+    bool writing = false;    // 是否已关注 EPOLLOUT
+    bool reading = true;     // 是否关注 EPOLLIN
+    bool closeAfterWrite = false; // 不再读取，已排队的请求答完、输出发完后关闭
+    size_t queued = 0;       // 在 pending_ 里等本批结果的请求数
+    bool dead = false;
+};
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+bool fillAddress(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    return true;
+}
+
+void armTimer(int fd, long long ns, bool periodic) {
+    itimerspec spec;
+    std::memset(&spec, 0, sizeof(spec));
+    spec.it_value.tv_sec = (time_t)(ns / 1000000000);
+    spec.it_value.tv_nsec = (long)(ns % 1000000000);
+    if (periodic) spec.it_interval = spec.it_value;
+    timerfd_settime(fd, 0, &spec, nullptr);
+}
+
+void drainCounter(int fd) {
+    uint64_t v;
+    while (read(fd, &v, sizeof(v)) == (ssize_t)sizeof(v)) {
+    }
+}
+
+// epoll 事件的 data.ptr：监听套接字、定时器等用固定的标记地址区分
+char kListenTag, kTickTag, kWakeTag, kCoalesceTag;
+
+} // namespace
+
+// --- 服务端 ---
+
+bool ShiftServer::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool ShiftServer::open(const ShiftServerConfig& config, ParkingLot world) {
+    close();
+    error_.clear();
+    config_ = config;
+    world_ = std::move(world);
+    stats_ = ShiftServerStats();
+    stopping_.store(false);
+
+    sockaddr_un addr;
+    if (!fillAddress(config_.socketPath, addr)) return fail("socket path too long: " + config_.socketPath);
+    listenFd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (listenFd_ < 0) return fail(std::string("socket: ") + std::strerror(errno));
+    unlink(config_.socketPath.c_str());
+    if (bind(listenFd_, (const sockaddr*)&addr, sizeof(addr)) != 0 || listen(listenFd_, 128) != 0) {
+        return fail("bind " + config_.socketPath + ": " + std::strerror(errno));
+    }
+
+    epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+    timerFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    coalesceFd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (epollFd_ < 0 || timerFd_ < 0 || wakeFd_ < 0 || coalesceFd_ < 0) {
+        return fail(std::string("epoll / timerfd / eventfd: ") + std::strerror(errno));
+    }
+    const std::pair<int, void*> watched[] = {
+        {listenFd_, &kListenTag}, {timerFd_, &kTickTag}, {wakeFd_, &kWakeTag}, {coalesceFd_, &kCoalesceTag}};
+    for (const auto& w : watched) {
+        epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.ptr = w.second;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, w.first, &ev) != 0) return fail(std::string("epoll_ctl: ") + std::strerror(errno));
+    }
+    if (config_.tickMs > 0) armTimer(timerFd_, (long long)config_.tickMs * 1000000, true);
+    return true;
+}
+
+void ShiftServer::stop() {
+    stopping_.store(true);
+    if (wakeFd_ >= 0) {
+        const uint64_t one = 1;
+        ssize_t ignored = write(wakeFd_, &one, sizeof(one));
+        (void)ignored;
+    }
+}
+
+bool ShiftServer::run() {
+    if (epollFd_ < 0) return fail("server is not open");
+    epoll_event events[64];
+    bool coalesceArmed = false;
+    while (!stopping_.load()) {
+        const int n = epoll_wait(epollFd_, events, 64, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return fail(std::string("epoll_wait: ") + std::strerror(errno));
+        }
+        bool flushNow = false;
+        for (int i = 0; i < n; ++i) {
+            void* tag = events[i].data.ptr;
+            if (tag == &kListenTag) {
+                accept();
+            } else if (tag == &kTickTag) {
+                uint64_t expirations = 0;
+                if (read(timerFd_, &expirations, sizeof(expirations)) == (ssize_t)sizeof(expirations)) {
+                    // 积压的节拍一次补上，行人轨迹与节拍数保持一致
+                    advancePedestrians(world_, config_.tickMs * 1e-3 * (double)expirations);
+                    stats_.ticks += expirations;
+                }
+            } else if (tag == &kWakeTag) {
+                drainCounter(wakeFd_);
+            } else if (tag == &kCoalesceTag) {
+                drainCounter(coalesceFd_);
+                coalesceArmed = false;
+                flushNow = true;
+            } else {
+                Connection* c = static_cast<Connection*>(tag);
+                if (c->dead) continue;
+                if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                    if (!(events[i].events & EPOLLIN)) {
+                        closeConnection(c);
+                        continue;
+                    }
+                }
+                if (events[i].events & EPOLLIN) {
+                    const bool open = readFrom(*c);
+                    parseRequests(*c);
+                    if (!open) {
+                        // 对端 shutdown(SHUT_WR) 或读出错：已收到的请求照常回答，发完再关
+                        c->closeAfterWrite = true;
+                        if (c->queued == 0 && c->outSent == c->out.size()) {
+                            closeConnection(c);
+                            continue;
+                        }
+                    }
+                    updateInterest(*c);
+                }
+                if (!c->dead && (events[i].events & EPOLLOUT)) {
+                    if (!writeTo(*c)) closeConnection(c);
+                }
+            }
+        }
+
+        if (!pending_.empty()) {
+            if (flushNow || config_.coalesceUs <= 0 || batchSegments_.size() >= config_.minBatchSegments) {
+                if (coalesceArmed) {
+                    armTimer(coalesceFd_, 0, false); // 0 表示解除
+                    coalesceArmed = false;
+                }
+                flush();
+            } else if (!coalesceArmed) {
+                armTimer(coalesceFd_, (long long)config_.coalesceUs * 1000, false);
+                coalesceArmed = true;
+            }
+        }
+
+        // 本轮关闭的连接此时已不再被 pending_ 引用
+        if (pending_.empty()) {
+            connections_.erase(std::remove_if(connections_.begin(), connections_.end(),
+                                              [](Connection* c) {
+                                                  if (!c->dead) return false;
+                                                  delete c;
+                                                  return true;
+                                              }),
+                               connections_.end());
+        }
+    }
+    return true;
+}
+
+void ShiftServer::accept() {
+    for (;;) {
+        const int fd = accept4(listenFd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN：没有更多连接
+        Connection* c = new Connection;
+        c->fd = fd;
+        epoll_event ev;
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.ptr = c;
+        if (epoll_ctl(epollFd_, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            ::close(fd);
+            delete c;
+            continue;
+        }
+        connections_.push_back(c);
+        ++stats_.connections;
+    }
+}
+
+// 读满积压上限就停，剩下的数据留在套接字里，等应答发走、请求解析掉之后再读
+bool ShiftServer::readFrom(Connection& c) {
+    while (acceptsInput(c)) {
+        const size_t used = c.in.size();
+        c.in.resize(used + 64 * 1024);
+        const ssize_t got = read(c.fd, c.in.data() + used, 64 * 1024);
+        if (got > 0) {
+            c.in.resize(used + (size_t)got);
+            continue;
+        }
+        c.in.resize(used);
+        if (got == 0) return false;
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+    }
+    return true;
+}
+
+bool ShiftServer::acceptsInput(const Connection& c) const {
+    if (c.closeAfterWrite || c.out.size() - c.outSent >= config_.maxBufferedBytes) return false;
+    const size_t unparsed = c.in.size() - c.inStart;
+    size_t limit = config_.maxBufferedBytes;
+    if (unparsed >= sizeof(ShiftRequestHeader)) {
+        // 下一个请求本身比上限还大 (但没超过 maxRequestSegments) 时放宽到能收全它
+        ShiftRequestHeader h;
+        std::memcpy(&h, c.in.data() + c.inStart, sizeof(h));
+        if (h.magic == kShiftRequestMagic && h.count <= config_.maxRequestSegments) {
+            limit = std::max(limit, sizeof(h) + (size_t)h.count * (h.type == kQuerySegments ? sizeof(Segment)
+                                                                                             : sizeof(uint32_t)));
+        }
+    }
+    return unparsed < limit;
+}
+
+void ShiftServer::parseRequests(Connection& c) {
+    while (!c.closeAfterWrite && c.in.size() - c.inStart >= sizeof(ShiftRequestHeader)) {
+        ShiftRequestHeader h;
+        std::memcpy(&h, c.in.data() + c.inStart, sizeof(h));
+        PendingQuery q;
+        q.conn = &c;
+        q.requestId = h.requestId;
+        q.first = batchSegments_.size();
+        q.count = 0;
+        q.status = kShiftOk;
+        if (h.magic != kShiftRequestMagic || (h.type != kQuerySegments && h.type != kQueryIndices)) {
+            q.status = kShiftBadRequest;
+        } else if (h.count > config_.maxRequestSegments) {
+            q.status = kShiftTooLarge;
+        }
+        if (q.status != kShiftOk) {
+            // 负载长度不可信，无法再对齐后续请求：回一个错误后关闭连接
+            c.closeAfterWrite = true;
+            pending_.push_back(q);
+            ++c.queued;
+            break;
+        }
+        const size_t payload = h.count * (h.type == kQuerySegments ? sizeof(Segment) : sizeof(uint32_t));
+        if (c.in.size() - c.inStart < sizeof(h) + payload) break; // 负载还没收全
+        const unsigned char* p = c.in.data() + c.inStart + sizeof(h);
+        if (h.type == kQuerySegments) {
+            const size_t at = batchSegments_.size();
+            batchSegments_.resize(at + h.count);
+            std::memcpy(batchSegments_.data() + at, p, payload);
+        } else {
+            for (uint32_t i = 0; i < h.count; ++i) {
+                uint32_t idx;
+                std::memcpy(&idx, p + i * sizeof(uint32_t), sizeof(idx));
+                if (idx >= world_.segments.size()) {
+                    q.status = kShiftBadRequest;
+                    break;
+                }
+                batchSegments_.push_back(world_.segments[idx]);
+            }
+            if (q.status != kShiftOk) batchSegments_.resize(q.first);
+        }
+        q.count = batchSegments_.size() - q.first;
+        pending_.push_back(q);
+        ++c.queued;
+        c.inStart += sizeof(h) + payload;
+        ++stats_.requests;
+    }
+    // 已解析的前缀过长时整体前移，避免缓冲无限增长
+    if (c.inStart > 0 && (c.inStart == c.in.size() || c.inStart > 1024 * 1024)) {
+        c.in.erase(c.in.begin(), c.in.begin() + (std::ptrdiff_t)c.inStart);
+        c.inStart = 0;
+    }
+}
+
+void ShiftServer::flush() {
+    const size_t n = batchSegments_.size();
+    batchShifts_.resize(n);
+    if (n > 0) {
+        const Clock::time_point t0 = Clock::now();
+        calculateSegmentShiftBatchParallel(batchSegments_.data(), n, world_.obstacles, world_.config.margin,
+                                           world_.config.detectionRange, batchShifts_.data(), config_.threads);
+        stats_.kernelSeconds += std::chrono::duration<double>(Clock::now() - t0).count();
+        ++stats_.batches;
+        stats_.segments += n;
+    }
+
+    for (const PendingQuery& q : pending_) {
+        Connection& c = *q.conn;
+        c.queued = 0;
+        if (c.dead) continue;
+        ShiftResponseHeader r;
+        r.magic = kShiftResponseMagic;
+        r.status = q.status;
+        r.requestId = q.requestId;
+        r.count = q.status == kShiftOk ? (uint32_t)q.count : 0;
+        r.reserved = 0;
+        r.worldTick = stats_.ticks;
+        const size_t at = c.out.size();
+        c.out.resize(at + sizeof(r) + r.count * sizeof(double));
+        std::memcpy(c.out.data() + at, &r, sizeof(r));
+        if (r.count) std::memcpy(c.out.data() + at + sizeof(r), batchShifts_.data() + q.first, r.count * sizeof(double));
+    }
+    for (const PendingQuery& q : pending_) {
+        Connection& c = *q.conn;
+        if (c.dead || c.out.size() == c.outSent) continue;
+        if (!writeTo(c)) closeConnection(&c);
+    }
+    pending_.clear();
+    batchSegments_.clear();
+}
+
+bool ShiftServer::writeTo(Connection& c) {
+    while (c.outSent < c.out.size()) {
+        const ssize_t sent = send(c.fd, c.out.data() + c.outSent, c.out.size() - c.outSent, MSG_NOSIGNAL);
+        if (sent > 0) {
+            c.outSent += (size_t)sent;
+            continue;
+        }
+        if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+        if (sent < 0 && errno == EINTR) continue;
+        return false;
+    }
+    if (c.outSent == c.out.size()) {
+        c.out.clear();
+        c.outSent = 0;
+        // 本批还有这个连接的请求没回答时先不关
+        if (c.closeAfterWrite && c.queued == 0) return false;
+    }
+    updateInterest(c);
+    return true;
+}
+
+void ShiftServer::updateInterest(Connection& c) {
+    const bool write = c.outSent < c.out.size();
+    // 水平触发：读到 EOF 或积压到上限后不再关注 EPOLLIN，否则每轮都会被唤醒
+    const bool read = acceptsInput(c);
+    if (write == c.writing && read == c.reading) return;
+    if (c.reading && !read && !c.closeAfterWrite) ++stats_.readPauses;
+    epoll_event ev;
+    ev.events = (read ? (uint32_t)(EPOLLIN | EPOLLRDHUP) : 0u) | (write ? (uint32_t)EPOLLOUT : 0u);
+    ev.data.ptr = &c;
+    epoll_ctl(epollFd_, EPOLL_CTL_MOD, c.fd, &ev);
+    c.writing = write;
+    c.reading = read;
+}
+
+void ShiftServer::closeConnection(Connection* c) {
+    if (c->dead) return;
+    epoll_ctl(epollFd_, EPOLL_CTL_DEL, c->fd, nullptr);
+    ::close(c->fd);
+    c->fd = -1;
+    c->dead = true; // 等本轮 pending_ 处理完再释放
+}
+
+void ShiftServer::close() {
+    for (Connection* c : connections_) {
+        if (!c->dead) ::close(c->fd);
+        delete c;
+    }
+    connections_.clear();
+    pending_.clear();
+    batchSegments_.clear();
+    const int fds[] = {epollFd_, timerFd_, wakeFd_, coalesceFd_};
+    for (int fd : fds) {
+        if (fd >= 0) ::close(fd);
+    }
+    epollFd_ = timerFd_ = wakeFd_ = coalesceFd_ = -1;
+    if (listenFd_ >= 0) {
+        ::close(listenFd_);
+        unlink(config_.socketPath.c_str());
+        listenFd_ = -1;
+    }
+}
+
+// --- 客户端 ---
+
+bool ShiftClient::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool ShiftClient::connect(const std::string& socketPath) {
+    close();
+    sockaddr_un addr;
+    if (!fillAddress(socketPath, addr)) return fail("socket path too long: " + socketPath);
+    fd_ = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) return fail(std::string("socket: ") + std::strerror(errno));
+    if (::connect(fd_, (const sockaddr*)&addr, sizeof(addr)) != 0) {
+        const int err = errno;
+        close();
+        return fail("connect " + socketPath + ": " + std::strerror(err));
+    }
+    return true;
+}
+
+bool ShiftClient::sendAll(const void* data, size_t bytes) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    while (bytes > 0) {
+        const ssize_t sent = send(fd_, p, bytes, MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) continue;
+            return fail(std::string("send: ") + std::strerror(errno));
+        }
+        p += sent;
+        bytes -= (size_t)sent;
+    }
+    return true;
+}
+
+bool ShiftClient::recvAll(void* data, size_t bytes) {
+    unsigned char* p = static_cast<unsigned char*>(data);
+    while (bytes > 0) {
+        const ssize_t got = recv(fd_, p, bytes, 0);
+        if (got == 0) return fail("server closed the connection");
+        if (got < 0) {
+            if (errno == EINTR) continue;
+            return fail(std::string("recv: ") + std::strerror(errno));
+        }
+        p += got;
+        bytes -= (size_t)got;
+    }
+    return true;
+}
+
+bool ShiftClient::sendSegments(uint64_t requestId, const Segment* segs, size_t n) {
+    if (fd_ < 0) return fail("not connected");
+    const ShiftRequestHeader h = {kShiftRequestMagic, kQuerySegments, requestId, (uint32_t)n, 0};
+    return sendAll(&h, sizeof(h)) && sendAll(segs, n * sizeof(Segment));
+}
+
+bool ShiftClient::sendIndices(uint64_t requestId, const uint32_t* indices, size_t n) {
+    if (fd_ < 0) return fail("not connected");
+    const ShiftRequestHeader h = {kShiftRequestMagic, kQueryIndices, requestId, (uint32_t)n, 0};
+    return sendAll(&h, sizeof(h)) && sendAll(indices, n * sizeof(uint32_t));
+}
+
+bool ShiftClient::receive(ShiftResponseHeader& header, double* out) {
+    if (fd_ < 0) return fail("not connected");
+    if (!recvAll(&header, sizeof(header))) return false;
+    if (header.magic != kShiftResponseMagic) return fail("bad response magic");
+    if (header.count && !recvAll(out, header.count * sizeof(double))) return false;
+    if (header.status != kShiftOk) return fail("server rejected request " + std::to_string(header.requestId) +
+                                               " with status " + std::to_string(header.status));
+    return true;
+}
+
+void ShiftClient::close() {
+    if (fd_ >= 0) ::close(fd_);
+    fd_ = -1;
+}
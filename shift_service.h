@@ -0,0 +1,158 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "parking_lot.h"
+
+// --- 本机推移量查询服务 (Unix 域套接字) ---
+// 守护进程持有停车场世界 (车位线段、障碍物 SoA 与包围盒)，多个进程通过同一个套接字查询推移量，
+// 不必各自链接一份逻辑、各自维护一份世界。
+//
+// 协议为定长头 + 负载的二进制帧，字段按本机字节序 (只在本机使用)：
+//   请求：ShiftRequestHeader，之后是 count 个 Segment (kQuerySegments) 或 count 个 uint32 车位线段下标 (kQueryIndices)
+//   应答：ShiftResponseHeader，之后是 count 个 double；status 非 0 时没有负载
+// 同一连接上可以连续发送多个请求 (流水线)，应答按请求顺序返回，requestId 原样带回。
+//
+// 服务端单线程 epoll：一轮事件里所有连接上读到的完整请求先攒成一批，再调用一次批量内核，
+// 结果按请求拆回各自的应答。批量很小时最多再等 coalesceUs 微秒攒更多请求，用一点延迟换吞吐。
+// 世界按 tickMs 的节拍 (timerfd) 推进行人，tickMs 为 0 时世界静止。
+enum : uint32_t {
+    kShiftRequestMagic = 0x59525153,  // "SQRY"
+    kShiftResponseMagic = 0x50535253, // "SRSP"
+};
+
+enum ShiftQueryType : uint32_t {
+    kQuerySegments = 1, // 负载为调用方给出的线段
+    kQueryIndices = 2,  // 负载为服务端车位线段的下标
+};
+
+enum ShiftStatus : uint32_t {
+    kShiftOk = 0,
+    kShiftBadRequest = 1,   // magic / type 不认识，或下标越界
+    kShiftTooLarge = 2,     // count 超过服务端上限
+};
+
+struct ShiftRequestHeader {
+    uint32_t magic;
+    uint32_t type;
+    uint64_t requestId;
+    uint32_t count;
+    uint32_t reserved;
+};
+
+struct ShiftResponseHeader {
+    uint32_t magic;
+    uint32_t status;
+    uint64_t requestId;
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t worldTick; // 计算时世界推进到的节拍数
+};
+
+static_assert(sizeof(ShiftRequestHeader) == 24 && sizeof(ShiftResponseHeader) == 32, "protocol headers must be packed");
+
+struct ShiftServerConfig {
+    std::string socketPath = "/tmp/slotshift.sock";
+    unsigned threads = 0;           // 批量内核线程数，0 表示硬件并发数
+    int coalesceUs = 200;           // 批量不足 minBatchSegments 时最多等待的微秒数，0 表示不等
+    size_t minBatchSegments = 4096;
+    size_t maxRequestSegments = 1 << 20;
+    // 每个连接积压的未发送应答或未解析请求达到这么多字节时暂停读取 (单个请求更大时至少收全它)，
+    // 只发不收的客户端因此只能占住有限的内存，直到它把应答读走
+    size_t maxBufferedBytes = 4 << 20;
+    int tickMs = 16;                // 行人推进节拍，0 表示世界静止
+};
+
+struct ShiftServerStats {
+    uint64_t connections = 0;
+    uint64_t requests = 0;
+    uint64_t segments = 0;
+    uint64_t batches = 0;   // 批量内核调用次数；requests / batches 即平均每批合并的请求数
+    uint64_t ticks = 0;
+    uint64_t readPauses = 0; // 因积压达到 maxBufferedBytes 暂停读取的次数
+    double kernelSeconds = 0.0;
+};
+
+class ShiftServer {
+public:
+    ShiftServer() = default;
+    ~ShiftServer() { close(); }
+    ShiftServer(const ShiftServer&) = delete;
+    ShiftServer& operator=(const ShiftServer&) = delete;
+
+    // 绑定套接字 (已存在的同名套接字文件会被替换)，接管 world
+    bool open(const ShiftServerConfig& config, ParkingLot world);
+    // 事件循环，直到 stop() 或出错
+    bool run();
+    // 任意线程 / 信号处理函数里调用均可
+    void stop();
+    void close();
+
+    const ShiftServerStats& stats() const { return stats_; }
+    const std::string& error() const { return error_; }
+
+private:
+    struct Connection;
+    struct PendingQuery {
+        Connection* conn;
+        uint64_t requestId;
+        size_t first; // 在本批线段里的起点
+        size_t count;
+        uint32_t status;
+    };
+
+    bool fail(const std::string& message);
+    void accept();
+    bool readFrom(Connection& c);
+    bool writeTo(Connection& c);
+    void parseRequests(Connection& c);
+    void flush();
+    void closeConnection(Connection* c);
+    void updateInterest(Connection& c);
+    bool acceptsInput(const Connection& c) const;
+
+    ShiftServerConfig config_;
+    ParkingLot world_;
+    int listenFd_ = -1;
+    int epollFd_ = -1;
+    int timerFd_ = -1;
+    int wakeFd_ = -1;     // eventfd，stop() 用来唤醒 epoll_wait
+    int coalesceFd_ = -1; // 攒批等待的单次 timerfd，微秒精度
+    std::atomic<bool> stopping_{false};
+    std::vector<Connection*> connections_;
+    std::vector<Segment> batchSegments_;
+    std::vector<double> batchShifts_;
+    std::vector<PendingQuery> pending_;
+    ShiftServerStats stats_;
+    std::string error_;
+};
+
+// 阻塞式客户端：一次一个请求，也可以先连续 send 再依次 receive (流水线)
+class ShiftClient {
+public:
+    ShiftClient() = default;
+    ~ShiftClient() { close(); }
+    ShiftClient(const ShiftClient&) = delete;
+    ShiftClient& operator=(const ShiftClient&) = delete;
+
+    bool connect(const std::string& socketPath);
+    bool sendSegments(uint64_t requestId, const Segment* segs, size_t n);
+    bool sendIndices(uint64_t requestId, const uint32_t* indices, size_t n);
+    // 收一个应答，推移量写进 out (至少能放下请求的 count 个)；status 非 0 时返回 false
+    bool receive(ShiftResponseHeader& header, double* out);
+    void close();
+
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+    bool sendAll(const void* data, size_t bytes);
+    bool recvAll(void* data, size_t bytes);
+
+    int fd_ = -1;
+    std::string error_;
+};
@@ -0,0 +1,50 @@
+#include "shift_variants.h"
+
+namespace {
+
+std::vector<ShiftVariant> makeVariants() {
+    std::vector<ShiftVariant> v;
+    v.push_back({"reference", 0.0, true, [](const ShiftProblem& p, double* out) {
+        std::vector<std::vector<Vec2>> restored;
+        if (!p.polygons) restored = obstaclePolygons(p.obstacles);
+        const std::vector<std::vector<Vec2>>& polygons = p.polygons ? *p.polygons : restored;
+        for (size_t i = 0; i < p.segmentCount; ++i)
+            out[i] = calculateSegmentShift(p.segments[i], polygons, p.margin, p.detectionRange);
+    }});
+    v.push_back({"soa_cull", 0.0, false, [](const ShiftProblem& p, double* out) {
+        for (size_t i = 0; i < p.segmentCount; ++i)
+            out[i] = calculateSegmentShiftSoA(p.segments[i], p.obstacles, p.margin, p.detectionRange);
+    }});
+    v.push_back({"batch", 0.0, false, [](const ShiftProblem& p, double* out) {
+        calculateSegmentShiftBatch(p.segments, p.segmentCount, p.obstacles, p.margin, p.detectionRange, out);
+    }});
+    v.push_back({"batch_mt", 0.0, false, [](const ShiftProblem& p, double* out) {
+        calculateSegmentShiftBatchParallel(p.segments, p.segmentCount, p.obstacles, p.margin, p.detectionRange, out,
+                                           p.threads);
+    }});
+    return v;
+}
+
+} // namespace
+
+const std::vector<ShiftVariant>& shiftVariants() {
+    static const std::vector<ShiftVariant> variants = makeVariants();
+    return variants;
+}
+
+const ShiftVariant* findShiftVariant(const std::string& name) {
+    for (const ShiftVariant& v : shiftVariants()) {
+        if (name == v.name) return &v;
+    }
+    return nullptr;
+}
+
+std::vector<std::vector<Vec2>> obstaclePolygons(const ObstacleView& obstacles) {
+    std::vector<std::vector<Vec2>> polys(obstacles.polygonCount());
+    for (size_t p = 0; p < polys.size(); ++p) {
+        uint32_t begin = obstacles.offsets[p], end = obstacles.offsets[p + 1];
+        polys[p].reserve(end - begin);
+        for (uint32_t i = begin; i < end; ++i) polys[p].push_back({obstacles.xs[i], obstacles.ys[i]});
+    }
+    return polys;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "slot_shift.h"
+
+// --- 内核变体注册表 ---
+// 基准测试、回放工具用同一份列表按名字挑选变体，新增优化变体只需在 shift_variants.cc 里登记。
+struct ShiftProblem {
+    const Segment* segments = nullptr;
+    size_t segmentCount = 0;
+    ObstacleView obstacles;
+    // 参考实现需要 AoS 形式；不提供时参考变体每次调用都从 obstacles 临时还原 (慢，见 ShiftVariant::needsPolygons)
+    const std::vector<std::vector<Vec2>>* polygons = nullptr;
+    double margin = 0.0;
+    double detectionRange = 0.0;
+    unsigned threads = 0; // 多线程变体的线程数，0 表示硬件并发数
+};
+
+struct ShiftVariant {
+    const char* name;
+    // 与参考实现允许的最大绝对误差；0 表示必须逐位一致
+    double tolerance;
+    bool needsPolygons;
+    std::function<void(const ShiftProblem&, double* out)> run;
+};
+
+// 第一个总是参考实现
+const std::vector<ShiftVariant>& shiftVariants();
+const ShiftVariant* findShiftVariant(const std::string& name);
+
+// 障碍物视图还原为每个多边形一个 std::vector<Vec2>，供参考实现使用
+std::vector<std::vector<Vec2>> obstaclePolygons(const ObstacleView& obstacles);
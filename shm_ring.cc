@@ -0,0 +1,384 @@
+#include "shm_ring.h"
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <thread>
+
+#include <fcntl.h>
+#include <linux/futex.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace {
+
+const char kShmMagic[8] = {'S', 'L', 'O', 'T', 'S', 'H', 'M', '\0'};
+const uint32_t kShmVersion = 1;
+const uint32_t kEndianTag = 0x01020304;
+
+// 共享内存里的原子量必须无锁，否则跨进程不成立；futex 直接作用在 32 位原子量的地址上
+static_assert(ATOMIC_LLONG_LOCK_FREE == 2 && ATOMIC_INT_LOCK_FREE == 2, "shared-memory atomics must be lock-free");
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be a plain 32-bit integer");
+
+struct alignas(64) ShmHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t endianTag;
+    uint32_t slotCount;
+    uint32_t lossless;
+    uint64_t slotBytes;
+    uint64_t maxPolygons;
+    uint64_t maxVertices;
+    // 槽内各数组相对槽起点的偏移
+    uint64_t offsetsAt, xsAt, ysAt, boundsAt;
+    std::atomic<uint32_t> ready; // 写者初始化完成后置 1
+
+    alignas(64) std::atomic<uint64_t> published; // 已发布的帧数
+    std::atomic<uint32_t> publishedWord;         // 每次发布递增，读者在上面 futex 等待
+    std::atomic<uint32_t> writerClosed;
+
+    alignas(64) std::atomic<uint64_t> consumed; // 读者已释放的帧数 (下一帧序号)
+    std::atomic<uint32_t> consumedWord;         // 每次释放递增，写者在上面 futex 等待
+};
+
+struct alignas(64) ShmSlotHeader {
+    std::atomic<uint64_t> seq; // 2k + 1：正在写第 k 帧；2k + 2：第 k 帧完整
+    uint64_t sourceFrame;
+    uint64_t timestampNs;
+    uint64_t polygons;
+    uint64_t vertices;
+};
+
+size_t alignUp(size_t v) { return (v + 63) & ~(size_t)63; }
+
+ShmHeader* header(unsigned char* base) { return reinterpret_cast<ShmHeader*>(base); }
+
+unsigned char* slotAt(unsigned char* base, uint64_t frame) {
+    const ShmHeader* h = header(base);
+    return base + sizeof(ShmHeader) + (frame % h->slotCount) * h->slotBytes;
+}
+
+ShmSlotHeader* slotHeader(unsigned char* slot) { return reinterpret_cast<ShmSlotHeader*>(slot); }
+
+long futexWait(std::atomic<uint32_t>& word, uint32_t expected, const timespec* timeout) {
+    return syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAIT, expected, timeout, nullptr, 0);
+}
+
+void futexWakeAll(std::atomic<uint32_t>& word) {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// 等到 ready() 成立；先读 futex 字再复查条件，对方在两者之间发布也不会漏掉唤醒
+template <typename Ready>
+bool waitOn(std::atomic<uint32_t>& word, Ready ready, int timeoutMs) {
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs < 0 ? 0 : timeoutMs);
+    for (;;) {
+        if (ready()) return true;
+        const uint32_t seen = word.load(std::memory_order_acquire);
+        if (ready()) return true;
+        if (timeoutMs < 0) {
+            futexWait(word, seen, nullptr);
+            continue;
+        }
+        const Clock::duration left = deadline - Clock::now();
+        if (left <= Clock::duration::zero()) return false;
+        const long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(left).count();
+        timespec ts;
+        ts.tv_sec = (time_t)(ns / 1000000000);
+        ts.tv_nsec = (long)(ns % 1000000000);
+        futexWait(word, seen, &ts);
+    }
+}
+
+uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+} // namespace
+
+// --- 写者 ---
+
+bool ShmObstacleWriter::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool ShmObstacleWriter::create(const std::string& name, const ShmRingConfig& config) {
+    close();
+    error_.clear();
+    if (config.slots < 2 || config.slots > UINT32_MAX) return fail("shared-memory ring needs at least 2 slots");
+    if (config.maxPolygons == 0 || config.maxVertices == 0 || config.maxVertices > UINT32_MAX)
+        return fail("shared-memory ring needs polygon and vertex capacities");
+
+    // 槽布局：槽头，offsets[maxPolygons + 1]，xs，ys，bounds，各块按 64 字节对齐
+    const size_t offsetsAt = alignUp(sizeof(ShmSlotHeader));
+    const size_t xsAt = alignUp(offsetsAt + (config.maxPolygons + 1) * sizeof(uint32_t));
+    const size_t ysAt = alignUp(xsAt + config.maxVertices * sizeof(double));
+    const size_t boundsAt = alignUp(ysAt + config.maxVertices * sizeof(double));
+    const size_t slotBytes = alignUp(boundsAt + config.maxPolygons * sizeof(Bounds));
+    const size_t bytes = sizeof(ShmHeader) + config.slots * slotBytes;
+
+    shm_unlink(name.c_str()); // 上次异常退出留下的同名区
+    const int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (fd < 0) return fail("shm_open " + name + ": " + std::strerror(errno));
+    if (ftruncate(fd, (off_t)bytes) != 0) {
+        const int err = errno;
+        ::close(fd);
+        shm_unlink(name.c_str());
+        return fail("ftruncate " + name + ": " + std::strerror(err));
+    }
+    void* p = mmap(nullptr, bytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    const int err = errno;
+    ::close(fd);
+    if (p == MAP_FAILED) {
+        shm_unlink(name.c_str());
+        return fail("mmap " + name + ": " + std::strerror(err));
+    }
+    base_ = static_cast<unsigned char*>(p);
+    bytes_ = bytes;
+    name_ = name;
+
+    ShmHeader* h = new (base_) ShmHeader;
+    std::memcpy(h->magic, kShmMagic, sizeof(kShmMagic));
+    h->version = kShmVersion;
+    h->endianTag = kEndianTag;
+    h->slotCount = (uint32_t)config.slots;
+    h->lossless = config.lossless ? 1 : 0;
+    h->slotBytes = slotBytes;
+    h->maxPolygons = config.maxPolygons;
+    h->maxVertices = config.maxVertices;
+    h->offsetsAt = offsetsAt;
+    h->xsAt = xsAt;
+    h->ysAt = ysAt;
+    h->boundsAt = boundsAt;
+    h->published.store(0, std::memory_order_relaxed);
+    h->publishedWord.store(0, std::memory_order_relaxed);
+    h->writerClosed.store(0, std::memory_order_relaxed);
+    h->consumed.store(0, std::memory_order_relaxed);
+    h->consumedWord.store(0, std::memory_order_relaxed);
+    for (size_t s = 0; s < config.slots; ++s) {
+        ShmSlotHeader* sh = new (base_ + sizeof(ShmHeader) + s * slotBytes) ShmSlotHeader;
+        sh->seq.store(0, std::memory_order_relaxed);
+    }
+    h->ready.store(1, std::memory_order_release);
+    return true;
+}
+
+bool ShmObstacleWriter::acquire(ShmWriteSlot& slot, int timeoutMs) {
+    if (!base_) return fail("shared-memory ring is not open");
+    if (acquired_) return fail("previous slot was acquired but not published");
+    ShmHeader* h = header(base_);
+    const uint64_t k = h->published.load(std::memory_order_relaxed);
+    if (h->lossless) {
+        // 无损：k 号槽里的旧帧 (k - slots) 必须已被读者释放
+        auto free = [&] { return k - h->consumed.load(std::memory_order_acquire) < h->slotCount; };
+        if (!free()) {
+            ++waits_;
+            if (!waitOn(h->consumedWord, free, timeoutMs)) return fail("timed out waiting for the reader to release a slot");
+        }
+    }
+
+    unsigned char* s = slotAt(base_, k);
+    slotHeader(s)->seq.store(2 * k + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    slot.frameIndex = k;
+    slot.offsets = reinterpret_cast<uint32_t*>(s + h->offsetsAt);
+    slot.xs = reinterpret_cast<double*>(s + h->xsAt);
+    slot.ys = reinterpret_cast<double*>(s + h->ysAt);
+    slot.bounds = reinterpret_cast<Bounds*>(s + h->boundsAt);
+    slot.maxPolygons = h->maxPolygons;
+    slot.maxVertices = h->maxVertices;
+    acquired_ = true;
+    return true;
+}
+
+bool ShmObstacleWriter::publish(const ShmWriteSlot& slot, size_t polygons, size_t vertices, uint64_t sourceFrame,
+                                uint64_t timestampNs) {
+    if (!base_) return fail("shared-memory ring is not open");
+    ShmHeader* h = header(base_);
+    const uint64_t k = h->published.load(std::memory_order_relaxed);
+    if (!acquired_ || slot.frameIndex != k) return fail("publish without a matching acquire");
+    if (polygons > h->maxPolygons || vertices > h->maxVertices) return fail("frame exceeds the ring capacity");
+
+    ShmSlotHeader* sh = slotHeader(slotAt(base_, k));
+    sh->sourceFrame = sourceFrame;
+    sh->timestampNs = timestampNs;
+    sh->polygons = polygons;
+    sh->vertices = vertices;
+    sh->seq.store(2 * k + 2, std::memory_order_release);
+    h->published.store(k + 1, std::memory_order_release);
+    h->publishedWord.fetch_add(1, std::memory_order_release);
+    futexWakeAll(h->publishedWord);
+    acquired_ = false;
+    return true;
+}
+
+bool ShmObstacleWriter::publish(const ObstacleView& obstacles, uint64_t sourceFrame, uint64_t timestampNs,
+                                int timeoutMs) {
+    if (base_ && (obstacles.polygonCount() > header(base_)->maxPolygons ||
+                  obstacles.vertexCount() > header(base_)->maxVertices))
+        return fail("frame exceeds the ring capacity");
+    ShmWriteSlot slot;
+    if (!acquire(slot, timeoutMs)) return false;
+    const size_t P = obstacles.polygonCount(), V = obstacles.vertexCount();
+    // 子视图的 offsets 可能不从 0 开始，写进槽时改成从 0 开始
+    const uint32_t first = P ? obstacles.offsets[0] : 0;
+    for (size_t p = 0; p <= P; ++p) slot.offsets[p] = P ? obstacles.offsets[p] - first : 0;
+    std::memcpy(slot.xs, obstacles.xs + first, V * sizeof(double));
+    std::memcpy(slot.ys, obstacles.ys + first, V * sizeof(double));
+    std::memcpy(slot.bounds, obstacles.bounds, P * sizeof(Bounds));
+    return publish(slot, P, V, sourceFrame, timestampNs ? timestampNs : nowNs());
+}
+
+uint64_t ShmObstacleWriter::published() const {
+    return base_ ? header(base_)->published.load(std::memory_order_acquire) : 0;
+}
+
+void ShmObstacleWriter::close() {
+    if (!base_) return;
+    ShmHeader* h = header(base_);
+    h->writerClosed.store(1, std::memory_order_release);
+    h->publishedWord.fetch_add(1, std::memory_order_release);
+    futexWakeAll(h->publishedWord);
+    munmap(base_, bytes_);
+    shm_unlink(name_.c_str());
+    base_ = nullptr;
+    bytes_ = 0;
+    acquired_ = false;
+}
+
+// --- 读者 ---
+
+bool ShmObstacleReader::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+bool ShmObstacleReader::open(const std::string& name, int timeoutMs) {
+    close();
+    error_.clear();
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point deadline = Clock::now() + std::chrono::milliseconds(timeoutMs);
+    // 写者可能还没启动或还没初始化完：按 1 ms 轮询，直到区域存在且 ready
+    for (;;) {
+        const int fd = shm_open(name.c_str(), O_RDWR, 0);
+        if (fd >= 0) {
+            struct stat st;
+            if (fstat(fd, &st) == 0 && (size_t)st.st_size >= sizeof(ShmHeader)) {
+                void* p = mmap(nullptr, (size_t)st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+                ::close(fd);
+                if (p == MAP_FAILED) return fail("mmap " + name + ": " + std::strerror(errno));
+                base_ = static_cast<unsigned char*>(p);
+                bytes_ = (size_t)st.st_size;
+                if (header(base_)->ready.load(std::memory_order_acquire)) break;
+                munmap(base_, bytes_);
+                base_ = nullptr;
+            } else {
+                ::close(fd);
+            }
+        } else if (errno != ENOENT) {
+            return fail("shm_open " + name + ": " + std::strerror(errno));
+        }
+        if (Clock::now() >= deadline) return fail("shared-memory ring " + name + " is not available");
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    const ShmHeader* h = header(base_);
+    if (std::memcmp(h->magic, kShmMagic, sizeof(kShmMagic)) != 0 || h->version != kShmVersion ||
+        h->endianTag != kEndianTag || h->slotCount < 2 ||
+        sizeof(ShmHeader) + (uint64_t)h->slotCount * h->slotBytes > bytes_) {
+        close();
+        return fail(name + " is not a compatible shared-memory obstacle ring");
+    }
+    // 从上一个读者释放到的位置接着读
+    nextFrame_ = h->consumed.load(std::memory_order_acquire);
+    return true;
+}
+
+bool ShmObstacleReader::next(ShmFrame& frame, int timeoutMs) {
+    if (!base_) return fail("shared-memory ring is not open");
+    ShmHeader* h = header(base_);
+    for (;;) {
+        auto available = [&] {
+            return h->published.load(std::memory_order_acquire) > nextFrame_ ||
+                   h->writerClosed.load(std::memory_order_acquire);
+        };
+        if (!available()) {
+            ++waits_;
+            if (!waitOn(h->publishedWord, available, timeoutMs)) return fail("timed out waiting for a frame");
+        }
+        const uint64_t published = h->published.load(std::memory_order_acquire);
+        if (published <= nextFrame_) {
+            closed_ = true;
+            return fail("writer closed the ring");
+        }
+        // 有损模式只取最新一帧
+        const uint64_t k = h->lossless ? nextFrame_ : published - 1;
+        dropped_ += k - nextFrame_;
+        nextFrame_ = k + 1;
+
+        unsigned char* s = slotAt(base_, k);
+        const ShmSlotHeader* sh = slotHeader(s);
+        if (sh->seq.load(std::memory_order_acquire) != 2 * k + 2) {
+            ++dropped_; // 已被更新的帧覆盖，再取一次
+            continue;
+        }
+        if (sh->polygons > h->maxPolygons || sh->vertices > h->maxVertices)
+            return fail("frame " + std::to_string(k) + " exceeds the ring capacity");
+        const uint32_t* offsets = reinterpret_cast<const uint32_t*>(s + h->offsetsAt);
+        // 内核按 offsets 下标访问坐标，必须保证单调且不越界
+        if (offsets[0] != 0 || offsets[sh->polygons] != sh->vertices)
+            return fail("frame " + std::to_string(k) + " has inconsistent polygon offsets");
+        for (uint64_t p = 0; p < sh->polygons; ++p) {
+            if (offsets[p + 1] < offsets[p]) return fail("frame " + std::to_string(k) + " has inconsistent polygon offsets");
+        }
+
+        frame.frameIndex = k;
+        frame.sourceFrame = sh->sourceFrame;
+        frame.timestampNs = sh->timestampNs;
+        frame.obstacles.xs = reinterpret_cast<const double*>(s + h->xsAt);
+        frame.obstacles.ys = reinterpret_cast<const double*>(s + h->ysAt);
+        frame.obstacles.offsets = offsets;
+        frame.obstacles.bounds = reinterpret_cast<const Bounds*>(s + h->boundsAt);
+        frame.obstacles.polygons = sh->polygons;
+        frame.obstacles.vertices = sh->vertices;
+        return true;
+    }
+}
+
+bool ShmObstacleReader::release(const ShmFrame& frame) {
+    if (!base_) return fail("shared-memory ring is not open");
+    ShmHeader* h = header(base_);
+    bool intact = true;
+    if (!h->lossless) {
+        std::atomic_thread_fence(std::memory_order_acquire);
+        intact = slotHeader(slotAt(base_, frame.frameIndex))->seq.load(std::memory_order_relaxed) ==
+                 2 * frame.frameIndex + 2;
+        if (!intact) ++dropped_;
+    }
+    h->consumed.store(frame.frameIndex + 1, std::memory_order_release);
+    h->consumedWord.fetch_add(1, std::memory_order_release);
+    futexWakeAll(h->consumedWord);
+    return intact;
+}
+
+bool ShmObstacleReader::lossless() const { return base_ && header(base_)->lossless; }
+size_t ShmObstacleReader::maxPolygons() const { return base_ ? header(base_)->maxPolygons : 0; }
+size_t ShmObstacleReader::maxVertices() const { return base_ ? header(base_)->maxVertices : 0; }
+
+void ShmObstacleReader::close() {
+    if (base_) munmap(base_, bytes_);
+    base_ = nullptr;
+    bytes_ = 0;
+    nextFrame_ = 0;
+    closed_ = false;
+}
@@ -0,0 +1,115 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "slot_shift.h"
+
+// --- 共享内存障碍物环 (感知进程 -> 车位更新进程) ---
+// 一块 POSIX 共享内存 (shm_open + mmap) 里放 slots 个定长帧槽，每个槽按容量上限预留
+// offsets / xs / ys / bounds 四个数组，布局与 ObstacleView 相同：写者在槽里原地填写，
+// 读者把槽直接当作 ObstacleView 交给内核，整个过程没有序列化和拷贝。
+//
+// 第 k 帧放在 k % slots 号槽，槽头的 seq 为 2k + 1 表示正在写、2k + 2 表示第 k 帧已完整。
+// 写者发布后递增 published 并用 futex 唤醒读者；读者处理完一帧后递增 consumed 并唤醒写者。
+// futex 字放在共享内存里且不带 FUTEX_PRIVATE_FLAG，因此跨进程有效。
+//   - 无损模式 (默认)：环满时写者等待读者释放，读者按顺序拿到每一帧。
+//   - 有损模式：写者从不等待，读者每次只取最新一帧并跳过其余 (计入 dropped)；
+//     读者计算期间槽若被覆盖，release() 返回 false，调用方丢弃这一帧的结果。
+// 单写者、单读者。失败时返回 false，原因见 error()。
+struct ShmRingConfig {
+    size_t slots = 4;
+    size_t maxPolygons = 0;
+    size_t maxVertices = 0;
+    bool lossless = true;
+};
+
+// 写者拿到的可写槽：数组容量为配置中的上限
+struct ShmWriteSlot {
+    uint64_t frameIndex = 0; // 该槽将要发布的帧序号 (环内连续编号，从 0 开始)
+    uint32_t* offsets = nullptr;
+    double* xs = nullptr;
+    double* ys = nullptr;
+    Bounds* bounds = nullptr;
+    size_t maxPolygons = 0;
+    size_t maxVertices = 0;
+};
+
+// 读者拿到的帧：obstacles 直接指向共享内存
+struct ShmFrame {
+    uint64_t frameIndex = 0;  // 环内帧序号
+    uint64_t sourceFrame = 0; // 写者给的帧号 (例如感知帧号)
+    uint64_t timestampNs = 0; // 写者给的时间戳 (steady_clock，同一台机器上跨进程可比)
+    ObstacleView obstacles;
+};
+
+class ShmObstacleWriter {
+public:
+    ShmObstacleWriter() = default;
+    ~ShmObstacleWriter() { close(); }
+    ShmObstacleWriter(const ShmObstacleWriter&) = delete;
+    ShmObstacleWriter& operator=(const ShmObstacleWriter&) = delete;
+
+    // 创建 (已存在则重建) 名为 name 的共享内存区，name 形如 "/slotshift"
+    bool create(const std::string& name, const ShmRingConfig& config);
+    // 取下一个可写槽；无损模式下环满时最多等 timeoutMs (负数表示一直等)
+    bool acquire(ShmWriteSlot& slot, int timeoutMs = -1);
+    // 发布 acquire 得到的槽，polygons / vertices 为实际填写的数量
+    bool publish(const ShmWriteSlot& slot, size_t polygons, size_t vertices, uint64_t sourceFrame, uint64_t timestampNs);
+    // acquire + 拷入 + publish，给已经有 ObstacleSet 的写者用
+    bool publish(const ObstacleView& obstacles, uint64_t sourceFrame, uint64_t timestampNs, int timeoutMs = -1);
+    // 通知读者写者已退出，并删除共享内存名字 (已映射的读者不受影响)
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+    uint64_t published() const;
+    uint64_t waits() const { return waits_; } // 因环满而等待的次数
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+
+    std::string name_;
+    unsigned char* base_ = nullptr;
+    size_t bytes_ = 0;
+    bool acquired_ = false;
+    uint64_t waits_ = 0;
+    std::string error_;
+};
+
+class ShmObstacleReader {
+public:
+    ShmObstacleReader() = default;
+    ~ShmObstacleReader() { close(); }
+    ShmObstacleReader(const ShmObstacleReader&) = delete;
+    ShmObstacleReader& operator=(const ShmObstacleReader&) = delete;
+
+    // 打开写者创建的共享内存区；还不存在时最多等 timeoutMs
+    bool open(const std::string& name, int timeoutMs = 0);
+    // 取下一帧；超时或写者已关闭且没有剩余帧时返回 false (closed() 区分两者)
+    bool next(ShmFrame& frame, int timeoutMs = -1);
+    // 处理完 frame 后调用，槽交还写者；返回 false 表示计算期间槽被覆盖 (仅有损模式)
+    bool release(const ShmFrame& frame);
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+    bool closed() const { return closed_; }
+    bool lossless() const;
+    size_t maxPolygons() const;
+    size_t maxVertices() const;
+    uint64_t dropped() const { return dropped_; } // 有损模式下跳过或被覆盖的帧
+    uint64_t waits() const { return waits_; }     // 因没有新帧而等待的次数
+    const std::string& error() const { return error_; }
+
+private:
+    bool fail(const std::string& message);
+
+    unsigned char* base_ = nullptr;
+    size_t bytes_ = 0;
+    uint64_t nextFrame_ = 0;
+    bool closed_ = false;
+    uint64_t dropped_ = 0;
+    uint64_t waits_ = 0;
+    std::string error_;
+};
@@ -0,0 +1,237 @@
+// shm_slotshift：共享内存障碍物环的替身写者与读者。
+// --produce 扮演感知进程，用停车场生成器逐帧写入障碍物；--consume 扮演车位更新进程，直接在共享内存上跑批量内核。
+// 写者默认像感知进程那样 acquire 一个槽、把多边形直接写进槽里的数组再 publish；--copy 改用从 ObstacleSet 整体拷入的 publish。
+// --both 在一个命令里 fork 出写者，方便本机自测。
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "parking_lot.h"
+#include "shm_ring.h"
+#include "tool_stats.h"
+
+namespace {
+
+typedef std::chrono::steady_clock Clock;
+
+struct Options {
+    std::string name = "/slotshift";
+    bool produce = false;
+    bool consume = false;
+    int frames = 600;
+    double fps = 60.0; // 写者节拍，0 表示不限速
+    int slots = 2000;  // 停车场规模 (车位数)
+    uint64_t seed = 1;
+    int ring = 4;
+    bool lossy = false;
+    unsigned threads = 0;
+    int timeoutMs = 5000;
+    bool verify = false;
+    bool copy = false;
+};
+
+uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+}
+
+void usage(const char* argv0) {
+    std::printf("usage: %s --produce|--consume|--both [--name /shm-name] [--frames N] [--fps F] [--slots N] [--seed N]\n"
+                "                     [--ring N] [--lossy] [--threads N] [--timeout MS] [--verify] [--copy]\n",
+                argv0);
+}
+
+bool parseArgs(int argc, char** argv, Options& opt) {
+    for (int i = 1; i < argc; ++i) {
+        std::string a = argv[i];
+        auto next = [&]() -> const char* {
+            if (i + 1 >= argc) {
+                std::fprintf(stderr, "%s needs a value\n", a.c_str());
+                std::exit(2);
+            }
+            return argv[++i];
+        };
+        if (a == "--produce") {
+            opt.produce = true;
+        } else if (a == "--consume") {
+            opt.consume = true;
+        } else if (a == "--both") {
+            opt.produce = opt.consume = true;
+        } else if (a == "--name") {
+            opt.name = next();
+        } else if (a == "--frames") {
+            opt.frames = std::max(1, std::atoi(next()));
+        } else if (a == "--fps") {
+            opt.fps = std::max(0.0, std::atof(next()));
+        } else if (a == "--slots") {
+            opt.slots = std::max(1, std::atoi(next()));
+        } else if (a == "--seed") {
+            opt.seed = std::strtoull(next(), nullptr, 10);
+        } else if (a == "--ring") {
+            opt.ring = std::max(2, std::atoi(next()));
+        } else if (a == "--lossy") {
+            opt.lossy = true;
+        } else if (a == "--threads") {
+            opt.threads = (unsigned)std::atoi(next());
+        } else if (a == "--timeout") {
+            opt.timeoutMs = std::atoi(next());
+        } else if (a == "--verify") {
+            opt.verify = true;
+        } else if (a == "--copy") {
+            opt.copy = true;
+        } else {
+            usage(argv[0]);
+            return false;
+        }
+    }
+    if (!opt.produce && !opt.consume) {
+        usage(argv[0]);
+        return false;
+    }
+    return true;
+}
+
+double frameDt(const Options& opt) { return 1.0 / (opt.fps > 0.0 ? opt.fps : 60.0); }
+
+// 原地写一帧：多边形顶点直接写进槽里的数组，包围盒在槽里就地计算，不经过中间的 ObstacleSet
+bool publishInPlace(ShmObstacleWriter& writer, const std::vector<std::vector<Vec2>>& polygons, uint64_t sourceFrame,
+                    int timeoutMs) {
+    size_t vertices = 0;
+    for (const std::vector<Vec2>& poly : polygons) vertices += poly.size();
+    ShmWriteSlot slot;
+    if (!writer.acquire(slot, timeoutMs)) return false;
+    // 超出容量时不写槽，交给 publish 报错
+    if (polygons.size() > slot.maxPolygons || vertices > slot.maxVertices) {
+        return writer.publish(slot, polygons.size(), vertices, sourceFrame, nowNs());
+    }
+    size_t v = 0;
+    slot.offsets[0] = 0;
+    for (size_t p = 0; p < polygons.size(); ++p) {
+        for (const Vec2& q : polygons[p]) {
+            slot.xs[v] = q.x;
+            slot.ys[v] = q.y;
+            ++v;
+        }
+        slot.offsets[p + 1] = (uint32_t)v;
+    }
+    computePolygonBounds(slot.xs, slot.ys, slot.offsets, polygons.size(), slot.bounds);
+    return writer.publish(slot, polygons.size(), vertices, sourceFrame, nowNs());
+}
+
+int produce(const Options& opt) {
+    const LotConfig cfg = lotConfig(opt.slots, opt.seed);
+    ParkingLot lot = generateParkingLot(cfg);
+    ShmRingConfig ring;
+    ring.slots = (size_t)opt.ring;
+    ring.maxPolygons = lot.obstacles.polygonCount();
+    ring.maxVertices = lot.obstacles.vertexCount();
+    ring.lossless = !opt.lossy;
+    ShmObstacleWriter writer;
+    if (!writer.create(opt.name, ring)) {
+        std::fprintf(stderr, "%s\n", writer.error().c_str());
+        return 1;
+    }
+
+    const double dt = frameDt(opt);
+    const Clock::time_point start = Clock::now();
+    for (int f = 0; f < opt.frames; ++f) {
+        if (opt.fps > 0.0) {
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(f * dt)));
+        }
+        const bool ok = opt.copy ? writer.publish(lot.obstacles, (uint64_t)f, nowNs(), opt.timeoutMs)
+                                 : publishInPlace(writer, lot.allWorld, (uint64_t)f, opt.timeoutMs);
+        if (!ok) {
+            std::fprintf(stderr, "producer: %s (frame %d)\n", writer.error().c_str(), f);
+            return 1;
+        }
+        advancePedestrians(lot, dt);
+    }
+    std::printf("producer: published %llu frames %s (%zu polygons, %zu vertices each), waited on a full ring %llu times\n",
+                (unsigned long long)writer.published(), opt.copy ? "by copy" : "in place", lot.obstacles.polygonCount(),
+                lot.obstacles.vertexCount(),
+                (unsigned long long)writer.waits());
+    // 只删掉名字并标记关闭，已映射的读者照样取完剩下的帧
+    writer.close();
+    return 0;
+}
+
+int consume(const Options& opt) {
+    const LotConfig cfg = lotConfig(opt.slots, opt.seed);
+    ParkingLot lot = generateParkingLot(cfg); // 车位线段归读者所有；--verify 时同步推进本地行人做比对
+    const size_t n = lot.segments.size();
+    std::vector<double> shifts(n), expected(n);
+
+    ShmObstacleReader reader;
+    if (!reader.open(opt.name, opt.timeoutMs)) {
+        std::fprintf(stderr, "consumer: %s\n", reader.error().c_str());
+        return 1;
+    }
+    if (opt.verify && !reader.lossless()) {
+        std::fprintf(stderr, "consumer: --verify needs a lossless ring\n");
+        return 1;
+    }
+
+    std::vector<double> latencyMs, computeMs;
+    uint64_t frames = 0, torn = 0, mismatches = 0, localFrame = 0;
+    ShmFrame frame;
+    const Clock::time_point start = Clock::now();
+    while ((int)frames < opt.frames && reader.next(frame, opt.timeoutMs)) {
+        const Clock::time_point t0 = Clock::now();
+        calculateSegmentShiftBatchParallel(lot.segments.data(), n, frame.obstacles, cfg.margin, cfg.detectionRange,
+                                           shifts.data(), opt.threads);
+        const Clock::time_point t1 = Clock::now();
+        const bool intact = reader.release(frame);
+        if (!intact) {
+            ++torn;
+            continue;
+        }
+        computeMs.push_back(std::chrono::duration<double, std::milli>(t1 - t0).count());
+        latencyMs.push_back((double)(nowNs() - frame.timestampNs) * 1e-6);
+        ++frames;
+
+        if (opt.verify) {
+            for (; localFrame < frame.sourceFrame; ++localFrame) advancePedestrians(lot, frameDt(opt));
+            calculateSegmentShiftBatch(lot.segments.data(), n, lot.obstacles, cfg.margin, cfg.detectionRange,
+                                       expected.data());
+            for (size_t i = 0; i < n; ++i) mismatches += shifts[i] != expected[i];
+        }
+    }
+    if ((int)frames < opt.frames && !reader.closed()) {
+        std::fprintf(stderr, "consumer: %s\n", reader.error().c_str());
+    }
+    const double wall = std::chrono::duration<double>(Clock::now() - start).count();
+    std::printf("consumer: %llu frames x %zu segments in %.3f s, dropped %llu, torn %llu, waited %llu times\n",
+                (unsigned long long)frames, n, wall, (unsigned long long)reader.dropped(), (unsigned long long)torn,
+                (unsigned long long)reader.waits());
+    std::printf("consumer: compute ms p50 %.3f p99 %.3f | publish->result ms p50 %.3f p99 %.3f max %.3f\n",
+                percentile(computeMs, 0.5), percentile(computeMs, 0.99), percentile(latencyMs, 0.5),
+                percentile(latencyMs, 0.99), percentile(latencyMs, 1.0));
+    if (opt.verify) std::printf("consumer: verify %llu mismatches\n", (unsigned long long)mismatches);
+    return mismatches ? 1 : 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options opt;
+    if (!parseArgs(argc, argv, opt)) return 2;
+    if (opt.produce && opt.consume) {
+        const pid_t child = fork();
+        if (child < 0) {
+            std::perror("fork");
+            return 1;
+        }
+        if (child == 0) std::exit(produce(opt));
+        const int rc = consume(opt);
+        int status = 0;
+        waitpid(child, &status, 0);
+        return rc ? rc : (WIFEXITED(status) ? WEXITSTATUS(status) : 1);
+    }
+    return opt.produce ? produce(opt) : consume(opt);
+}
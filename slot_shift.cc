@@ -0,0 +1,327 @@
+#include "slot_shift.h"
+
+#include <algorithm>
+#include <system_error>
+#include <thread>
+
+#include "trace.h"
+
+// --- SoA 障碍物集合 ---
+void ObstacleSet::clear() {
+    xs.clear();
+    ys.clear();
+    offsets.assign(1, 0);
+    bounds.clear();
+}
+
+void ObstacleSet::addPolygon(const std::vector<Vec2>& poly) {
+    Bounds b = {HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+    for (const auto& v : poly) {
+        xs.push_back(v.x);
+        ys.push_back(v.y);
+        b.minX = std::min(b.minX, v.x);
+        b.minY = std::min(b.minY, v.y);
+        b.maxX = std::max(b.maxX, v.x);
+        b.maxY = std::max(b.maxY, v.y);
+    }
+    offsets.push_back((uint32_t)xs.size());
+    bounds.push_back(b);
+}
+
+void computePolygonBounds(const double* xs, const double* ys, const uint32_t* offsets, size_t polygons, Bounds* out) {
+    for (size_t p = 0; p < polygons; ++p) {
+        Bounds b = {HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+        for (uint32_t i = offsets[p]; i < offsets[p + 1]; ++i) {
+            b.minX = std::min(b.minX, xs[i]);
+            b.minY = std::min(b.minY, ys[i]);
+            b.maxX = std::max(b.maxX, xs[i]);
+            b.maxY = std::max(b.maxY, ys[i]);
+        }
+        out[p] = b;
+    }
+}
+
+void ObstacleSet::computeBounds() {
+    const size_t polyCount = offsets.size() - 1;
+    bounds.resize(polyCount);
+    computePolygonBounds(xs.data(), ys.data(), offsets.data(), polyCount, bounds.data());
+}
+
+ObstacleSet buildObstacleSet(const std::vector<std::vector<Vec2>>& allPolys) {
+    ObstacleSet set;
+    size_t total = 0;
+    for (const auto& poly : allPolys) total += poly.size();
+    set.xs.reserve(total);
+    set.ys.reserve(total);
+    set.offsets.reserve(allPolys.size() + 1);
+    set.bounds.reserve(allPolys.size());
+    for (const auto& poly : allPolys) set.addPolygon(poly);
+    return set;
+}
+
+// --- 内核统计 ---
+void ShiftStats::merge(const ShiftStats& other) {
+    polygonsVisited += other.polygonsVisited;
+    polygonsCulled += other.polygonsCulled;
+    verticesTested += other.verticesTested;
+    verticesInWindow += other.verticesInWindow;
+    bandHits += other.bandHits;
+    if (other.maxPolygon >= 0 && (maxPolygon < 0 || other.maxShift > maxShift)) {
+        maxShift = other.maxShift;
+        maxSegment = other.maxSegment;
+        maxPolygon = other.maxPolygon;
+        maxVertex = other.maxVertex;
+    }
+}
+
+namespace {
+
+constexpr bool kStatsCompiled = SLOTSHIFT_ENABLE_STATS != 0;
+
+// 单次调用的最大值来源写回 stats，规则与 ShiftStats::merge 相同
+inline void recordMax(ShiftStats* stats, double maxShift, int64_t poly, int64_t vertex) {
+    if (poly >= 0 && (stats->maxPolygon < 0 || maxShift > stats->maxShift)) {
+        stats->maxShift = maxShift;
+        stats->maxPolygon = poly;
+        stats->maxVertex = vertex;
+    }
+}
+
+// --- 核心判定逻辑：带探测范围限制 ---
+// kStats 为 false 时所有计数语句在编译期消失
+template <bool kStats>
+double shiftReference(const Segment& seg, const std::vector<std::vector<Vec2>>& allPolys, double margin,
+                      double detectionRange, ShiftStats* stats) {
+    double maxShift = 0.0;
+    Vec2 dir = seg.getDir();
+    double segLen = seg.length();
+    int64_t maxP = -1, maxV = -1;
+
+    for (size_t p = 0; p < allPolys.size(); ++p) {
+        const auto& poly = allPolys[p];
+        if (kStats) {
+            ++stats->polygonsVisited;
+            stats->verticesTested += poly.size();
+        }
+        for (size_t i = 0; i < poly.size(); ++i) {
+            Vec2 vToStart = poly[i] - seg.start;
+            double projLen = vToStart.dot(dir);
+
+            // 1. 纵向范围判定（是否在线段长度内）
+            if (projLen >= 0 && projLen <= segLen) {
+                if (kStats) ++stats->verticesInWindow;
+                // 2. 横向投影距离（相对于理想位置）
+                double dist = vToStart.dot(seg.heading);
+
+                // 3. 有效范围过滤：
+                // 只有当障碍物顶点在 [理想位置] 到 [理想位置 + detectionRange] 之间时才考虑
+                // 我们允许 dist 稍微小于 0 (比如 -10)，以确保平滑处理已经在背后的物体
+                if (dist < detectionRange && dist > -margin) {
+                    if (kStats) ++stats->bandHits;
+                    double currentPush = dist + margin;
+                    if (currentPush > maxShift) {
+                        maxShift = currentPush;
+                        if (kStats) {
+                            maxP = (int64_t)p;
+                            maxV = (int64_t)i;
+                        }
+                    }
+                }
+            }
+        }
+    }
+    if (kStats) recordMax(stats, maxShift, maxP, maxV);
+    return maxShift;
+}
+
+// 线段在内核里反复用到的量，批量调用时每条线段只算一次
+struct SegmentFrame {
+    double sx, sy;   // 起点
+    double dx, dy;   // 单位方向
+    double hx, hy;   // 推离方向
+    double segLen;
+};
+
+SegmentFrame makeFrame(const Segment& seg) {
+    Vec2 dir = seg.getDir();
+    return {seg.start.x, seg.start.y, dir.x, dir.y, seg.heading.x, seg.heading.y, seg.length()};
+}
+
+// (v - start)·axis 在包围盒上的最大 / 最小值。
+// 逐轴取极值再相加，浮点运算的单调性保证盒内任意顶点的投影都不会超出这个区间，
+// 因此剔除永远不会丢掉参考实现会接受的顶点。
+inline double projMax(double minV, double maxV, double s, double a) {
+    return (a >= 0 ? maxV - s : minV - s) * a;
+}
+inline double projMin(double minV, double maxV, double s, double a) {
+    return (a >= 0 ? minV - s : maxV - s) * a;
+}
+
+inline bool boundsOutsideBand(const Bounds& b, const SegmentFrame& f, double margin, double detectionRange) {
+    double projHi = projMax(b.minX, b.maxX, f.sx, f.dx) + projMax(b.minY, b.maxY, f.sy, f.dy);
+    double projLo = projMin(b.minX, b.maxX, f.sx, f.dx) + projMin(b.minY, b.maxY, f.sy, f.dy);
+    if (projHi < 0 || projLo > f.segLen) return true;
+    double distHi = projMax(b.minX, b.maxX, f.sx, f.hx) + projMax(b.minY, b.maxY, f.sy, f.hy);
+    double distLo = projMin(b.minX, b.maxX, f.sx, f.hx) + projMin(b.minY, b.maxY, f.sy, f.hy);
+    return distHi <= -margin || distLo >= detectionRange;
+}
+
+// 计数先累加在局部变量里，调用结束时一次性写回，避免内层循环写内存
+template <bool kStats>
+double shiftSoA(const SegmentFrame& f, const ObstacleView& obstacles, double margin, double detectionRange,
+                ShiftStats* stats) {
+    double maxShift = 0.0;
+    const double* xs = obstacles.xs;
+    const double* ys = obstacles.ys;
+    const size_t polyCount = obstacles.polygonCount();
+    uint64_t culled = 0, tested = 0, inWindow = 0, hits = 0;
+    int64_t maxP = -1, maxV = -1;
+
+    for (size_t p = 0; p < polyCount; ++p) {
+        if (boundsOutsideBand(obstacles.bounds[p], f, margin, detectionRange)) {
+            if (kStats) ++culled;
+            continue;
+        }
+
+        const uint32_t begin = obstacles.offsets[p];
+        const uint32_t end = obstacles.offsets[p + 1];
+        if (kStats) tested += end - begin;
+        for (uint32_t i = begin; i < end; ++i) {
+            // 与参考实现保持相同的运算顺序，保证结果逐位一致
+            double px = xs[i] - f.sx;
+            double py = ys[i] - f.sy;
+            double projLen = px * f.dx + py * f.dy;
+            double dist = px * f.hx + py * f.hy;
+            bool window = projLen >= 0 && projLen <= f.segLen;
+            bool hit = window && dist < detectionRange && dist > -margin;
+            double push = hit ? dist + margin : 0.0;
+            if (kStats) {
+                inWindow += window;
+                hits += hit;
+                if (push > maxShift) {
+                    maxP = (int64_t)p;
+                    maxV = (int64_t)(i - begin);
+                }
+            }
+            maxShift = push > maxShift ? push : maxShift;
+        }
+    }
+    if (kStats) {
+        stats->polygonsVisited += polyCount;
+        stats->polygonsCulled += culled;
+        stats->verticesTested += tested;
+        stats->verticesInWindow += inWindow;
+        stats->bandHits += hits;
+        recordMax(stats, maxShift, maxP, maxV);
+    }
+    return maxShift;
+}
+
+template <bool kStats>
+void shiftBatch(const Segment* segs, size_t n, size_t firstIndex, const ObstacleView& obstacles, double margin,
+                double detectionRange, double* out, ShiftStats* stats) {
+    for (size_t i = 0; i < n; ++i) {
+        if (kStats) {
+            ShiftStats one;
+            out[i] = shiftSoA<true>(makeFrame(segs[i]), obstacles, margin, detectionRange, &one);
+            one.maxSegment = (int64_t)(firstIndex + i);
+            stats->merge(one);
+        } else {
+            out[i] = shiftSoA<false>(makeFrame(segs[i]), obstacles, margin, detectionRange, nullptr);
+        }
+    }
+}
+
+// 每个线程独占的计数，前后留出一整条缓存行，避免伪共享
+struct PaddedStats {
+    char padBefore[64];
+    ShiftStats stats;
+    char padAfter[64];
+};
+
+template <bool kStats>
+void shiftBatchParallel(const Segment* segs, size_t n, const ObstacleView& obstacles, double margin,
+                        double detectionRange, double* out, unsigned threads, ShiftStats* stats) {
+    if (threads == 0) threads = std::max(1u, std::thread::hardware_concurrency());
+    // 每个线程至少分到这么多条线段，否则建线程的开销比计算本身还大
+    const size_t kMinSegmentsPerThread = 16;
+    threads = (unsigned)std::min<size_t>(threads, std::max<size_t>(1, n / kMinSegmentsPerThread));
+    if (threads <= 1) {
+        shiftBatch<kStats>(segs, n, 0, obstacles, margin, detectionRange, out, stats);
+        return;
+    }
+
+    std::vector<PaddedStats> local(kStats ? threads : 0);
+    const size_t chunk = (n + threads - 1) / threads;
+    auto runChunk = [&](unsigned t) {
+        SLOTSHIFT_TRACE_SCOPE("shift_batch_worker");
+        const size_t begin = std::min(n, t * chunk);
+        const size_t count = std::min(n, begin + chunk) - begin;
+        shiftBatch<kStats>(segs + begin, count, begin, obstacles, margin, detectionRange, out + begin,
+                           kStats ? &local[t].stats : nullptr);
+    };
+    std::vector<std::thread> workers;
+    workers.reserve(threads - 1);
+    unsigned started = 1;
+    try {
+        for (; started < threads; ++started) workers.emplace_back([&runChunk, started] { runChunk(started); });
+    } catch (const std::system_error&) {
+        // 线程建不出来 (资源耗尽) 时不向外抛：已启动的线程照常 join，剩下的块在调用线程上算完，结果不变
+    }
+    runChunk(0);
+    for (unsigned t = started; t < threads; ++t) runChunk(t);
+    for (auto& w : workers) w.join();
+    // 按线段顺序合并，最大值来源与单线程结果相同
+    if (kStats) {
+        for (const PaddedStats& l : local) stats->merge(l.stats);
+    }
+}
+
+} // namespace
+
+double calculateSegmentShift(const Segment& seg, const std::vector<std::vector<Vec2>>& allPolys, double margin, double detectionRange) {
+    SLOTSHIFT_TRACE_SCOPE("shift_reference");
+    return shiftReference<false>(seg, allPolys, margin, detectionRange, nullptr);
+}
+
+double calculateSegmentShift(const Segment& seg, const std::vector<std::vector<Vec2>>& allPolys, double margin, double detectionRange,
+                             ShiftStats& stats) {
+    SLOTSHIFT_TRACE_SCOPE("shift_reference");
+    return shiftReference<kStatsCompiled>(seg, allPolys, margin, detectionRange, &stats);
+}
+
+double calculateSegmentShiftSoA(const Segment& seg, const ObstacleView& obstacles, double margin, double detectionRange) {
+    SLOTSHIFT_TRACE_SCOPE("shift_soa");
+    return shiftSoA<false>(makeFrame(seg), obstacles, margin, detectionRange, nullptr);
+}
+
+double calculateSegmentShiftSoA(const Segment& seg, const ObstacleView& obstacles, double margin, double detectionRange,
+                                ShiftStats& stats) {
+    SLOTSHIFT_TRACE_SCOPE("shift_soa");
+    return shiftSoA<kStatsCompiled>(makeFrame(seg), obstacles, margin, detectionRange, &stats);
+}
+
+void calculateSegmentShiftBatch(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                double margin, double detectionRange, double* out) {
+    SLOTSHIFT_TRACE_SCOPE("shift_batch");
+    shiftBatch<false>(segs, n, 0, obstacles, margin, detectionRange, out, nullptr);
+}
+
+void calculateSegmentShiftBatch(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                double margin, double detectionRange, double* out, ShiftStats& stats) {
+    SLOTSHIFT_TRACE_SCOPE("shift_batch");
+    shiftBatch<kStatsCompiled>(segs, n, 0, obstacles, margin, detectionRange, out, &stats);
+}
+
+void calculateSegmentShiftBatchParallel(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                        double margin, double detectionRange, double* out, unsigned threads) {
+    SLOTSHIFT_TRACE_SCOPE("shift_batch_parallel");
+    shiftBatchParallel<false>(segs, n, obstacles, margin, detectionRange, out, threads, nullptr);
+}
+
+void calculateSegmentShiftBatchParallel(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                        double margin, double detectionRange, double* out, unsigned threads,
+                                        ShiftStats& stats) {
+    SLOTSHIFT_TRACE_SCOPE("shift_batch_parallel");
+    shiftBatchParallel<kStatsCompiled>(segs, n, obstacles, margin, detectionRange, out, threads, &stats);
+}
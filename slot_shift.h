@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// --- 基础数学结构 ---
+struct Vec2 {
+    double x, y;
+    Vec2 operator+(const Vec2& b) const { return {x + b.x, y + b.y}; }
+    Vec2 operator-(const Vec2& b) const { return {x - b.x, y - b.y}; }
+    Vec2 operator*(double s) const { return {x * s, y * s}; }
+    double dot(const Vec2& b) const { return x * b.x + y * b.y; }
+};
+
+struct Segment {
+    Vec2 start;
+    Vec2 end;
+    Vec2 heading; // 推离方向 (Normal)
+
+    Vec2 getDir() const {
+        Vec2 d = end - start;
+        double len = std::sqrt(d.x * d.x + d.y * d.y);
+        return (len > 1e-6) ? Vec2{d.x / len, d.y / len} : Vec2{0, 0};
+    }
+    double length() const {
+        Vec2 d = end - start;
+        return std::sqrt(d.x * d.x + d.y * d.y);
+    }
+};
+
+// --- SoA 障碍物集合 ---
+// 所有多边形的顶点坐标按 x / y 分开连续存放，offsets[i]..offsets[i+1] 为第 i 个多边形，
+// bounds[i] 为其轴对齐包围盒，供内核按多边形整体剔除。
+struct Bounds {
+    double minX, minY, maxX, maxY;
+};
+
+struct ObstacleSet {
+    std::vector<double> xs;
+    std::vector<double> ys;
+    std::vector<uint32_t> offsets{0};
+    std::vector<Bounds> bounds;
+
+    size_t polygonCount() const { return bounds.size(); }
+    size_t vertexCount() const { return xs.size(); }
+
+    void clear();
+    void addPolygon(const std::vector<Vec2>& poly);
+    // 按 xs / ys / offsets 重新计算全部包围盒 (直接改写坐标或从文件读入之后调用)
+    void computeBounds();
+};
+
+ObstacleSet buildObstacleSet(const std::vector<std::vector<Vec2>>& allPolys);
+
+// 按 offsets 计算 polygons 个多边形的包围盒写进 out (空多边形得到 min = +inf, max = -inf，永远被剔除)
+void computePolygonBounds(const double* xs, const double* ys, const uint32_t* offsets, size_t polygons, Bounds* out);
+
+// 不持有内存的障碍物视图，内核只通过它读取障碍物。
+// 可以指向 ObstacleSet (隐式转换)，也可以直接指向 mmap 进来的录制文件 (见 recording.h)，
+// 后者无需任何拷贝或反序列化。
+struct ObstacleView {
+    const double* xs = nullptr;
+    const double* ys = nullptr;
+    const uint32_t* offsets = nullptr; // polygons + 1 个
+    const Bounds* bounds = nullptr;
+    size_t polygons = 0;
+    size_t vertices = 0;
+
+    ObstacleView() = default;
+    ObstacleView(const ObstacleSet& set)
+        : xs(set.xs.data()), ys(set.ys.data()), offsets(set.offsets.data()), bounds(set.bounds.data()),
+          polygons(set.polygonCount()), vertices(set.vertexCount()) {}
+
+    size_t polygonCount() const { return polygons; }
+    size_t vertexCount() const { return vertices; }
+
+    // 第 [first, first + count) 个多边形组成的子视图。offsets 仍是整个坐标数组里的绝对下标，xs / ys 不用移动
+    ObstacleView slice(size_t first, size_t count) const {
+        ObstacleView v = *this;
+        v.offsets = offsets + first;
+        v.bounds = bounds + first;
+        v.polygons = count;
+        v.vertices = offsets[first + count] - offsets[first];
+        return v;
+    }
+};
+
+// --- 内核统计 ---
+// 只有传入 ShiftStats 的重载才会计数，不传的版本是另一份模板实例，不含任何计数代码。
+// 以 -DSLOTSHIFT_ENABLE_STATS=0 编译时带 stats 的重载也退化为不计数的版本 (stats 保持不变)。
+#ifndef SLOTSHIFT_ENABLE_STATS
+#define SLOTSHIFT_ENABLE_STATS 1
+#endif
+
+struct ShiftStats {
+    uint64_t polygonsVisited = 0;  // 参与包围盒判定的多边形 (参考实现不剔除，等于全部多边形)
+    uint64_t polygonsCulled = 0;   // 被包围盒整体剔除的多边形
+    uint64_t verticesTested = 0;   // 逐顶点判定过的顶点
+    uint64_t verticesInWindow = 0; // 投影落在 [0, segLen] 纵向窗口内的顶点
+    uint64_t bandHits = 0;         // 纵向窗口内且横向在 (-margin, detectionRange) 内，即参与取最大值的顶点
+
+    // 产生最大推移量的位置；多处并列时取最先遇到的，与参考实现的 '>' 比较一致
+    double maxShift = 0.0;
+    int64_t maxSegment = -1; // 批量接口中的线段下标，单条线段接口不填
+    int64_t maxPolygon = -1;
+    int64_t maxVertex = -1;  // 多边形内的顶点下标
+
+    void reset() { *this = ShiftStats(); }
+    // 累加计数，other 的最大值严格更大时才替换最大值来源
+    void merge(const ShiftStats& other);
+};
+
+// --- 核心判定逻辑：带探测范围限制 ---
+// 参考实现：逐顶点扫描所有多边形，其余变体的结果必须与它一致。
+double calculateSegmentShift(const Segment& seg, const std::vector<std::vector<Vec2>>& allPolys, double margin, double detectionRange);
+double calculateSegmentShift(const Segment& seg, const std::vector<std::vector<Vec2>>& allPolys, double margin, double detectionRange,
+                             ShiftStats& stats);
+
+// SoA 变体：先用包围盒剔除整块不可能落入探测带的多边形，再对剩余顶点做无分支扫描。
+double calculateSegmentShiftSoA(const Segment& seg, const ObstacleView& obstacles, double margin, double detectionRange);
+// 同上，并把本次调用的统计累加进 stats
+double calculateSegmentShiftSoA(const Segment& seg, const ObstacleView& obstacles, double margin, double detectionRange,
+                                ShiftStats& stats);
+
+// 批量变体：对 n 条线段各自计算推移量，结果写入 out[0..n)。
+void calculateSegmentShiftBatch(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                double margin, double detectionRange, double* out);
+void calculateSegmentShiftBatch(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                double margin, double detectionRange, double* out, ShiftStats& stats);
+
+// 多线程批量变体：按线段切块分给 threads 个线程 (0 表示取硬件并发数)，批量太小时退化为单线程。
+// 创建线程失败时不抛异常：已启动的线程照常 join，剩下的块在调用线程上算完。
+// 带 stats 的版本每个线程写自己独占缓存行的计数，结束后按线段顺序合并，结果与单线程一致。
+void calculateSegmentShiftBatchParallel(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                        double margin, double detectionRange, double* out, unsigned threads = 0);
+void calculateSegmentShiftBatchParallel(const Segment* segs, size_t n, const ObstacleView& obstacles,
+                                        double margin, double detectionRange, double* out, unsigned threads,
+                                        ShiftStats& stats);
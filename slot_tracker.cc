@@ -0,0 +1,417 @@
+#include "slot_tracker.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 单个对象最多覆盖的网格数，超过时不进网格 (通常意味着坐标异常或网格太细)
+const int64_t kMaxCellsPerEntry = 4096;
+
+inline bool overlaps(const Bounds& a, const Bounds& b) {
+    return !(a.maxX < b.minX || b.maxX < a.minX || a.maxY < b.minY || b.maxY < a.minY);
+}
+
+inline bool finiteBounds(const Bounds& b) {
+    return std::isfinite(b.minX) && std::isfinite(b.minY) && std::isfinite(b.maxX) && std::isfinite(b.maxY);
+}
+
+inline uint64_t cellKey(int64_t x, int64_t y) { return (uint64_t)(uint32_t)x << 32 | (uint32_t)y; }
+
+} // namespace
+
+bool SlotTracker::fail(const std::string& message) {
+    error_ = message;
+    return false;
+}
+
+// --- 探测带索引 ---
+
+bool SlotTracker::reset(const std::vector<Segment>& segments, const SlotTrackerConfig& config) {
+    error_.clear();
+    if (!(config.smoothing > 0.0 && config.smoothing <= 1.0)) return fail("smoothing must be in (0, 1]");
+    if (!(config.settleEpsilon >= 0.0)) return fail("settleEpsilon must be non-negative");
+    if (!(config.cellSize >= 0.0) || !std::isfinite(config.cellSize)) return fail("cellSize must be finite and >= 0");
+    config_ = config;
+    segments_ = segments;
+    const size_t n = segments_.size();
+    const double m = config_.margin, R = config_.detectionRange;
+
+    // 探测带是 {v : 0 <= (v - s)·dir <= segLen, -margin < (v - s)·heading < detectionRange}。
+    // dir 与 heading 线性无关时它是平行四边形，四个角由 2x2 方程组解出，再外扩浮点误差余量
+    bands_.assign(n, Band());
+    unindexedBands_.clear();
+    std::vector<double> extents;
+    for (size_t i = 0; i < n; ++i) {
+        const Segment& s = segments_[i];
+        Band& band = bands_[i];
+        if (!(R > -m)) {
+            band.empty = true;
+            continue;
+        }
+        const Vec2 d = s.getDir(), h = s.heading;
+        const double L = s.length();
+        const double det = d.x * h.y - d.y * h.x;
+        const double hNorm = std::sqrt(h.x * h.x + h.y * h.y);
+        Bounds box = {HUGE_VAL, HUGE_VAL, -HUGE_VAL, -HUGE_VAL};
+        if (std::isfinite(det) && std::fabs(det) > 1e-3 * hNorm) {
+            for (double p : {0.0, L}) {
+                for (double w : {-m, R}) {
+                    const double x = s.start.x + (p * h.y - w * d.y) / det;
+                    const double y = s.start.y + (w * d.x - p * h.x) / det;
+                    box.minX = std::min(box.minX, x);
+                    box.minY = std::min(box.minY, y);
+                    box.maxX = std::max(box.maxX, x);
+                    box.maxY = std::max(box.maxY, y);
+                }
+            }
+            const double scale = std::fabs(s.start.x) + std::fabs(s.start.y) + L + std::fabs(m) + std::fabs(R);
+            const double pad = (1e-9 * scale + 1e-12) * (1.0 + hNorm) / std::fabs(det);
+            box = {box.minX - pad, box.minY - pad, box.maxX + pad, box.maxY + pad};
+        }
+        band.box = box;
+        band.indexed = finiteBounds(box);
+        if (band.indexed) extents.push_back(std::max(box.maxX - box.minX, box.maxY - box.minY));
+    }
+
+    cellSize_ = config_.cellSize;
+    if (cellSize_ <= 0.0) {
+        cellSize_ = 1.0;
+        if (!extents.empty()) {
+            std::nth_element(extents.begin(), extents.begin() + extents.size() / 2, extents.end());
+            cellSize_ = std::max(extents[extents.size() / 2], 1e-9);
+        }
+    }
+
+    bandGrid_.clear();
+    for (size_t i = 0; i < n; ++i) {
+        Band& band = bands_[i];
+        if (band.empty) continue;
+        int64_t x0, y0, x1, y1;
+        if (band.indexed && !gridRange(band.box, x0, y0, x1, y1)) band.indexed = false;
+        if (band.indexed) {
+            gridInsert(bandGrid_, band.box, (uint32_t)i);
+        } else {
+            unindexedBands_.push_back((uint32_t)i);
+        }
+    }
+
+    obstacles_.clear();
+    freeObstacles_.clear();
+    byId_.clear();
+    unindexedObstacles_.clear();
+    obstacleGrid_.clear();
+    obstacleStamp_.clear();
+    stamp_ = 0;
+
+    targets_.assign(n, 0.0);
+    currents_.assign(n, 0.0);
+    contributions_.assign(n, std::vector<Contribution>());
+    dirty_.clear();
+    isDirty_.assign(n, 0);
+    needsRescan_.assign(n, 0);
+    touched_.clear();
+    active_.clear();
+    isActive_.assign(n, 0);
+    changed_.clear();
+    pendingStats_ = SlotTrackerStats();
+    lastStats_ = SlotTrackerStats();
+    return true;
+}
+
+bool SlotTracker::gridRange(const Bounds& b, int64_t& x0, int64_t& y0, int64_t& x1, int64_t& y1) const {
+    if (!finiteBounds(b)) return false;
+    const double lim = 1e15; // 再大 floor 结果转 int64 会失去意义
+    const double fx0 = std::floor(b.minX / cellSize_), fy0 = std::floor(b.minY / cellSize_);
+    const double fx1 = std::floor(b.maxX / cellSize_), fy1 = std::floor(b.maxY / cellSize_);
+    if (!(std::fabs(fx0) < lim && std::fabs(fy0) < lim && std::fabs(fx1) < lim && std::fabs(fy1) < lim)) return false;
+    x0 = (int64_t)fx0;
+    y0 = (int64_t)fy0;
+    x1 = (int64_t)fx1;
+    y1 = (int64_t)fy1;
+    // 先逐轴判断，避免乘积溢出
+    const int64_t w = x1 - x0 + 1, h = y1 - y0 + 1;
+    return w <= kMaxCellsPerEntry && h <= kMaxCellsPerEntry && w * h <= kMaxCellsPerEntry;
+}
+
+void SlotTracker::gridInsert(Grid& grid, const Bounds& b, uint32_t value) {
+    int64_t x0, y0, x1, y1;
+    if (!gridRange(b, x0, y0, x1, y1)) return;
+    for (int64_t y = y0; y <= y1; ++y) {
+        for (int64_t x = x0; x <= x1; ++x) grid[cellKey(x, y)].push_back(value);
+    }
+}
+
+void SlotTracker::gridRemove(Grid& grid, const Bounds& b, uint32_t value) {
+    int64_t x0, y0, x1, y1;
+    if (!gridRange(b, x0, y0, x1, y1)) return;
+    for (int64_t y = y0; y <= y1; ++y) {
+        for (int64_t x = x0; x <= x1; ++x) {
+            auto it = grid.find(cellKey(x, y));
+            if (it == grid.end()) continue;
+            std::vector<uint32_t>& cell = it->second;
+            auto pos = std::find(cell.begin(), cell.end(), value);
+            if (pos != cell.end()) {
+                *pos = cell.back();
+                cell.pop_back();
+            }
+            if (cell.empty()) grid.erase(it);
+        }
+    }
+}
+
+// --- 障碍物增量 ---
+
+void SlotTracker::unindexObstacle(uint32_t handle) {
+    Obstacle& o = obstacles_[handle];
+    if (o.placement == kGridded) {
+        gridRemove(obstacleGrid_, o.bounds, handle);
+    } else if (o.placement == kUnindexed) {
+        unindexedObstacles_.erase(std::find(unindexedObstacles_.begin(), unindexedObstacles_.end(), handle));
+    }
+    o.placement = kInert;
+}
+
+void SlotTracker::markTouched(uint32_t segment, uint32_t handle) {
+    if (!isDirty_[segment]) {
+        isDirty_[segment] = 1;
+        dirty_.push_back(segment);
+    }
+    if (!needsRescan_[segment]) touched_.push_back(std::make_pair(segment, handle));
+}
+
+void SlotTracker::markFull(uint32_t segment) {
+    if (!isDirty_[segment]) {
+        isDirty_[segment] = 1;
+        dirty_.push_back(segment);
+    }
+    needsRescan_[segment] = 1;
+}
+
+// 包围盒与障碍物相交的探测带记为 (线段, 障碍物) 待重算；退化探测带与非有限障碍物改为整体重扫
+void SlotTracker::markAffected(uint32_t handle) {
+    const Obstacle& o = obstacles_[handle];
+    if (o.placement == kInert) return;
+    if (o.placement == kUnindexed) {
+        for (size_t i = 0; i < segments_.size(); ++i) markFull((uint32_t)i);
+        return;
+    }
+    for (uint32_t seg : unindexedBands_) markFull(seg);
+    int64_t x0, y0, x1, y1;
+    if (!gridRange(o.bounds, x0, y0, x1, y1)) return;
+    for (int64_t y = y0; y <= y1; ++y) {
+        for (int64_t x = x0; x <= x1; ++x) {
+            auto it = bandGrid_.find(cellKey(x, y));
+            if (it == bandGrid_.end()) continue;
+            for (uint32_t seg : it->second) {
+                if (overlaps(bands_[seg].box, o.bounds)) markTouched(seg, handle);
+            }
+        }
+    }
+}
+
+bool SlotTracker::place(uint64_t id, bool adding, const double* xs, const double* ys, size_t vertices, size_t stride) {
+    auto it = byId_.find(id);
+    uint32_t handle;
+    if (adding) {
+        if (it != byId_.end()) return fail("obstacle " + std::to_string(id) + " already exists");
+        if (!freeObstacles_.empty()) {
+            handle = freeObstacles_.back();
+            freeObstacles_.pop_back();
+        } else {
+            handle = (uint32_t)obstacles_.size();
+            obstacles_.emplace_back();
+            obstacleStamp_.push_back(0);
+        }
+        byId_[id] = handle;
+    } else {
+        if (it == byId_.end()) return fail("obstacle " + std::to_string(id) + " does not exist");
+        handle = it->second;
+        // 旧位置影响到的线段与新位置影响到的线段都要重算
+        markAffected(handle);
+        unindexObstacle(handle);
+    }
+
+    Obstacle& o = obstacles_[handle];
+    o.xs.resize(vertices);
+    o.ys.resize(vertices);
+    for (size_t i = 0; i < vertices; ++i) {
+        o.xs[i] = xs[i * stride];
+        o.ys[i] = ys[i * stride];
+    }
+    const uint32_t offsets[2] = {0, (uint32_t)vertices};
+    computePolygonBounds(o.xs.data(), o.ys.data(), offsets, 1, &o.bounds);
+    o.live = true;
+    int64_t x0, y0, x1, y1;
+    if (vertices == 0) {
+        o.placement = kInert;
+    } else if (gridRange(o.bounds, x0, y0, x1, y1)) {
+        o.placement = kGridded;
+        gridInsert(obstacleGrid_, o.bounds, handle);
+    } else {
+        o.placement = kUnindexed;
+        unindexedObstacles_.push_back(handle);
+    }
+    markAffected(handle);
+    ++pendingStats_.obstacleChanges;
+    return true;
+}
+
+bool SlotTracker::addObstacle(uint64_t id, const std::vector<Vec2>& polygon) {
+    return place(id, true, polygon.empty() ? nullptr : &polygon[0].x, polygon.empty() ? nullptr : &polygon[0].y,
+                 polygon.size(), 2);
+}
+
+bool SlotTracker::moveObstacle(uint64_t id, const std::vector<Vec2>& polygon) {
+    return place(id, false, polygon.empty() ? nullptr : &polygon[0].x, polygon.empty() ? nullptr : &polygon[0].y,
+                 polygon.size(), 2);
+}
+
+bool SlotTracker::addObstacle(uint64_t id, const double* xs, const double* ys, size_t vertices) {
+    return place(id, true, xs, ys, vertices, 1);
+}
+
+bool SlotTracker::moveObstacle(uint64_t id, const double* xs, const double* ys, size_t vertices) {
+    return place(id, false, xs, ys, vertices, 1);
+}
+
+bool SlotTracker::removeObstacle(uint64_t id) {
+    auto it = byId_.find(id);
+    if (it == byId_.end()) return fail("obstacle " + std::to_string(id) + " does not exist");
+    const uint32_t handle = it->second;
+    Obstacle& o = obstacles_[handle];
+    markAffected(handle);
+    unindexObstacle(handle);
+    o.live = false;
+    o.xs.clear();
+    o.ys.clear();
+    freeObstacles_.push_back(handle);
+    byId_.erase(it);
+    ++pendingStats_.obstacleChanges;
+    return true;
+}
+
+// --- 重算与平滑 ---
+
+// 单个多边形对线段的贡献；各多边形的最大值再取最大，与整体扫描逐位一致
+double SlotTracker::contribution(uint32_t segment, uint32_t handle) const {
+    const Obstacle& o = obstacles_[handle];
+    if (!o.live || o.placement == kInert) return 0.0;
+    const Band& band = bands_[segment];
+    if (band.indexed && o.placement == kGridded && !overlaps(o.bounds, band.box)) return 0.0;
+    const uint32_t offsets[2] = {0, (uint32_t)o.xs.size()};
+    ObstacleView view;
+    view.xs = o.xs.data();
+    view.ys = o.ys.data();
+    view.offsets = offsets;
+    view.bounds = &o.bounds;
+    view.polygons = 1;
+    view.vertices = o.xs.size();
+    return calculateSegmentShiftSoA(segments_[segment], view, config_.margin, config_.detectionRange);
+}
+
+// 丢掉缓存，对探测带附近 (退化探测带则为全部) 的障碍物逐个重算贡献
+void SlotTracker::rescan(uint32_t segment) {
+    std::vector<Contribution>& list = contributions_[segment];
+    list.clear();
+    const Band& band = bands_[segment];
+    if (band.empty) return;
+    if (++stamp_ == 0) {
+        std::fill(obstacleStamp_.begin(), obstacleStamp_.end(), 0u);
+        stamp_ = 1;
+    }
+    auto scan = [&](uint32_t handle) {
+        if (obstacleStamp_[handle] == stamp_) return;
+        obstacleStamp_[handle] = stamp_;
+        if (!obstacles_[handle].live) return;
+        const double r = contribution(segment, handle);
+        ++pendingStats_.obstaclesScanned;
+        if (r > 0.0) list.push_back({handle, r});
+    };
+
+    if (!band.indexed) {
+        for (size_t h = 0; h < obstacles_.size(); ++h) scan((uint32_t)h);
+        return;
+    }
+    for (uint32_t h : unindexedObstacles_) scan(h);
+    int64_t x0, y0, x1, y1;
+    if (!gridRange(band.box, x0, y0, x1, y1)) return;
+    for (int64_t y = y0; y <= y1; ++y) {
+        for (int64_t x = x0; x <= x1; ++x) {
+            auto it = obstacleGrid_.find(cellKey(x, y));
+            if (it == obstacleGrid_.end()) continue;
+            for (uint32_t h : it->second) scan(h);
+        }
+    }
+}
+
+void SlotTracker::update() {
+    changed_.clear();
+
+    // 逐项更新变化障碍物的贡献，同一 (线段, 障碍物) 只算一次
+    std::sort(touched_.begin(), touched_.end());
+    touched_.erase(std::unique(touched_.begin(), touched_.end()), touched_.end());
+    uint64_t refreshed = 0; // 本帧新算出的非零贡献
+    for (const std::pair<uint32_t, uint32_t>& t : touched_) {
+        const uint32_t seg = t.first, handle = t.second;
+        if (needsRescan_[seg] || bands_[seg].empty) continue;
+        const double r = contribution(seg, handle);
+        ++pendingStats_.obstaclesScanned;
+        std::vector<Contribution>& list = contributions_[seg];
+        size_t k = 0;
+        while (k < list.size() && list[k].obstacle != handle) ++k;
+        if (r > 0.0) {
+            ++refreshed;
+            if (k == list.size()) list.push_back({handle, r});
+            else list[k].shift = r;
+        } else if (k < list.size()) {
+            list[k] = list.back();
+            list.pop_back();
+        }
+    }
+    touched_.clear();
+
+    uint64_t read = 0;
+    for (uint32_t seg : dirty_) {
+        isDirty_[seg] = 0;
+        if (needsRescan_[seg]) {
+            needsRescan_[seg] = 0;
+            rescan(seg);
+            refreshed += contributions_[seg].size();
+        }
+        double t = 0.0;
+        for (const Contribution& c : contributions_[seg]) t = c.shift > t ? c.shift : t;
+        read += contributions_[seg].size();
+        ++pendingStats_.segmentsRecomputed;
+        if (t != targets_[seg]) {
+            targets_[seg] = t;
+            changed_.push_back(seg);
+            if (!isActive_[seg]) {
+                isActive_[seg] = 1;
+                active_.push_back(seg);
+            }
+        }
+    }
+    dirty_.clear();
+    // 取最大值时读到的缓存项里包含刚重算的，扣掉后才是真正复用的部分
+    pendingStats_.contributionsReused += read - std::min(read, refreshed);
+
+    // 平滑插值 (Lerp)：与可视化程序相同，每个输入帧一次
+    size_t kept = 0;
+    for (uint32_t seg : active_) {
+        double& c = currents_[seg];
+        const double t = targets_[seg];
+        c += (t - c) * config_.smoothing;
+        if (std::fabs(t - c) <= config_.settleEpsilon) {
+            c = t;
+            isActive_[seg] = 0;
+        } else {
+            active_[kept++] = seg;
+        }
+    }
+    pendingStats_.segmentsSmoothed += active_.size();
+    active_.resize(kept);
+
+    lastStats_ = pendingStats_;
+    pendingStats_ = SlotTrackerStats();
+}
@@ -0,0 +1,135 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "slot_shift.h"
+
+// --- 增量车位追踪 ---
+// 规划模块在多帧之间持有成千上万条车位线，但每帧通常只有少数障碍物移动。
+// SlotTracker 持有车位线段、目标推移量与平滑后的当前推移量；调用方逐个报告障碍物的增加 / 移动 / 删除，
+// update() 只重算探测带与变化障碍物 (新旧包围盒) 相交的线段，每帧开销取决于变化量而不是停车场规模。
+//
+// 两个均匀网格做空间索引：一个登记每条线段探测带的包围盒 (线段不变，建一次)，找出受某个障碍物影响的线段；
+// 另一个登记障碍物包围盒，需要整体重扫一条线段时只取探测带附近的障碍物。
+// 每条线段缓存各障碍物对它的贡献 (该多边形单独调用 calculateSegmentShiftSoA 的结果，只记非零项)：
+// 障碍物变化时只对它重跑内核，其余障碍物的贡献原样复用；目标推移量是贡献的最大值，与在整个世界上运行参考实现逐位一致。
+// 探测带退化 (零长度线段、推移方向为零或与线段平行) 或坐标非有限的线段 / 障碍物不进网格，
+// 前者每次都重算且扫描全部障碍物，后者参与每条线段的重算；正常场景里没有这类对象。
+//
+// 平滑沿用可视化程序的 Lerp：每次 update() 对尚未收敛的线段执行 current += (target - current) * smoothing，
+// 差值不超过 settleEpsilon 时直接取 target 并移出活动集合，静止的线段不再产生开销。
+struct SlotTrackerConfig {
+    double margin = 3.0;
+    double detectionRange = 10.0;
+    double smoothing = 0.15;
+    double settleEpsilon = 1e-4;
+    double cellSize = 0.0; // 网格边长，0 表示按探测带包围盒尺寸的中位数自动选取
+};
+
+struct SlotTrackerStats {
+    uint64_t obstacleChanges = 0;    // 上次 update() 以来报告的增加 / 移动 / 删除
+    uint64_t segmentsRecomputed = 0; // 重算目标推移量的线段
+    uint64_t obstaclesScanned = 0;   // 重算时实际调用内核的障碍物次数
+    uint64_t contributionsReused = 0; // 重算时直接复用的缓存贡献
+    uint64_t segmentsSmoothed = 0;   // 执行了平滑的线段 (活动集合大小)
+};
+
+class SlotTracker {
+public:
+    // 接管线段并建立探测带索引，清空全部障碍物；配置不合法时返回 false
+    bool reset(const std::vector<Segment>& segments, const SlotTrackerConfig& config);
+
+    // id 由调用方分配。add 时 id 已存在、move / remove 时 id 不存在均返回 false
+    bool addObstacle(uint64_t id, const std::vector<Vec2>& polygon);
+    bool moveObstacle(uint64_t id, const std::vector<Vec2>& polygon);
+    bool removeObstacle(uint64_t id);
+    // SoA 形式的顶点，省去调用方组装 std::vector<Vec2>
+    bool addObstacle(uint64_t id, const double* xs, const double* ys, size_t vertices);
+    bool moveObstacle(uint64_t id, const double* xs, const double* ys, size_t vertices);
+    bool hasObstacle(uint64_t id) const { return byId_.count(id) != 0; }
+
+    // 一个输入帧：重算受影响线段的目标推移量，再对活动线段做一次平滑
+    void update();
+
+    size_t segmentCount() const { return segments_.size(); }
+    size_t obstacleCount() const { return byId_.size(); }
+    const std::vector<Segment>& segments() const { return segments_; }
+    const std::vector<double>& targets() const { return targets_; }
+    const std::vector<double>& currents() const { return currents_; }
+    // 上次 update() 中目标推移量发生变化的线段 (无序)
+    const std::vector<uint32_t>& changedSegments() const { return changed_; }
+    const SlotTrackerStats& lastStats() const { return lastStats_; }
+    double cellSize() const { return cellSize_; }
+    const std::string& error() const { return error_; }
+
+private:
+    enum Placement : uint8_t {
+        kInert,     // 空多边形，不影响任何线段
+        kGridded,   // 登记在障碍物网格里
+        kUnindexed, // 坐标非有限或覆盖的格子过多，参与每条线段的重算
+    };
+    struct Obstacle {
+        std::vector<double> xs, ys;
+        Bounds bounds;
+        Placement placement = kInert;
+        bool live = false;
+    };
+    struct Band {
+        Bounds box;           // 探测带的包围盒，已外扩浮点误差余量
+        bool empty = false;   // 探测带为空，目标推移量恒为 0
+        bool indexed = false; // false 且非空表示探测带退化，需要扫描全部障碍物
+    };
+    struct Contribution {
+        uint32_t obstacle; // 障碍物句柄
+        double shift;
+    };
+    typedef std::unordered_map<uint64_t, std::vector<uint32_t>> Grid;
+
+    bool fail(const std::string& message);
+    bool gridRange(const Bounds& b, int64_t& x0, int64_t& y0, int64_t& x1, int64_t& y1) const;
+    void gridInsert(Grid& grid, const Bounds& b, uint32_t value);
+    void gridRemove(Grid& grid, const Bounds& b, uint32_t value);
+    void markAffected(uint32_t handle);
+    void markTouched(uint32_t segment, uint32_t handle);
+    void markFull(uint32_t segment);
+    // stride 为相邻顶点在 xs / ys 中的间隔 (SoA 为 1，Vec2 数组为 2)
+    bool place(uint64_t id, bool adding, const double* xs, const double* ys, size_t vertices, size_t stride);
+    void unindexObstacle(uint32_t handle);
+    double contribution(uint32_t segment, uint32_t handle) const;
+    void rescan(uint32_t segment);
+
+    SlotTrackerConfig config_;
+    double cellSize_ = 1.0;
+    std::vector<Segment> segments_;
+    std::vector<Band> bands_;
+    std::vector<uint32_t> unindexedBands_; // 退化探测带
+    Grid bandGrid_;
+
+    std::vector<Obstacle> obstacles_;
+    std::vector<uint32_t> freeObstacles_;
+    std::unordered_map<uint64_t, uint32_t> byId_;
+    std::vector<uint32_t> unindexedObstacles_;
+    Grid obstacleGrid_;
+
+    std::vector<double> targets_;
+    std::vector<double> currents_;
+    std::vector<std::vector<Contribution>> contributions_;
+    std::vector<uint32_t> dirty_;
+    std::vector<uint8_t> isDirty_;
+    std::vector<uint8_t> needsRescan_; // 需要整体重扫 (退化探测带或非有限障碍物)，不走逐障碍物更新
+    std::vector<std::pair<uint32_t, uint32_t>> touched_; // (线段, 障碍物句柄)：需要重算这一项贡献
+    std::vector<uint32_t> active_;
+    std::vector<uint8_t> isActive_;
+    std::vector<uint32_t> changed_;
+    std::vector<uint32_t> obstacleStamp_; // 重扫时对网格查询结果去重
+    uint32_t stamp_ = 0;
+
+    SlotTrackerStats pendingStats_;
+    SlotTrackerStats lastStats_;
+    std::string error_;
+};
@@ -0,0 +1,93 @@
+#include "slotshift_c.h"
+
+#include <cstddef>
+#include <type_traits>
+
+#include "slot_shift.h"
+
+// C 结构体直接按 C++ 类型解释，调用时零拷贝
+static_assert(sizeof(slotshift_segment) == sizeof(Segment), "slotshift_segment must match Segment");
+static_assert(offsetof(Segment, start) == offsetof(slotshift_segment, start_x) &&
+                  offsetof(Segment, end) == offsetof(slotshift_segment, end_x) &&
+                  offsetof(Segment, heading) == offsetof(slotshift_segment, heading_x),
+              "slotshift_segment field offsets must match Segment");
+static_assert(sizeof(slotshift_bounds) == sizeof(Bounds) && offsetof(Bounds, maxY) == offsetof(slotshift_bounds, max_y),
+              "slotshift_bounds must match Bounds");
+static_assert(std::is_standard_layout<Segment>::value && std::is_standard_layout<Bounds>::value,
+              "Segment and Bounds must be standard layout");
+
+namespace {
+
+bool toView(const slotshift_obstacles* o, ObstacleView& view) {
+    if (!o) return false;
+    if (o->polygon_count > 0 && (!o->xs || !o->ys || !o->offsets || !o->bounds)) return false;
+    if (o->polygon_count > 0 && o->offsets[o->polygon_count] != o->vertex_count) return false;
+    view.xs = o->xs;
+    view.ys = o->ys;
+    view.offsets = o->offsets;
+    view.bounds = reinterpret_cast<const Bounds*>(o->bounds);
+    view.polygons = o->polygon_count;
+    view.vertices = o->vertex_count;
+    return true;
+}
+
+const Segment* toSegments(const slotshift_segment* s) { return reinterpret_cast<const Segment*>(s); }
+
+} // namespace
+
+extern "C" {
+
+int slotshift_abi_version(void) { return SLOTSHIFT_ABI_VERSION; }
+
+const char* slotshift_status_string(int status) {
+    switch (status) {
+    case SLOTSHIFT_OK: return "ok";
+    case SLOTSHIFT_E_INVALID_ARGUMENT: return "invalid argument";
+    case SLOTSHIFT_E_INTERNAL: return "internal error";
+    default: return "unknown status";
+    }
+}
+
+int slotshift_compute_bounds(const double* xs, const double* ys, const uint32_t* offsets, size_t polygon_count,
+                             slotshift_bounds* out_bounds) {
+    if (polygon_count == 0) return SLOTSHIFT_OK;
+    if (!xs || !ys || !offsets || !out_bounds) return SLOTSHIFT_E_INVALID_ARGUMENT;
+    computePolygonBounds(xs, ys, offsets, polygon_count, reinterpret_cast<Bounds*>(out_bounds));
+    return SLOTSHIFT_OK;
+}
+
+int slotshift_shift(const slotshift_segment* segment, const slotshift_obstacles* obstacles, double margin,
+                    double detection_range, double* out) {
+    ObstacleView view;
+    if (!segment || !out || !toView(obstacles, view)) return SLOTSHIFT_E_INVALID_ARGUMENT;
+    *out = calculateSegmentShiftSoA(*toSegments(segment), view, margin, detection_range);
+    return SLOTSHIFT_OK;
+}
+
+int slotshift_shift_batch(const slotshift_segment* segments, size_t count, const slotshift_obstacles* obstacles,
+                          double margin, double detection_range, double* out) {
+    ObstacleView view;
+    if (!toView(obstacles, view)) return SLOTSHIFT_E_INVALID_ARGUMENT;
+    if (count == 0) return SLOTSHIFT_OK;
+    if (!segments || !out) return SLOTSHIFT_E_INVALID_ARGUMENT;
+    calculateSegmentShiftBatch(toSegments(segments), count, view, margin, detection_range, out);
+    return SLOTSHIFT_OK;
+}
+
+int slotshift_shift_batch_parallel(const slotshift_segment* segments, size_t count,
+                                   const slotshift_obstacles* obstacles, double margin, double detection_range,
+                                   double* out, unsigned threads) {
+    ObstacleView view;
+    if (!toView(obstacles, view)) return SLOTSHIFT_E_INVALID_ARGUMENT;
+    if (count == 0) return SLOTSHIFT_OK;
+    if (!segments || !out) return SLOTSHIFT_E_INVALID_ARGUMENT;
+    // 线程建不出来时内核自己退回调用线程；其余异常 (如 std::bad_alloc) 不能穿过 C 边界
+    try {
+        calculateSegmentShiftBatchParallel(toSegments(segments), count, view, margin, detection_range, out, threads);
+    } catch (...) {
+        return SLOTSHIFT_E_INTERNAL;
+    }
+    return SLOTSHIFT_OK;
+}
+
+} // extern "C"
@@ -0,0 +1,81 @@
+#ifndef SLOTSHIFT_C_H
+#define SLOTSHIFT_C_H
+
+/* --- 稳定的 C 接口 ---
+ * 供 C 程序与其他语言 (FFI) 调用。所有数组都由调用方持有：坐标以 SoA 形式传入，结果写进调用方给的输出缓冲，
+ * 库内不拷贝输入、不分配内存 (slotshift_shift_batch_parallel 创建工作线程除外)。
+ * 批量接口一次调用处理任意多条线段，跨语言边界的固定开销只付一次。
+ * 结构体布局与 C++ 侧的 Segment / Bounds 逐字节相同，按 SLOTSHIFT_ABI_VERSION 保持兼容：
+ * 只会追加新函数，已有结构体与函数签名不变。
+ */
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#if defined(_WIN32)
+#define SLOTSHIFT_C_API __declspec(dllexport)
+#elif defined(__GNUC__)
+#define SLOTSHIFT_C_API __attribute__((visibility("default")))
+#else
+#define SLOTSHIFT_C_API
+#endif
+
+#define SLOTSHIFT_ABI_VERSION 1
+
+/* 返回码 */
+#define SLOTSHIFT_OK 0
+#define SLOTSHIFT_E_INVALID_ARGUMENT (-1) /* 空指针，或 offsets[polygon_count] != vertex_count */
+#define SLOTSHIFT_E_INTERNAL (-2)         /* 例如内存分配失败 (无法创建工作线程时在调用线程上算完，不算错误) */
+
+/* 车位线段：start -> end，heading 为推离方向 (单位向量) */
+typedef struct slotshift_segment {
+    double start_x, start_y;
+    double end_x, end_y;
+    double heading_x, heading_y;
+} slotshift_segment;
+
+typedef struct slotshift_bounds {
+    double min_x, min_y, max_x, max_y;
+} slotshift_bounds;
+
+/* 障碍物 (SoA)：第 p 个多边形的顶点为 xs / ys 的 [offsets[p], offsets[p + 1])。
+ * bounds 为每个多边形的包围盒，内核用它整体剔除；可以用 slotshift_compute_bounds 算好后长期复用。 */
+typedef struct slotshift_obstacles {
+    const double* xs;
+    const double* ys;
+    const uint32_t* offsets; /* polygon_count + 1 个，offsets[0] 通常为 0 */
+    const slotshift_bounds* bounds;
+    size_t polygon_count;
+    size_t vertex_count;
+} slotshift_obstacles;
+
+SLOTSHIFT_C_API int slotshift_abi_version(void);
+SLOTSHIFT_C_API const char* slotshift_status_string(int status);
+
+/* 按 offsets 把每个多边形的包围盒写进 out_bounds (polygon_count 个) */
+SLOTSHIFT_C_API int slotshift_compute_bounds(const double* xs, const double* ys, const uint32_t* offsets,
+                                             size_t polygon_count, slotshift_bounds* out_bounds);
+
+/* 单条线段的推移量，写进 *out */
+SLOTSHIFT_C_API int slotshift_shift(const slotshift_segment* segment, const slotshift_obstacles* obstacles,
+                                    double margin, double detection_range, double* out);
+
+/* count 条线段的推移量写进 out[0, count)，结果与逐条调用逐位一致 */
+SLOTSHIFT_C_API int slotshift_shift_batch(const slotshift_segment* segments, size_t count,
+                                          const slotshift_obstacles* obstacles, double margin,
+                                          double detection_range, double* out);
+
+/* 多线程版本：threads 为 0 时取硬件并发数，批量太小时退化为单线程；结果与单线程一致 */
+SLOTSHIFT_C_API int slotshift_shift_batch_parallel(const slotshift_segment* segments, size_t count,
+                                                   const slotshift_obstacles* obstacles, double margin,
+                                                   double detection_range, double* out, unsigned threads);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* SLOTSHIFT_C_H */
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// --- 单生产者 / 单消费者环形队列 ---
+// 容量向上取 2 的幂。生产者只写 tail_，消费者只写 head_，二者各占一条缓存行；
+// 双方各自缓存对方的下标，只在看起来满 / 空时才去读对方的原子变量，减少缓存行来回。
+// 元素按值搬运，T 需要可默认构造、可移动赋值。
+template <typename T>
+class SpscRing {
+public:
+    explicit SpscRing(size_t capacity) : slots_(roundUp(capacity)), mask_(slots_.size() - 1) {}
+    SpscRing(const SpscRing&) = delete;
+    SpscRing& operator=(const SpscRing&) = delete;
+
+    // 仅生产者线程调用；队列满时返回 false，value 不被移走
+    bool tryPush(T&& value) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == slots_.size()) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == slots_.size()) return false;
+        }
+        slots_[tail & mask_] = std::move(value);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 仅消费者线程调用；队列空时返回 false
+    bool tryPop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) return false;
+        }
+        out = std::move(slots_[head & mask_]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 任意线程可读的近似深度，供性能面板显示
+    size_t size() const {
+        const size_t head = head_.load(std::memory_order_acquire);
+        const size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+    size_t capacity() const { return slots_.size(); }
+
+private:
+    static size_t roundUp(size_t n) {
+        size_t c = 2;
+        while (c < n) c <<= 1;
+        return c;
+    }
+
+    std::vector<T> slots_;
+    const size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0}; // 消费者写
+    size_t tailCache_ = 0;                    // 消费者私有
+    alignas(64) std::atomic<size_t> tail_{0}; // 生产者写
+    size_t headCache_ = 0;                    // 生产者私有
+};
+
+// 队列空 / 满时的退避：先自旋，再让出时间片，最后短暂休眠，避免空转占满一个核
+class SpinBackoff {
+public:
+    void pause() {
+        if (spins_ < 64) {
+            ++spins_;
+        } else if (spins_ < 128) {
+            ++spins_;
+            std::this_thread::yield();
+        } else {
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+    }
+    void reset() { spins_ = 0; }
+
+private:
+    unsigned spins_ = 0;
+};
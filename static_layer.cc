@@ -0,0 +1,36 @@
+#include "static_layer.h"
+
+bool StaticLayer::update(int width, int height, uint64_t key, Color background,
+                         const std::function<void()>& drawFn) {
+    const bool resized = !loaded_ || target_.texture.width != width || target_.texture.height != height;
+    if (!resized && valid_ && key == key_) return false;
+    if (resized) {
+        unload();
+        target_ = LoadRenderTexture(width, height);
+        loaded_ = true;
+    }
+    BeginTextureMode(target_);
+    ClearBackground(background);
+    drawFn();
+    EndTextureMode();
+    key_ = key;
+    valid_ = true;
+    ++redraws_;
+    return true;
+}
+
+void StaticLayer::draw() const {
+    if (!loaded_ || !valid_) return;
+    // RenderTexture 的纹理坐标 y 轴朝上，源矩形取负高度翻转回屏幕方向
+    const Rectangle source = {0.0f, 0.0f, (float)target_.texture.width, -(float)target_.texture.height};
+    DrawTextureRec(target_.texture, source, {0.0f, 0.0f}, WHITE);
+}
+
+void StaticLayer::unload() {
+    if (loaded_) {
+        UnloadRenderTexture(target_);
+        loaded_ = false;
+    }
+    target_ = RenderTexture2D();
+    valid_ = false;
+}
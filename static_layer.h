@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <functional>
+
+#include "raylib.h"
+
+// --- 静态图层缓存 (可视化程序用) ---
+// 不随帧变化的内容 (背景、静态障碍物、探测带等) 只画一次到离屏 RenderTexture2D，之后每帧整张贴回屏幕。
+// 图层内容由调用方给出的 key 标识：地图、视图变换或窗口尺寸任一变化都应当改变 key，此时才重画。
+// 纹理清成不透明背景色，贴回时直接覆盖整个画面，半透明的内容在纹理里已经混合好，不会二次混合。
+// 需要在 InitWindow 之后使用，并在 CloseWindow 之前 unload()。
+class StaticLayer {
+public:
+    StaticLayer() = default;
+    ~StaticLayer() { unload(); }
+    StaticLayer(const StaticLayer&) = delete;
+    StaticLayer& operator=(const StaticLayer&) = delete;
+
+    // key 与尺寸都没变时什么也不做；否则 (必要时重建纹理) 清成 background 后调用 drawFn 重画，返回 true
+    bool update(int width, int height, uint64_t key, Color background, const std::function<void()>& drawFn);
+    // 把缓存的图层画到 (0, 0)，应在 BeginDrawing 之后最先调用
+    void draw() const;
+
+    void invalidate() { valid_ = false; }
+    void unload();
+
+    uint64_t redraws() const { return redraws_; }
+
+    // 把影响图层内容的参数逐个混进 key
+    static uint64_t mixKey(uint64_t h, uint64_t v) {
+        h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+        return h;
+    }
+    static uint64_t mixKey(uint64_t h, double v) {
+        uint64_t bits;
+        std::memcpy(&bits, &v, sizeof(bits));
+        return mixKey(h, bits);
+    }
+
+private:
+    RenderTexture2D target_ = {};
+    bool loaded_ = false;
+    bool valid_ = false;
+    uint64_t key_ = 0;
+    uint64_t redraws_ = 0;
+};
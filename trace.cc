@@ -0,0 +1,186 @@
+#include "trace.h"
+
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace trace_detail {
+std::atomic<bool> g_enabled(false);
+} // namespace trace_detail
+
+namespace {
+
+struct Event {
+    const char* name;
+    uint64_t startTicks;
+    uint64_t endTicks;
+    uint32_t tid;
+};
+
+// 每个线程的缓冲区按块增长，块指针表定长，写满后丢弃新事件而不是覆盖旧事件
+const size_t kChunkEvents = 4096;
+const size_t kMaxChunks = 256; // 每个缓冲区最多约 100 万个事件
+
+// 单写者：同一时刻只属于一个线程。count 以 release 发布，导出线程 acquire 后读取 [0, count)
+struct ThreadBuffer {
+    Event* chunks[kMaxChunks] = {};
+    std::atomic<size_t> count{0};
+};
+
+struct Registry {
+    std::mutex mu;
+    std::vector<ThreadBuffer*> buffers;  // 所有创建过的缓冲区，进程内不释放
+    std::vector<ThreadBuffer*> freeList; // 线程退出后归还，供新线程复用，缓冲区数量不超过并发线程数
+    std::map<uint32_t, std::string> names;
+    std::atomic<uint32_t> nextTid{1};
+    std::atomic<uint64_t> dropped{0};
+    // 时间基准：开启追踪时记下一对 (ticks, ns)，导出时再取一对，线性换算
+    uint64_t epochTicks = 0;
+    uint64_t epochNs = 0;
+};
+
+// 故意不析构：线程在静态析构之后退出时仍可能归还缓冲区
+Registry& registry() {
+    static Registry* r = new Registry();
+    return *r;
+}
+
+struct ThreadSlot {
+    ThreadBuffer* buf = nullptr;
+    uint32_t tid = 0;
+    ~ThreadSlot() {
+        if (!buf) return;
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mu);
+        r.freeList.push_back(buf);
+    }
+};
+
+thread_local ThreadSlot t_slot;
+
+uint32_t currentTid() {
+    if (t_slot.tid == 0) t_slot.tid = registry().nextTid.fetch_add(1);
+    return t_slot.tid;
+}
+
+ThreadBuffer* acquireBuffer() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    if (!r.freeList.empty()) {
+        ThreadBuffer* b = r.freeList.back();
+        r.freeList.pop_back();
+        return b;
+    }
+    r.buffers.push_back(new ThreadBuffer());
+    return r.buffers.back();
+}
+
+void writeJsonString(FILE* f, const char* s) {
+    std::fputc('"', f);
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\') std::fputc('\\', f);
+        if ((unsigned char)*s >= 0x20) std::fputc(*s, f);
+    }
+    std::fputc('"', f);
+}
+
+} // namespace
+
+void trace_detail::record(const char* name, uint64_t startTicks, uint64_t endTicks) {
+    ThreadSlot& slot = t_slot;
+    if (!slot.buf) slot.buf = acquireBuffer();
+    ThreadBuffer* b = slot.buf;
+
+    size_t n = b->count.load(std::memory_order_relaxed);
+    size_t c = n / kChunkEvents;
+    if (c >= kMaxChunks) {
+        registry().dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    if (!b->chunks[c]) b->chunks[c] = new Event[kChunkEvents];
+    b->chunks[c][n % kChunkEvents] = {name, startTicks, endTicks, currentTid()};
+    b->count.store(n + 1, std::memory_order_release);
+}
+
+void traceEnable(bool on) {
+    if (on) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.mu);
+        if (r.epochNs == 0) {
+            r.epochTicks = trace_detail::nowTicks();
+            r.epochNs = trace_detail::nowNs();
+        }
+    }
+    trace_detail::g_enabled.store(on, std::memory_order_relaxed);
+}
+
+bool traceEnabled() { return trace_detail::g_enabled.load(std::memory_order_relaxed); }
+
+void traceSetThreadName(const char* name) {
+    uint32_t tid = currentTid();
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    r.names[tid] = name;
+}
+
+uint64_t traceDroppedEvents() { return registry().dropped.load(std::memory_order_relaxed); }
+
+void traceReset() {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.mu);
+    for (ThreadBuffer* b : r.buffers) {
+        for (Event*& chunk : b->chunks) {
+            delete[] chunk;
+            chunk = nullptr;
+        }
+        b->count.store(0, std::memory_order_relaxed);
+    }
+    r.dropped.store(0, std::memory_order_relaxed);
+    r.epochTicks = trace_detail::nowTicks();
+    r.epochNs = trace_detail::nowNs();
+}
+
+bool traceWriteChromeJson(const char* path) {
+    FILE* f = std::fopen(path, "w");
+    if (!f) return false;
+
+    Registry& r = registry();
+    std::vector<ThreadBuffer*> buffers;
+    std::map<uint32_t, std::string> names;
+    uint64_t epochTicks, epochNs;
+    {
+        std::lock_guard<std::mutex> lock(r.mu);
+        buffers = r.buffers;
+        names = r.names;
+        epochTicks = r.epochTicks;
+        epochNs = r.epochNs;
+    }
+    // 每 tick 对应的微秒数；间隔太短无法可靠测频时退化为 1 tick = 1 ns
+    uint64_t ticksNow = trace_detail::nowTicks();
+    uint64_t nsNow = trace_detail::nowNs();
+    double usPerTick = 1e-3;
+    if (nsNow > epochNs + 1000000 && ticksNow > epochTicks) usPerTick = (nsNow - epochNs) * 1e-3 / (ticksNow - epochTicks);
+
+    std::fprintf(f, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n");
+    std::fprintf(f, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"slotshift\"}}");
+    for (const auto& n : names) {
+        std::fprintf(f, ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":", n.first);
+        writeJsonString(f, n.second.c_str());
+        std::fprintf(f, "}}");
+    }
+    for (ThreadBuffer* b : buffers) {
+        size_t count = b->count.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; ++i) {
+            const Event& e = b->chunks[i / kChunkEvents][i % kChunkEvents];
+            if (e.startTicks < epochTicks) continue;
+            std::fprintf(f, ",\n{\"name\":");
+            writeJsonString(f, e.name);
+            std::fprintf(f, ",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}", e.tid,
+                         (e.startTicks - epochTicks) * usPerTick, (e.endTicks - e.startTicks) * usPerTick);
+        }
+    }
+    std::fprintf(f, "\n]}\n");
+    return std::fclose(f) == 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// --- 轻量级作用域追踪 ---
+// SLOTSHIFT_TRACE_SCOPE("name") 记录一个作用域的开始时间与时长，写入当前线程独占的缓冲区，
+// 写入路径无锁；traceWriteChromeJson() 导出 Chrome trace-event JSON，可直接用 chrome://tracing 或 Perfetto UI 打开。
+// 以 -DSLOTSHIFT_ENABLE_TRACE=0 编译时宏展开为空，运行时未调用 traceEnable(true) 时每个作用域只多一次原子读。
+#ifndef SLOTSHIFT_ENABLE_TRACE
+#define SLOTSHIFT_ENABLE_TRACE 1
+#endif
+
+void traceEnable(bool on);
+bool traceEnabled();
+// 给当前线程起名，导出时显示在线程轨道上
+void traceSetThreadName(const char* name);
+// 导出到 path，返回是否成功；导出期间其它线程可以继续记录，只导出调用时已完成的事件
+bool traceWriteChromeJson(const char* path);
+// 丢弃已记录的事件；调用时不能有其它线程正在记录
+void traceReset();
+// 缓冲区写满后丢弃的事件数
+uint64_t traceDroppedEvents();
+
+namespace trace_detail {
+
+extern std::atomic<bool> g_enabled;
+
+inline uint64_t nowNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+// 作用域内用的时间戳：x86 上直接读 TSC (比 steady_clock 便宜一半以上)，导出时再按实测频率换算成纳秒
+inline uint64_t nowTicks() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __rdtsc();
+#else
+    return nowNs();
+#endif
+}
+
+void record(const char* name, uint64_t startTicks, uint64_t endTicks);
+
+} // namespace trace_detail
+
+// name 必须是字符串字面量或生命周期覆盖导出时刻的字符串，缓冲区只保存指针
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char* name)
+        : name_(trace_detail::g_enabled.load(std::memory_order_relaxed) ? name : nullptr),
+          start_(name_ ? trace_detail::nowTicks() : 0) {}
+    ~ScopedTrace() {
+        if (name_) trace_detail::record(name_, start_, trace_detail::nowTicks());
+    }
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_;
+};
+
+#define SLOTSHIFT_TRACE_CONCAT_(a, b) a##b
+#define SLOTSHIFT_TRACE_CONCAT(a, b) SLOTSHIFT_TRACE_CONCAT_(a, b)
+#if SLOTSHIFT_ENABLE_TRACE
+#define SLOTSHIFT_TRACE_SCOPE(name) ScopedTrace SLOTSHIFT_TRACE_CONCAT(slotshiftTrace_, __LINE__)(name)
+#else
+#define SLOTSHIFT_TRACE_SCOPE(name) ((void)0)
+#endif